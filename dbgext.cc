@@ -8,6 +8,7 @@ _CrtMemState mem_old, mem_new, mem_diff;
 winrt::com_ptr<IDataModelManager> sp_data_model_manager;
 winrt::com_ptr<IDebugHost> sp_debug_host;
 winrt::com_ptr<IDebugControl5> sp_debug_control;
+winrt::com_ptr<IDebugClient> sp_debug_client;
 
 extern "C" {
 
@@ -17,7 +18,6 @@ __declspec(dllexport) HRESULT
   _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
   _CrtMemCheckpoint(&mem_old);
 
-  winrt::com_ptr<IDebugClient> sp_debug_client;
   winrt::com_ptr<IHostDataModelAccess> sp_data_model_access;
 
   HRESULT hr = DebugCreate(__uuidof(IDebugClient), sp_debug_client.put_void());
@@ -37,6 +37,7 @@ __declspec(dllexport) HRESULT
 __declspec(dllexport) void __stdcall DebugExtensionUninitialize() {
   _RPTF0(_CRT_WARN, "Entered DebugExtensionUninitialize\n");
   DestroyExtension();
+  sp_debug_client = nullptr;
   sp_debug_host = nullptr;
   sp_data_model_manager = nullptr;
 
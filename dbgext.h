@@ -16,6 +16,7 @@
 extern winrt::com_ptr<IDataModelManager> sp_data_model_manager;
 extern winrt::com_ptr<IDebugHost> sp_debug_host;
 extern winrt::com_ptr<IDebugControl5> sp_debug_control;
+extern winrt::com_ptr<IDebugClient> sp_debug_client;
 
 // To be implemented by the custom extension code. (Called on load).
 bool CreateExtension();
@@ -0,0 +1,7 @@
+#include "arena.h"
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bytes_allocated_ += bytes;
+  return resource_.allocate(bytes, alignment);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+
+// A monotonic allocator for data decoded while the target is stopped. Memory
+// is only returned when the whole arena is destroyed, so allocation is a
+// pointer bump and freeing thousands of decoded objects costs nothing. The
+// extension starts a new arena for each stop; objects decoded earlier keep
+// their arena alive through a shared_ptr until they are released.
+class Arena : public std::pmr::memory_resource {
+ public:
+  Arena() : resource_(kInitialBlockSize) {}
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Bytes handed out so far, not counting block overhead.
+  size_t bytes_allocated() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_allocated_;
+  }
+
+ private:
+  static constexpr size_t kInitialBlockSize = 64 * 1024;
+
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  // Memory is only given back when the arena is destroyed.
+  void do_deallocate(void*, size_t, size_t) override {}
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  // Objects are normally decoded on the debugger's thread, but nothing stops
+  // a data model call from arriving on another.
+  mutable std::mutex mutex_;
+  std::pmr::monotonic_buffer_resource resource_;
+  size_t bytes_allocated_ = 0;
+};
+
+using ArenaPtr = std::shared_ptr<Arena>;
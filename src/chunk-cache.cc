@@ -0,0 +1,40 @@
+#include "chunk-cache.h"
+#include <algorithm>
+
+namespace {
+
+constexpr size_t kFingerprintWords = 16;
+constexpr uint64_t kHashMultiplier = 0x9e3779b97f4a7c15;
+
+uint64_t Mix(uint64_t h, uint64_t word) {
+  h = ((h << 5) | (h >> 59)) ^ word;
+  return h * kHashMultiplier;
+}
+
+}  // namespace
+
+bool FingerprintChunk(const MemReader& reader, uint64_t start, uint64_t end,
+                      const ChunkCounters& counters, uint64_t* fingerprint) {
+  uint64_t h = Mix(Mix(end - start, counters.allocated_bytes),
+                   counters.high_water_mark);
+  h = Mix(Mix(h, counters.allocation_top), counters.allocation_limit);
+  // Words past the high water mark were never allocated, so only sample below
+  // it; the first word is always the map of the chunk's first object.
+  uint64_t top = end;
+  if (counters.high_water_mark > start && counters.high_water_mark < end) {
+    top = counters.high_water_mark;
+  }
+  uint64_t stride = ((top - start) / kFingerprintWords) & ~uint64_t{7};
+  for (size_t i = 0; i < kFingerprintWords; ++i) {
+    uint64_t address = start + i * stride;
+    if (address + sizeof(uint64_t) > top) break;
+    uint64_t word;
+    if (!reader(address, sizeof(word), reinterpret_cast<uint8_t*>(&word))) {
+      return false;
+    }
+    h = Mix(h, word);
+    if (stride == 0) break;
+  }
+  *fingerprint = h;
+  return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "mem-reader.h"
+
+// What a chunk's header says about how much of it has been allocated. Zero
+// where the chunk doesn't record it.
+struct ChunkCounters {
+  uint64_t allocated_bytes;
+  uint64_t high_water_mark;  // The address the highest allocation ended at.
+  // The space's linear allocation area, if it is in the chunk. Allocating in
+  // it only moves the top: the whole area was counted as allocated when it
+  // was set up, and the high water mark is only updated when it is closed.
+  uint64_t allocation_top;
+  uint64_t allocation_limit;
+};
+
+// A cheap stand-in for hashing the chunk at [start, end): its counters mixed
+// with a few words read at fixed spots spread over its allocated part, so
+// that it costs a handful of small reads however big the chunk is. Anything
+// that allocates in the chunk, sweeps it, or moves the objects at those spots
+// changes it; an object changed in place elsewhere does not, and a query
+// that must see such changes has to walk the chunk. Returns false if a
+// sampled word can't be read.
+bool FingerprintChunk(const MemReader& reader, uint64_t start, uint64_t end,
+                      const ChunkCounters& counters, uint64_t* fingerprint);
+
+// What walking each chunk found, kept across stops so that a query after the
+// target has run again only walks the chunks that are new or have changed.
+// Entries are keyed by the chunk's area and checked against its fingerprint,
+// so a chunk that was freed and reallocated at the same address is walked
+// again.
+template <typename T>
+class ChunkCache {
+ public:
+  // The result stored for the chunk at [start, end) if its fingerprint is
+  // still fingerprint, otherwise null.
+  const T* Find(uint64_t start, uint64_t end, uint64_t fingerprint) const {
+    auto it = entries_.find(start);
+    if (it == entries_.end() || it->second.end != end ||
+        it->second.fingerprint != fingerprint) {
+      return nullptr;
+    }
+    return &it->second.result;
+  }
+
+  void Store(uint64_t start, uint64_t end, uint64_t fingerprint, T result) {
+    entries_[start] = {end, fingerprint, std::move(result)};
+  }
+
+  // Drops the entries of chunks that are no longer in the heap, given the
+  // start of every chunk that is.
+  void Sweep(const std::vector<uint64_t>& chunk_starts) {
+    std::unordered_set<uint64_t> live(chunk_starts.begin(), chunk_starts.end());
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      it = live.count(it->first) == 0 ? entries_.erase(it) : std::next(it);
+    }
+  }
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    uint64_t end;
+    uint64_t fingerprint;
+    T result;
+  };
+
+  std::unordered_map<uint64_t, Entry> entries_;
+};
@@ -0,0 +1,382 @@
+#include "code-census.h"
+#include "object.h"
+#include "trace.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint64_t kDefaultCount = 20;
+constexpr int64_t kUnknownKind = -1;
+
+enum class ObjectKind {
+  kOther,
+  kJSFunction,
+  kSharedFunctionInfo,
+  kBytecodeArray,
+  kCode,
+};
+
+enum class Tier {
+  kUncompiled,
+  kInterpreted,
+  kBaseline,
+  kOptimized,
+};
+
+const wchar_t* GetTierName(Tier tier) {
+  switch (tier) {
+    case Tier::kInterpreted: return L"interpreted";
+    case Tier::kBaseline: return L"baseline";
+    case Tier::kOptimized: return L"optimized";
+    default: return L"uncompiled";
+  }
+}
+
+using KindNames = std::unordered_map<int64_t, std::wstring>;
+
+std::wstring GetKindName(const KindNames& kind_names, int64_t kind) {
+  if (kind == kUnknownKind) return L"unknown";
+  auto it = kind_names.find(kind);
+  return it != kind_names.end() ? it->second : L"kind " + std::to_wstring(kind);
+}
+
+struct CodeObject {
+  uint64_t size;
+  int64_t kind;
+};
+
+struct LargeCode {
+  uint64_t tagged_ptr;
+  uint64_t size;
+};
+
+struct FunctionCode {
+  uint64_t shared_function_info = 0;
+  uint64_t closures = 0;
+  uint64_t bytecode_bytes = 0;
+  uint64_t code_bytes = 0;
+  Tier tier = Tier::kUncompiled;  // The highest of any closure.
+  std::vector<uint64_t> codes;  // Counted in code_bytes.
+};
+
+// Collects everything in one pass, as objects turn up in heap order: a
+// closure's code or its function's bytecode may be visited before or after
+// the closure itself. They are joined up once the pass is done.
+class CodeCensus {
+ public:
+  CodeCensus(const MemReader& reader, size_t count)
+      : reader_(reader), count_(count) {}
+
+  void VisitChunk(const ChunkData& chunk) {
+    HeapObjectWalker walker(reader_, cache_, chunk.area_start_address,
+                            chunk.area_end_address, chunk.allocation_top,
+                            chunk.allocation_limit);
+    HeapObjectInfo object;
+    while (walker.Next(&object)) {
+      switch (GetObjectKind(walker, object)) {
+        case ObjectKind::kJSFunction: VisitFunction(walker, object); break;
+        case ObjectKind::kSharedFunctionInfo: VisitShared(walker, object); break;
+        case ObjectKind::kBytecodeArray:
+          bytecode_sizes_[object.tagged_ptr] = object.size;
+          bytecode_bytes_ += object.size;
+          break;
+        case ObjectKind::kCode: VisitCode(walker, object); break;
+        default: break;
+      }
+    }
+  }
+
+  // Joins closures to their code and bytecode. Call once, after the pass.
+  void Finish(const KindNames& kind_names) {
+    for (const auto& closure : closures_) {
+      FunctionCode& function = functions_[closure.first];
+      if (function.closures++ == 0) {
+        function.shared_function_info = closure.first;
+        auto data = shared_data_.find(closure.first);
+        if (data != shared_data_.end()) {
+          auto bytecode = bytecode_sizes_.find(data->second);
+          if (bytecode != bytecode_sizes_.end()) {
+            function.bytecode_bytes = bytecode->second;
+          }
+        }
+      }
+
+      Tier tier = function.bytecode_bytes != 0 ? Tier::kInterpreted
+                                               : Tier::kUncompiled;
+      // Interpreted closures share builtins, which are embedded in the binary
+      // rather than in a chunk, so only code found on the heap is counted.
+      auto code = codes_.find(closure.second);
+      if (code != codes_.end()) {
+        std::wstring kind = GetKindName(kind_names, code->second.kind);
+        if (kind.find(L"TURBOFAN") != std::wstring::npos ||
+            kind.find(L"TURBOPROP") != std::wstring::npos ||
+            kind.find(L"MAGLEV") != std::wstring::npos ||
+            kind.find(L"OPTIMIZED") != std::wstring::npos) {
+          tier = Tier::kOptimized;
+        } else if (kind.find(L"BASELINE") != std::wstring::npos ||
+                   kind.find(L"SPARKPLUG") != std::wstring::npos) {
+          tier = Tier::kBaseline;
+        }
+        if (std::find(function.codes.begin(), function.codes.end(),
+                      closure.second) == function.codes.end()) {
+          function.codes.push_back(closure.second);
+          function.code_bytes += code->second.size;
+        }
+      }
+      ++tier_counts_[static_cast<size_t>(tier)];
+      function.tier = std::max(function.tier, tier);
+    }
+  }
+
+  uint64_t closures() const { return closures_.size(); }
+  uint64_t tier_count(Tier tier) const { return tier_counts_[static_cast<size_t>(tier)]; }
+  uint64_t bytecode_arrays() const { return bytecode_sizes_.size(); }
+  uint64_t bytecode_bytes() const { return bytecode_bytes_; }
+  uint64_t code_objects() const { return codes_.size(); }
+  uint64_t code_bytes() const { return code_bytes_; }
+
+  std::unordered_map<int64_t, uint64_t> GetCodeCountsByKind() const {
+    std::unordered_map<int64_t, uint64_t> counts;
+    for (const auto& code : codes_) ++counts[code.second.kind];
+    return counts;
+  }
+
+  // Largest first.
+  std::vector<LargeCode> GetLargestCode() const {
+    std::vector<LargeCode> largest = largest_code_;
+    std::sort_heap(largest.begin(), largest.end(), IsLarger);
+    return largest;
+  }
+
+  const CodeObject& GetCode(uint64_t tagged_ptr) const { return codes_.at(tagged_ptr); }
+
+  // The functions with the most bytecode and machine code, most first.
+  std::vector<const FunctionCode*> GetLargestFunctions() const {
+    std::vector<const FunctionCode*> functions;
+    functions.reserve(functions_.size());
+    for (const auto& entry : functions_) functions.push_back(&entry.second);
+    size_t count = std::min(count_, functions.size());
+    std::partial_sort(functions.begin(), functions.begin() + count, functions.end(),
+                      [](const FunctionCode* a, const FunctionCode* b) {
+                        return a->bytecode_bytes + a->code_bytes >
+                               b->bytecode_bytes + b->code_bytes;
+                      });
+    functions.resize(count);
+    return functions;
+  }
+
+ private:
+  // Orders largest_code_ as a min-heap, so the smallest is replaced first.
+  static bool IsLarger(const LargeCode& a, const LargeCode& b) {
+    return a.size > b.size;
+  }
+
+  ObjectKind GetObjectKind(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    uint16_t instance_type = object.map->instance_type;
+    auto it = object_kinds_.find(instance_type);
+    if (it != object_kinds_.end()) return it->second;
+    const ObjectLayout* layout = cache_.GetLayout(walker.reader(), object.tagged_ptr);
+    ObjectKind kind = ObjectKind::kOther;
+    if (layout != nullptr) {
+      if (layout->type_name == "v8::internal::JSFunction") {
+        kind = ObjectKind::kJSFunction;
+      } else if (layout->type_name == "v8::internal::SharedFunctionInfo") {
+        kind = ObjectKind::kSharedFunctionInfo;
+      } else if (layout->type_name == "v8::internal::BytecodeArray") {
+        kind = ObjectKind::kBytecodeArray;
+      } else if (layout->type_name == "v8::internal::Code") {
+        kind = ObjectKind::kCode;
+      }
+    }
+    object_kinds_.emplace(instance_type, kind);
+    return kind;
+  }
+
+  bool ReadField(HeapObjectWalker& walker, const HeapObjectInfo& object,
+                 const char* name, uint64_t* value) {
+    const ObjectLayout* layout = cache_.GetLayout(walker.reader(), object.tagged_ptr);
+    const FieldLayout* field = layout != nullptr ? layout->FindField(name) : nullptr;
+    return field != nullptr &&
+           cache_.ReadTagged(walker.reader(),
+                             (object.tagged_ptr & ~kHeapObjectTagMask) + field->offset,
+                             value);
+  }
+
+  void VisitFunction(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    uint64_t shared, code = 0;
+    if (!ReadField(walker, object, "shared_function_info", &shared)) return;
+    ReadField(walker, object, "code", &code);
+    closures_.emplace_back(shared, code);
+  }
+
+  void VisitShared(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    uint64_t data;
+    if (ReadField(walker, object, "function_data", &data)) {
+      shared_data_[object.tagged_ptr] = data;
+    }
+  }
+
+  void VisitCode(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    int64_t kind = kUnknownKind;
+    const ObjectLayout* layout = cache_.GetLayout(walker.reader(), object.tagged_ptr);
+    const FieldLayout* flags = layout != nullptr ? layout->FindField("flags") : nullptr;
+    const BitFieldLayout* kind_bits =
+        flags != nullptr ? flags->FindBitField("kind") : nullptr;
+    uint64_t value;
+    if (kind_bits != nullptr &&
+        cache_.ReadBitField(walker.reader(), object.tagged_ptr, *flags, *kind_bits,
+                            &value)) {
+      kind = static_cast<int64_t>(value);
+    }
+    codes_[object.tagged_ptr] = {object.size, kind};
+    code_bytes_ += object.size;
+
+    if (count_ == 0) return;
+    if (largest_code_.size() < count_) {
+      largest_code_.push_back({object.tagged_ptr, object.size});
+      std::push_heap(largest_code_.begin(), largest_code_.end(), IsLarger);
+    } else if (object.size > largest_code_.front().size) {
+      std::pop_heap(largest_code_.begin(), largest_code_.end(), IsLarger);
+      largest_code_.back() = {object.tagged_ptr, object.size};
+      std::push_heap(largest_code_.begin(), largest_code_.end(), IsLarger);
+    }
+  }
+
+  MemReader reader_;
+  LayoutCache cache_;
+  size_t count_;
+  std::unordered_map<uint16_t, ObjectKind> object_kinds_;
+  std::vector<std::pair<uint64_t, uint64_t>> closures_;  // {shared, code}
+  std::unordered_map<uint64_t, uint64_t> shared_data_;  // function_data
+  std::unordered_map<uint64_t, uint64_t> bytecode_sizes_;
+  std::unordered_map<uint64_t, CodeObject> codes_;
+  std::vector<LargeCode> largest_code_;
+  std::unordered_map<uint64_t, FunctionCode> functions_;
+  uint64_t tier_counts_[4] = {};
+  uint64_t bytecode_bytes_ = 0;
+  uint64_t code_bytes_ = 0;
+};
+
+KindNames GetCodeKindNames(winrt::com_ptr<IDebugHostContext>& sp_ctx) {
+  KindNames names;
+  // The enum moved out of Code in later versions of V8.
+  for (const char16_t* type_name : {u"v8::internal::CodeKind", u"v8::internal::Code::Kind"}) {
+    winrt::com_ptr<IDebugHostType> sp_type =
+        Extension::current_extension_->GetV8ObjectType(sp_ctx, type_name);
+    if (sp_type != nullptr && GetEnumNames(sp_type, &names)) break;
+  }
+  return names;
+}
+
+}  // namespace
+
+HRESULT __stdcall CodeCensusAlias::Call(IModelObject* p_context_object,
+                                        ULONG64 arg_count,
+                                        _In_reads_(arg_count)
+                                            IModelObject** pp_arguments,
+                                        IModelObject** pp_result,
+                                        IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count > 1) return E_INVALIDARG;
+  uint64_t count = kDefaultCount;
+  if (arg_count == 1) {
+    VARIANT vt_count;
+    HRESULT hr = pp_arguments[0]->GetIntrinsicValueAs(VT_UI8, &vt_count);
+    if (FAILED(hr)) return hr;
+    count = vt_count.ullVal;
+  }
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  std::vector<ChunkData> chunks;
+  hr = GetMemoryChunks(chunks);
+  if (FAILED(hr)) return hr;
+
+  ScopedTrace trace("CodeCensus");
+  KindNames kind_names = GetCodeKindNames(sp_ctx);
+  CodeCensus census(GetMemReader(sp_ctx), static_cast<size_t>(count));
+  for (const ChunkData& chunk : chunks) census.VisitChunk(chunk);
+  census.Finish(kind_names);
+
+  winrt::com_ptr<IModelObject> sp_result, sp_by_kind;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"closures", census.closures());
+  if (FAILED(hr)) return hr;
+  for (Tier tier : {Tier::kUncompiled, Tier::kInterpreted, Tier::kBaseline,
+                    Tier::kOptimized}) {
+    hr = SetULong64Key(sp_result.get(), GetTierName(tier), census.tier_count(tier));
+    if (FAILED(hr)) return hr;
+  }
+  hr = SetULong64Key(sp_result.get(), L"bytecode_arrays", census.bytecode_arrays());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"bytecode_bytes", census.bytecode_bytes());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"code_objects", census.code_objects());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"code_bytes", census.code_bytes());
+  if (FAILED(hr)) return hr;
+
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_by_kind.put());
+  if (FAILED(hr)) return hr;
+  for (const auto& kind_count : census.GetCodeCountsByKind()) {
+    std::wstring kind = GetKindName(kind_names, kind_count.first);
+    hr = SetULong64Key(sp_by_kind.get(), kind.c_str(), kind_count.second);
+    if (FAILED(hr)) return hr;
+  }
+  hr = sp_result->SetKey(L"code_by_kind", sp_by_kind.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  ModelObjectVector largest_code;
+  for (const LargeCode& code : census.GetLargestCode()) {
+    winrt::com_ptr<IModelObject> sp_entry, sp_code;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_entry.put());
+    if (FAILED(hr)) return hr;
+    hr = CreateV8HeapObjectModel(sp_ctx, code.tagged_ptr, sp_code.put());
+    if (FAILED(hr)) return hr;
+    hr = sp_entry->SetKey(L"code", sp_code.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"size", code.size);
+    if (FAILED(hr)) return hr;
+    hr = SetStringKey(sp_entry.get(), L"kind",
+                      GetKindName(kind_names, census.GetCode(code.tagged_ptr).kind));
+    if (FAILED(hr)) return hr;
+    largest_code.push_back(std::move(sp_entry));
+  }
+
+  ModelObjectVector functions;
+  for (const FunctionCode* function : census.GetLargestFunctions()) {
+    winrt::com_ptr<IModelObject> sp_entry, sp_function;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_entry.put());
+    if (FAILED(hr)) return hr;
+    hr = CreateV8HeapObjectModel(sp_ctx, function->shared_function_info,
+                                 sp_function.put());
+    if (FAILED(hr)) return hr;
+    hr = sp_entry->SetKey(L"function", sp_function.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    hr = SetStringKey(sp_entry.get(), L"tier", GetTierName(function->tier));
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"closures", function->closures);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"bytecode_bytes", function->bytecode_bytes);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"code_bytes", function->code_bytes);
+    if (FAILED(hr)) return hr;
+    functions.push_back(std::move(sp_entry));
+  }
+
+  winrt::com_ptr<IModelObject> sp_largest_code, sp_functions;
+  hr = CreateModelObjectList(sp_ctx, std::move(largest_code), sp_largest_code.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"largest_code", sp_largest_code.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateModelObjectList(sp_ctx, std::move(functions), sp_functions.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"functions", sp_functions.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
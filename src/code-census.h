@@ -0,0 +1,18 @@
+#pragma once
+
+#include <crtdbg.h>
+#include "../utilities.h"
+#include "extension.h"
+#include "list-chunks.h"
+#include "v8.h"
+
+// @$codecensus([count]) - the JIT state of the heap: how many closures run
+// uncompiled, interpreted, baseline or optimized code, how many bytes of
+// bytecode and machine code there are, the count largest Code objects, and
+// the count functions (default 20) holding the most code.
+struct CodeCensusAlias : winrt::implements<CodeCensusAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
@@ -0,0 +1,343 @@
+#include "context-retention.h"
+#include "object.h"
+#include "top-n.h"
+#include "trace.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint64_t kDefaultCount = 20;
+constexpr uint32_t kNoContext = UINT32_MAX;
+
+struct HeldObject {
+  uint64_t tagged_ptr = 0;
+  uint64_t size = 0;
+};
+
+struct ContextNode {
+  uint64_t address;
+  uint64_t scope_info;
+  uint64_t previous;
+  uint64_t own_bytes;  // The context and the objects in its slots.
+  HeldObject largest;  // The largest object in its slots.
+
+  // The whole chain up to the native context, filled in once built.
+  uint32_t parent = kNoContext;
+  uint32_t depth = 0;
+  bool resolved = false;
+  bool on_chain = false;  // Being resolved; used to detect cycles.
+  uint64_t chain_bytes = 0;
+  HeldObject chain_largest;
+};
+
+struct ClosureRetention {
+  uint64_t function;
+  uint32_t context;
+  uint64_t bytes;
+};
+
+struct ScopeRetention {
+  uint64_t scope_info;
+  uint64_t contexts;
+  uint64_t bytes;
+};
+
+template <typename T>
+struct HoldsLess {
+  bool operator()(const T& a, const T& b) const { return a.bytes < b.bytes; }
+};
+
+// Estimates what each closure retains as the shallow sizes of its context,
+// every context before it in the chain, and the objects in their slots. An
+// object held by more than one context is counted in each. Each context's
+// chain is summed once and reused by every closure and inner context that
+// shares it.
+class ContextRetention {
+ public:
+  explicit ContextRetention(const MemReader& reader) : reader_(reader) {}
+
+  void VisitChunk(const ChunkData& chunk) {
+    HeapObjectWalker walker(reader_, cache_, chunk.area_start_address,
+                            chunk.area_end_address, chunk.allocation_top,
+                            chunk.allocation_limit);
+    HeapObjectInfo object;
+    while (walker.Next(&object)) {
+      switch (GetObjectKind(walker, object)) {
+        case ObjectKind::kContext: VisitContext(walker, object); break;
+        case ObjectKind::kJSFunction: VisitFunction(walker, object); break;
+        default: break;
+      }
+    }
+  }
+
+  // Links each context to the previous one and sums the chains. Call once,
+  // after the walk.
+  void Build() {
+    sizes_ = {};
+    std::sort(contexts_.begin(), contexts_.end(),
+              [](const ContextNode& a, const ContextNode& b) {
+                return a.address < b.address;
+              });
+    for (ContextNode& context : contexts_) context.parent = Find(context.previous);
+
+    // Chains can be long, so resolve them with an explicit stack rather than
+    // recursion.
+    std::vector<uint32_t> chain;
+    for (uint32_t i = 0; i < contexts_.size(); ++i) {
+      // A cycle of corrupt previous pointers is cut where it meets itself.
+      for (uint32_t next = i; next != kNoContext && !contexts_[next].resolved &&
+                              !contexts_[next].on_chain;
+           next = contexts_[next].parent) {
+        contexts_[next].on_chain = true;
+        chain.push_back(next);
+      }
+      while (!chain.empty()) {
+        ContextNode& context = contexts_[chain.back()];
+        chain.pop_back();
+        context.on_chain = false;
+        context.chain_bytes = context.own_bytes;
+        context.chain_largest = context.largest;
+        if (context.parent != kNoContext && contexts_[context.parent].resolved) {
+          const ContextNode& parent = contexts_[context.parent];
+          context.chain_bytes += parent.chain_bytes;
+          context.depth = parent.depth + 1;
+          if (parent.chain_largest.size > context.chain_largest.size) {
+            context.chain_largest = parent.chain_largest;
+          }
+        }
+        context.resolved = true;
+
+        ScopeRetention& scope = scopes_[context.scope_info];
+        scope.scope_info = context.scope_info;
+        ++scope.contexts;
+        scope.bytes += context.own_bytes;
+      }
+    }
+  }
+
+  size_t contexts() const { return contexts_.size(); }
+  size_t closures() const { return closures_.size(); }
+  const ContextNode& context(uint32_t index) const { return contexts_[index]; }
+
+  std::vector<ClosureRetention> GetTopClosures(size_t count) const {
+    BoundedTopN<ClosureRetention, HoldsLess<ClosureRetention>> top(count);
+    for (const auto& closure : closures_) {
+      uint32_t context = Find(closure.second);
+      if (context == kNoContext) continue;
+      top.Push({closure.first, context, contexts_[context].chain_bytes});
+    }
+    return top.Take();
+  }
+
+  std::vector<ScopeRetention> GetTopScopes(size_t count) const {
+    BoundedTopN<ScopeRetention, HoldsLess<ScopeRetention>> top(count);
+    for (const auto& scope : scopes_) top.Push(scope.second);
+    return top.Take();
+  }
+
+ private:
+  enum class ObjectKind {
+    kOther,
+    kContext,
+    kJSFunction,
+  };
+
+  ObjectKind GetObjectKind(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    uint16_t instance_type = object.map->instance_type;
+    auto it = object_kinds_.find(instance_type);
+    if (it != object_kinds_.end()) return it->second;
+    const ObjectLayout* layout = cache_.GetLayout(walker.reader(), object.tagged_ptr);
+    ObjectKind kind = ObjectKind::kOther;
+    // Native contexts end every chain, and hold the whole realm besides, so
+    // they are left out.
+    if (layout != nullptr && layout->type_name == "v8::internal::Context") {
+      kind = ObjectKind::kContext;
+    } else if (layout != nullptr && layout->type_name == "v8::internal::JSFunction") {
+      kind = ObjectKind::kJSFunction;
+    }
+    object_kinds_.emplace(instance_type, kind);
+    return kind;
+  }
+
+  uint32_t Find(uint64_t address) const {
+    auto it = std::lower_bound(
+        contexts_.begin(), contexts_.end(), address,
+        [](const ContextNode& node, uint64_t address) { return node.address < address; });
+    if (it == contexts_.end() || it->address != address) return kNoContext;
+    return static_cast<uint32_t>(it - contexts_.begin());
+  }
+
+  void VisitContext(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    const MemReader& reader = walker.reader();
+    const ObjectLayout* layout = cache_.GetLayout(reader, object.tagged_ptr);
+    if (layout == nullptr) return;
+    const FieldLayout* length_field = layout->FindField("length");
+    const FieldLayout* scope_info_field = layout->FindField("scope_info");
+    const FieldLayout* previous_field = layout->FindField("previous");
+    const FieldLayout* elements_field = layout->FindField("elements");
+    int64_t length;
+    if (length_field == nullptr || scope_info_field == nullptr ||
+        previous_field == nullptr || elements_field == nullptr ||
+        !cache_.ReadInteger(reader, object.tagged_ptr, *length_field, &length) ||
+        length < 0 ||
+        elements_field->offset + length * cache_.tagged_size() > object.size) {
+      return;
+    }
+    uint64_t start = object.tagged_ptr & ~kHeapObjectTagMask;
+    ContextNode context;
+    context.address = object.tagged_ptr;
+    context.own_bytes = object.size;
+    if (!cache_.ReadTagged(reader, start + scope_info_field->offset,
+                           &context.scope_info) ||
+        !cache_.ReadTagged(reader, start + previous_field->offset,
+                           &context.previous) ||
+        !cache_.ReadTaggedArray(reader, start + elements_field->offset,
+                                static_cast<size_t>(length), &slots_)) {
+      return;
+    }
+    for (uint64_t slot : slots_) {
+      if ((slot & kHeapObjectTagMask) != kHeapObjectTag) continue;
+      uint64_t size = GetSize(slot);
+      context.own_bytes += size;
+      if (size > context.largest.size) context.largest = {slot, size};
+    }
+    contexts_.push_back(context);
+  }
+
+  void VisitFunction(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    const ObjectLayout* layout = cache_.GetLayout(walker.reader(), object.tagged_ptr);
+    const FieldLayout* context_field =
+        layout != nullptr ? layout->FindField("context") : nullptr;
+    uint64_t context;
+    if (context_field != nullptr &&
+        cache_.ReadTagged(walker.reader(),
+                          (object.tagged_ptr & ~kHeapObjectTagMask) + context_field->offset,
+                          &context)) {
+      closures_.emplace_back(object.tagged_ptr, context);
+    }
+  }
+
+  // The shallow size of an object held in a slot, or 0 if it can't be read.
+  uint64_t GetSize(uint64_t tagged_ptr) {
+    auto it = sizes_.find(tagged_ptr);
+    if (it != sizes_.end()) return it->second;
+    uint64_t size;
+    MapInfo* map = cache_.GetMap(reader_, tagged_ptr);
+    if (map == nullptr || !cache_.GetObjectSize(reader_, tagged_ptr, *map, &size)) {
+      size = 0;
+    }
+    sizes_.emplace(tagged_ptr, size);
+    return size;
+  }
+
+  MemReader reader_;
+  LayoutCache cache_;
+  std::unordered_map<uint16_t, ObjectKind> object_kinds_;
+  std::unordered_map<uint64_t, uint64_t> sizes_;  // Of objects held in slots.
+  std::vector<uint64_t> slots_;
+  std::vector<ContextNode> contexts_;  // Sorted by address once built.
+  std::vector<std::pair<uint64_t, uint64_t>> closures_;  // {function, context}
+  std::unordered_map<uint64_t, ScopeRetention> scopes_;  // By ScopeInfo.
+};
+
+HRESULT SetObjectKey(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                     IModelObject* p_object, const wchar_t* key,
+                     uint64_t tagged_ptr) {
+  winrt::com_ptr<IModelObject> sp_value;
+  HRESULT hr = CreateV8HeapObjectModel(sp_ctx, tagged_ptr, sp_value.put());
+  if (FAILED(hr)) return hr;
+  return p_object->SetKey(key, sp_value.get(), nullptr);
+}
+
+}  // namespace
+
+HRESULT __stdcall ContextRetentionAlias::Call(IModelObject* p_context_object,
+                                              ULONG64 arg_count,
+                                              _In_reads_(arg_count)
+                                                  IModelObject** pp_arguments,
+                                              IModelObject** pp_result,
+                                              IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count > 1) return E_INVALIDARG;
+  uint64_t count = kDefaultCount;
+  if (arg_count == 1) {
+    VARIANT vt_count;
+    HRESULT hr = pp_arguments[0]->GetIntrinsicValueAs(VT_UI8, &vt_count);
+    if (FAILED(hr)) return hr;
+    count = vt_count.ullVal;
+  }
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  std::vector<ChunkData> chunks;
+  hr = GetMemoryChunks(chunks);
+  if (FAILED(hr)) return hr;
+
+  ScopedTrace trace("ContextRetention");
+  ContextRetention retention(GetMemReader(sp_ctx));
+  for (const ChunkData& chunk : chunks) retention.VisitChunk(chunk);
+  retention.Build();
+
+  winrt::com_ptr<IModelObject> sp_result;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"contexts", retention.contexts());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"closures", retention.closures());
+  if (FAILED(hr)) return hr;
+
+  ModelObjectVector closures;
+  for (const ClosureRetention& closure :
+       retention.GetTopClosures(static_cast<size_t>(count))) {
+    const ContextNode& context = retention.context(closure.context);
+    winrt::com_ptr<IModelObject> sp_entry;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_entry.put());
+    if (FAILED(hr)) return hr;
+    hr = SetObjectKey(sp_ctx, sp_entry.get(), L"function", closure.function);
+    if (FAILED(hr)) return hr;
+    hr = SetObjectKey(sp_ctx, sp_entry.get(), L"context", context.address);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"depth", context.depth);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"bytes", closure.bytes);
+    if (FAILED(hr)) return hr;
+    if (context.chain_largest.tagged_ptr != 0) {
+      hr = SetObjectKey(sp_ctx, sp_entry.get(), L"largest_object",
+                        context.chain_largest.tagged_ptr);
+      if (FAILED(hr)) return hr;
+      hr = SetULong64Key(sp_entry.get(), L"largest_size", context.chain_largest.size);
+      if (FAILED(hr)) return hr;
+    }
+    closures.push_back(std::move(sp_entry));
+  }
+
+  ModelObjectVector scopes;
+  for (const ScopeRetention& scope :
+       retention.GetTopScopes(static_cast<size_t>(count))) {
+    winrt::com_ptr<IModelObject> sp_entry;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_entry.put());
+    if (FAILED(hr)) return hr;
+    hr = SetObjectKey(sp_ctx, sp_entry.get(), L"scope_info", scope.scope_info);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"contexts", scope.contexts);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"bytes", scope.bytes);
+    if (FAILED(hr)) return hr;
+    scopes.push_back(std::move(sp_entry));
+  }
+
+  winrt::com_ptr<IModelObject> sp_closures, sp_scopes;
+  hr = CreateModelObjectList(sp_ctx, std::move(closures), sp_closures.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"top_closures", sp_closures.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateModelObjectList(sp_ctx, std::move(scopes), sp_scopes.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"top_scopes", sp_scopes.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <crtdbg.h>
+#include "../utilities.h"
+#include "extension.h"
+#include "list-chunks.h"
+#include "v8.h"
+
+// @$contextretention([count]) - what closures keep alive through their
+// contexts. Lists the count (default 20) closures whose context chains hold
+// the most bytes, and the ScopeInfos whose contexts hold the most in total.
+struct ContextRetentionAlias
+    : winrt::implements<ContextRetentionAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
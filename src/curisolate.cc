@@ -1,32 +1,81 @@
 #include "curisolate.h"
 
 int GetIsolateKey(winrt::com_ptr<IDebugHostContext>& sp_ctx) {
-  auto sp_v8_module = Extension::current_extension_->GetV8Module(sp_ctx);
-  if (sp_v8_module == nullptr) return -1;
-
-  winrt::com_ptr<IDebugHostSymbol> sp_isolate_sym;
-  HRESULT hr =
-      sp_v8_module->FindSymbolByName(L"isolate_key_", sp_isolate_sym.put());
-  if (SUCCEEDED(hr)) {
-    SymbolKind kind;
-    hr = sp_isolate_sym->GetSymbolKind(&kind);
-    if (SUCCEEDED(hr)) {
-      if (kind == SymbolData) {
-        winrt::com_ptr<IDebugHostData> sp_isolate_key_data;
-        sp_isolate_sym.as(sp_isolate_key_data);
-        Location loc;
-        hr = sp_isolate_key_data->GetLocation(&loc);
-        if (SUCCEEDED(hr)) {
-          int isolate_key;
-          ULONG64 bytes_read;
-          hr = Extension::current_extension_->sp_debug_host_memory_->ReadBytes(
-              sp_ctx.get(), loc, &isolate_key, 4, &bytes_read);
-          return isolate_key;
-        }
-      }
-    }
+  Location isolate_key_location;
+  if (!Extension::current_extension_->GetIsolateKeyLocation(sp_ctx, &isolate_key_location)) {
+    return -1;
   }
-  return -1;
+
+  int isolate_key;
+  ULONG64 bytes_read;
+  HRESULT hr = Extension::current_extension_->sp_debug_host_memory_->ReadBytes(
+      sp_ctx.get(), isolate_key_location, &isolate_key, 4, &bytes_read);
+  return SUCCEEDED(hr) ? isolate_key : -1;
+}
+
+// Where the TLS slot arrays are in an x64 _TEB, which hasn't changed since
+// Windows Vista. Used if ntdll's symbols can't be loaded.
+constexpr ULONG kTlsSlotsOffset = 0x1480;
+constexpr ULONG kTlsExpansionSlotsOffset = 0x1780;
+
+// Finds the TLS slot arrays in the _TEB type the first time it is needed,
+// after which slots of every thread are read directly.
+static const TebLayout& GetTebLayout() {
+  TebLayout& layout = Extension::current_extension_->teb_layout_;
+  if (layout.resolved) return layout;
+  layout.tls_slots_offset = kTlsSlotsOffset;
+  layout.tls_expansion_slots_offset = kTlsExpansionSlotsOffset;
+  winrt::com_ptr<IDebugSymbols3> sp_symbols;
+  ULONG type_id, slots_offset, expansion_slots_offset;
+  ULONG64 module;
+  if (sp_debug_control.try_as(sp_symbols) &&
+      SUCCEEDED(sp_symbols->GetSymbolTypeId("ntdll!_TEB", &type_id, &module)) &&
+      SUCCEEDED(sp_symbols->GetFieldOffset(module, type_id, "TlsSlots",
+                                           &slots_offset)) &&
+      SUCCEEDED(sp_symbols->GetFieldOffset(module, type_id, "TlsExpansionSlots",
+                                           &expansion_slots_offset))) {
+    layout.tls_slots_offset = slots_offset;
+    layout.tls_expansion_slots_offset = expansion_slots_offset;
+  }
+  layout.resolved = true;
+  return layout;
+}
+
+// Reads the value of V8's isolate TLS slot for the thread owning teb. Keys
+// past the inline TlsSlots array are in the separately allocated
+// TlsExpansionSlots array, which is null until the thread has used one.
+static HRESULT ReadThreadIsolate(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                                 ULONG64 teb, int isolate_key, ULONG64* p_isolate) {
+  auto& sp_memory = Extension::current_extension_->sp_debug_host_memory_;
+  const TebLayout& layout = GetTebLayout();
+  *p_isolate = 0;
+
+  Location slot_location;
+  if (isolate_key < TLS_MINIMUM_AVAILABLE) {
+    slot_location = Location{teb + layout.tls_slots_offset +
+                             isolate_key * sizeof(ULONG64)};
+  } else {
+    ULONG64 expansion_slots;
+    HRESULT hr = sp_memory->ReadPointers(
+        sp_ctx.get(), Location{teb + layout.tls_expansion_slots_offset},
+        1, &expansion_slots);
+    if (FAILED(hr)) return hr;
+    if (expansion_slots == 0) return S_OK;
+    slot_location = Location{expansion_slots + (isolate_key - TLS_MINIMUM_AVAILABLE) *
+                                                   sizeof(ULONG64)};
+  }
+  return sp_memory->ReadPointers(sp_ctx.get(), slot_location, 1, p_isolate);
+}
+
+static HRESULT CreateIsolateObject(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                                   ULONG64 isolate_address,
+                                   IModelObject** pp_result) {
+  winrt::com_ptr<IDebugHostType> sp_isolate_type =
+      Extension::current_extension_->GetV8ObjectType(sp_ctx, u"v8::internal::Isolate");
+  if (sp_isolate_type == nullptr) return E_FAIL;
+
+  return sp_data_model_manager->CreateTypedObject(
+      sp_ctx.get(), Location{isolate_address}, sp_isolate_type.get(), pp_result);
 }
 
 HRESULT GetCurrentIsolate(winrt::com_ptr<IModelObject>& sp_result) {
@@ -35,67 +84,119 @@ HRESULT GetCurrentIsolate(winrt::com_ptr<IModelObject>& sp_result) {
 
   // Get the current context
   winrt::com_ptr<IDebugHostContext> sp_host_context;
-  winrt::com_ptr<IModelObject> sp_root_namespace;
   hr = sp_debug_host->GetCurrentContext(sp_host_context.put());
   if (FAILED(hr)) return hr;
 
-  winrt::com_ptr<IModelObject> sp_curr_thread;
-  if (!GetCurrentThread(sp_host_context, sp_curr_thread.put())) {
-    return E_FAIL;
-  }
+  int isolate_key = GetIsolateKey(sp_host_context);
+  if (isolate_key == -1) return E_FAIL;
 
-  winrt::com_ptr<IModelObject> sp_environment, sp_environment_block;
-  winrt::com_ptr<IModelObject> sp_tls_slots, sp_slot_index, sp_isolate_ptr;
-  hr = sp_curr_thread->GetKeyValue(L"Environment", sp_environment.put(), nullptr);
-  if (FAILED(hr)) return E_FAIL;
+  winrt::com_ptr<IDebugSystemObjects> sp_sys_objects;
+  if (!sp_debug_control.try_as(sp_sys_objects)) return E_FAIL;
+  ULONG64 teb, isolate_address;
+  hr = sp_sys_objects->GetCurrentThreadTeb(&teb);
+  if (FAILED(hr)) return hr;
+  hr = ReadThreadIsolate(sp_host_context, teb, isolate_key, &isolate_address);
+  if (FAILED(hr)) return hr;
 
-  hr = sp_environment->GetKeyValue(L"EnvironmentBlock", sp_environment_block.put(),
-                                  nullptr);
-  if (FAILED(hr)) return E_FAIL;
+  return CreateIsolateObject(sp_host_context, isolate_address, sp_result.put());
+}
 
-  // EnvironmentBlock and TlsSlots are native types (TypeUDT) and thus GetRawValue
-  // rather than GetKeyValue should be used to get field (member) values.
-  ModelObjectKind kind;
-  hr = sp_environment_block->GetKind(&kind);
-  if (kind != ModelObjectKind::ObjectTargetObject) return E_FAIL;
+// Finds the TEB of a thread model object from the location of its
+// environment block, which the debugger already knows without switching
+// threads or reading the target.
+static HRESULT GetThreadTeb(winrt::com_ptr<IModelObject>& sp_thread, ULONG64* p_teb) {
+  winrt::com_ptr<IModelObject> sp_environment, sp_environment_block;
+  HRESULT hr = sp_thread->GetKeyValue(L"Environment", sp_environment.put(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = sp_environment->GetKeyValue(L"EnvironmentBlock", sp_environment_block.put(),
+                                   nullptr);
+  if (FAILED(hr)) return hr;
+  Location teb_location;
+  hr = sp_environment_block->GetLocation(&teb_location);
+  if (FAILED(hr)) return hr;
+  *p_teb = teb_location.GetOffset();
+  return S_OK;
+}
 
-  hr = sp_environment_block->GetRawValue(SymbolField, L"TlsSlots", 0,
-                                       sp_tls_slots.put());
-  if (FAILED(hr)) return E_FAIL;
+HRESULT GetThreads(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                   std::vector<ThreadInfo>& threads) {
+  threads.clear();
+  winrt::com_ptr<IModelObject> sp_process, sp_threads;
+  winrt::com_ptr<IIterableConcept> sp_iterable;
+  winrt::com_ptr<IModelIterator> sp_iterator;
+  if (!GetCurrentProcess(sp_ctx, sp_process.put())) return E_FAIL;
+  HRESULT hr = sp_process->GetKeyValue(L"Threads", sp_threads.put(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = sp_threads->GetConcept(__uuidof(IIterableConcept),
+                              reinterpret_cast<IUnknown**>(sp_iterable.put()),
+                              nullptr);
+  if (FAILED(hr)) return hr;
+  hr = sp_iterable->GetIterator(sp_threads.get(), sp_iterator.put());
+  if (FAILED(hr)) return hr;
 
-  int isolate_key = GetIsolateKey(sp_host_context);
-  hr = CreateInt32(isolate_key, sp_slot_index.put());
-  if (isolate_key == -1 || FAILED(hr)) return E_FAIL;
+  // The current thread is never changed, as each switch would notify every
+  // client of the engine.
+  winrt::com_ptr<IModelObject> sp_thread;
+  while (SUCCEEDED(sp_iterator->GetNext(sp_thread.put(), 0, nullptr, nullptr))) {
+    ThreadInfo thread;
+    if (SUCCEEDED(sp_thread->GetKeyValue(L"Id", thread.sp_id.put(), nullptr)) &&
+        SUCCEEDED(GetThreadTeb(sp_thread, &thread.teb))) {
+      threads.push_back(std::move(thread));
+    }
+    sp_thread = nullptr;
+  }
+  return S_OK;
+}
 
-  hr = GetModelAtIndex(sp_tls_slots, sp_slot_index, sp_isolate_ptr.put());
-  if (FAILED(hr)) return E_FAIL;
+HRESULT GetAllIsolates(winrt::com_ptr<IModelObject>& sp_result) {
+  HRESULT hr = S_OK;
+  sp_result = nullptr;
 
-  // Need to dereference the slot and then get the address held in it
-  winrt::com_ptr<IModelObject> sp_dereferenced_slot;
-  hr = sp_isolate_ptr->Dereference(sp_dereferenced_slot.put());
+  winrt::com_ptr<IDebugHostContext> sp_host_context;
+  hr = sp_debug_host->GetCurrentContext(sp_host_context.put());
   if (FAILED(hr)) return hr;
 
-  VARIANT vt_isolate_ptr;
-  hr = sp_dereferenced_slot->GetIntrinsicValue(&vt_isolate_ptr);
-  if (FAILED(hr) || vt_isolate_ptr.vt != VT_UI8) {
-    return E_FAIL;
-  }
-  Location isolate_addr{vt_isolate_ptr.ullVal};
+  int isolate_key = GetIsolateKey(sp_host_context);
+  if (isolate_key == -1) return E_FAIL;
 
-  // If we got the isolate_key OK, then must have the V8 module loaded
-  // Get the internal Isolate type from it
-  winrt::com_ptr<IDebugHostType> sp_isolate_type, sp_isolate_ptr_type;
-  hr = Extension::current_extension_->GetV8Module(sp_host_context)
-           ->FindTypeByName(L"v8::internal::Isolate", sp_isolate_type.put());
-  if (FAILED(hr)) return hr;
-  hr = sp_isolate_type->CreatePointerTo(PointerStandard, sp_isolate_ptr_type.put());
+  std::vector<ThreadInfo> threads;
+  hr = GetThreads(sp_host_context, threads);
   if (FAILED(hr)) return hr;
 
-  hr = sp_data_model_manager->CreateTypedObject(
-      sp_host_context.get(), isolate_addr, sp_isolate_type.get(), sp_result.put());
-  if (FAILED(hr)) return hr;
+  // Isolates in the order first seen, with the ids of the threads that have
+  // each one entered.
+  std::vector<std::pair<ULONG64, ModelObjectVector>> isolates;
+  std::unordered_map<ULONG64, size_t> isolate_indices;
+
+  for (ThreadInfo& thread : threads) {
+    ULONG64 isolate_address;
+    if (SUCCEEDED(ReadThreadIsolate(sp_host_context, thread.teb, isolate_key,
+                                    &isolate_address)) &&
+        isolate_address != 0) {
+      auto inserted = isolate_indices.emplace(isolate_address, isolates.size());
+      if (inserted.second) isolates.emplace_back(isolate_address, ModelObjectVector{});
+      isolates[inserted.first->second].second.push_back(thread.sp_id);
+    }
+  }
 
-  return S_OK;
+  ModelObjectVector results;
+  for (auto& isolate : isolates) {
+    winrt::com_ptr<IModelObject> sp_entry, sp_isolate, sp_thread_ids;
+    hr = CreateIsolateObject(sp_host_context, isolate.first, sp_isolate.put());
+    if (FAILED(hr)) return hr;
+    hr = CreateModelObjectList(sp_host_context, std::move(isolate.second),
+                               sp_thread_ids.put());
+    if (FAILED(hr)) return hr;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_host_context.get(),
+                                                      sp_entry.put());
+    if (FAILED(hr)) return hr;
+    hr = sp_entry->SetKey(L"isolate", sp_isolate.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    hr = sp_entry->SetKey(L"threads", sp_thread_ids.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    results.push_back(std::move(sp_entry));
+  }
+  return CreateModelObjectList(sp_host_context, std::move(results), sp_result.put());
 }
 
 HRESULT __stdcall CurrIsolateAlias::Call(IModelObject* p_context_object,
@@ -110,3 +211,16 @@ HRESULT __stdcall CurrIsolateAlias::Call(IModelObject* p_context_object,
   if (SUCCEEDED(hr)) *pp_result = sp_result.detach();
   return hr;
 }
+
+HRESULT __stdcall IsolatesAlias::Call(IModelObject* p_context_object,
+                                      ULONG64 arg_count,
+                                      IModelObject** pp_arguments,
+                                      IModelObject** pp_result,
+                                      IKeyStore** pp_metadata) noexcept {
+  HRESULT hr = S_OK;
+  *pp_result = nullptr;
+  winrt::com_ptr<IModelObject> sp_result;
+  hr = GetAllIsolates(sp_result);
+  if (SUCCEEDED(hr)) *pp_result = sp_result.detach();
+  return hr;
+}
@@ -2,6 +2,7 @@
 
 #include <crtdbg.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "../utilities.h"
 #include "extension.h"
@@ -10,9 +11,29 @@
 int GetIsolateKey(winrt::com_ptr<IDebugHostContext>& sp_ctx);
 HRESULT GetCurrentIsolate(winrt::com_ptr<IModelObject>& sp_result);
 
+struct ThreadInfo {
+  winrt::com_ptr<IModelObject> sp_id;
+  ULONG64 teb;
+};
+
+// Finds the id and TEB address of every thread in the current process.
+HRESULT GetThreads(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                   std::vector<ThreadInfo>& threads);
+
+// Returns a collection with an entry for each isolate that some thread of the
+// current process has entered, along with the ids of those threads.
+HRESULT GetAllIsolates(winrt::com_ptr<IModelObject>& sp_result);
+
 struct CurrIsolateAlias : winrt::implements<CurrIsolateAlias, IModelMethod> {
   HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
                          _In_reads_(arg_count) IModelObject** pp_arguments,
                          IModelObject** pp_result,
                          IKeyStore** pp_metadata) noexcept override;
 };
+
+struct IsolatesAlias : winrt::implements<IsolatesAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
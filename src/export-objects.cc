@@ -0,0 +1,73 @@
+#include "export-objects.h"
+#include "list-chunks.h"
+#include "object-table.h"
+#include "object.h"
+#include "trace.h"
+#include <unordered_set>
+
+namespace {
+
+// Space names are ASCII enum values such as "OLD_SPACE".
+std::string ToAscii(const std::wstring& value) {
+  std::string result;
+  for (wchar_t c : value) result.push_back(c < 0x80 ? static_cast<char>(c) : '?');
+  return result;
+}
+
+}  // namespace
+
+HRESULT __stdcall ExportObjectsAlias::Call(IModelObject* p_context_object,
+                                           ULONG64 arg_count,
+                                           _In_reads_(arg_count)
+                                               IModelObject** pp_arguments,
+                                           IModelObject** pp_result,
+                                           IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count != 1) return E_INVALIDARG;
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  std::vector<ChunkData> chunks;
+  hr = GetMemoryChunks(chunks);
+  if (FAILED(hr)) return hr;
+
+  VARIANT vt_path;
+  hr = pp_arguments[0]->GetIntrinsicValue(&vt_path);
+  if (FAILED(hr)) return hr;
+  if (vt_path.vt != VT_BSTR) {
+    ::VariantClear(&vt_path);
+    return E_INVALIDARG;
+  }
+  FILE* file = _wfopen(vt_path.bstrVal, L"wb");
+  ::VariantClear(&vt_path);
+  if (file == nullptr) return E_ACCESSDENIED;
+
+  ScopedTrace trace("ExportObjects");
+  MemReader reader = GetMemReader(sp_ctx);
+  LayoutCache cache;
+  // Each type is named from the first object of it that is seen, so only one
+  // object per type is decoded.
+  std::unordered_set<uint16_t> named_types;
+  ObjectTableWriter writer(file);
+  for (const ChunkData& chunk : chunks) {
+    writer.BeginChunk(chunk.area_start_address, ToAscii(chunk.space_name));
+    HeapObjectWalker walker(reader, cache, chunk.area_start_address,
+                            chunk.area_end_address, chunk.allocation_top,
+                            chunk.allocation_limit);
+    HeapObjectInfo object;
+    while (walker.Next(&object)) {
+      uint64_t address = object.tagged_ptr & ~kHeapObjectTagMask;
+      uint16_t instance_type = object.map->instance_type;
+      if (named_types.insert(instance_type).second) {
+        const ObjectLayout* layout = cache.GetLayout(walker.reader(), object.tagged_ptr);
+        if (layout != nullptr) writer.SetTypeName(instance_type, layout->type_name);
+      }
+      writer.Add(address, object.map->address, instance_type, object.size);
+    }
+  }
+  bool written = writer.Finish();
+  if (fclose(file) != 0) written = false;
+  if (!written) return E_FAIL;
+  return CreateULong64(writer.row_count(), pp_result);
+}
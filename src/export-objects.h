@@ -0,0 +1,16 @@
+#pragma once
+
+#include <crtdbg.h>
+#include "../utilities.h"
+#include "extension.h"
+#include "v8.h"
+
+// @$exportobjects(path) - writes the address, map, instance type, size, space
+// and chunk of every object in the heap to an object table (object-table.h)
+// at path, in one pass over the chunks. Returns the number of objects written.
+struct ExportObjectsAlias : winrt::implements<ExportObjectsAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
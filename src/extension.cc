@@ -1,13 +1,74 @@
 #include "../utilities.h"
 #include "extension.h"
+#include "code-census.h"
+#include "context-retention.h"
 #include "curisolate.h"
+#include "export-objects.h"
+#include "feedback-census.h"
+#include "find-objects.h"
+#include "find-refs.h"
+#include "fragmentation.h"
+#include "global-handles-model.h"
+#include "handle-scopes-model.h"
+#include "heap-stats.h"
+#include "js-stack-model.h"
+#include "largest.h"
 #include "list-chunks.h"
+#include "map-transitions.h"
 #include "object.h"
+#include "stats.h"
+#include "stats-model.h"
+#include "trace.h"
+#include <algorithm>
 #include <iostream>
 
 Extension* Extension::current_extension_ = nullptr;
 const wchar_t *pcur_isolate = L"curisolate";
+const wchar_t *pisolates = L"isolates";
 const wchar_t *plist_chunks = L"listchunks";
+const wchar_t *pfind_objects = L"findobjects";
+const wchar_t *pfind_string = L"findstring";
+const wchar_t *pfind_refs = L"findrefs";
+const wchar_t *pfeedback_census = L"feedbackcensus";
+const wchar_t *pcode_census = L"codecensus";
+const wchar_t *pmap_transitions = L"maptransitions";
+const wchar_t *pfragmentation = L"fragmentation";
+const wchar_t *plargest = L"largest";
+const wchar_t *pcontext_retention = L"contextretention";
+const wchar_t *pglobal_handles = L"globalhandles";
+const wchar_t *phandle_scopes = L"handlescopes";
+const wchar_t *pjs_stack = L"jsstack";
+const wchar_t *pexport_objects = L"exportobjects";
+const wchar_t *pheap_stats = L"heapstats";
+const wchar_t *ptype_cache_stats = L"typecachestats";
+const wchar_t *pv8dbg_stats = L"v8dbgstats";
+const wchar_t *pv8dbg_trace = L"v8dbgtrace";
+
+namespace {
+
+ULONG GetCurrentProcessSystemId() {
+  winrt::com_ptr<IDebugSystemObjects> sp_sys_objects;
+  ULONG proc_id = 0;
+  if (sp_debug_control.try_as(sp_sys_objects)) {
+    sp_sys_objects->GetCurrentProcessSystemId(&proc_id);
+  }
+  return proc_id;
+}
+
+// Without module events, whether a module found earlier is still loaded at
+// the same base. A process found to have no V8 is searched again, as it may
+// have loaded it since.
+bool IsModuleCurrent(const V8ModuleInfo& module_info) {
+  if (module_info.sp_module == nullptr) return false;
+  winrt::com_ptr<IDebugSymbols3> sp_symbols;
+  DEBUG_MODULE_PARAMETERS params;
+  ULONG64 base = module_info.key.base;
+  return sp_debug_control.try_as(sp_symbols) &&
+         SUCCEEDED(sp_symbols->GetModuleParameters(1, &base, 0, &params)) &&
+         params.TimeDateStamp == module_info.key.time_date_stamp;
+}
+
+}  // namespace
 
 bool CreateExtension() {
   _RPTF0(_CRT_WARN, "Entered CreateExtension\n");
@@ -35,96 +96,251 @@ void DestroyExtension() {
   return;
 }
 
-bool DoesTypeDeriveFromObject(winrt::com_ptr<IDebugHostType>& sp_type) {
+bool Extension::DoesTypeDeriveFromObject(winrt::com_ptr<IDebugHostType>& sp_type) {
   _bstr_t name;
   HRESULT hr = sp_type->GetName(name.GetAddress());
-  if (!SUCCEEDED(hr)) return false;
-  if (std::wstring(static_cast<wchar_t*>(name)) == L"v8::internal::Object") return true;
+  if (!SUCCEEDED(hr) || name.length() == 0) return false;
+  std::wstring type_name(static_cast<wchar_t*>(name));
+  if (type_name == L"v8::internal::Object") return true;
+
+  // Class hierarchies share most of their bases, so remember the answer for
+  // every type visited rather than walking the same bases again.
+  auto cached = derives_from_object_.find(type_name);
+  if (cached != derives_from_object_.end()) return cached->second;
 
+  bool derives = false;
   winrt::com_ptr<IDebugHostSymbolEnumerator> sp_super_class_enumerator;
   hr = sp_type->EnumerateChildren(SymbolKind::SymbolBaseClass, nullptr, sp_super_class_enumerator.put());
-  if (!SUCCEEDED(hr)) return false;
-
-  while (true) {
-    winrt::com_ptr<IDebugHostSymbol> sp_type_symbol;
-    if (sp_super_class_enumerator->GetNext(sp_type_symbol.put()) != S_OK) break;
-    winrt::com_ptr<IDebugHostBaseClass> sp_base_class = sp_type_symbol.as<IDebugHostBaseClass>();
-    winrt::com_ptr<IDebugHostType> sp_base_type;
-    hr = sp_base_class->GetType(sp_base_type.put());
-    if (!SUCCEEDED(hr)) continue;
-    if (DoesTypeDeriveFromObject(sp_base_type)) {
-      return true;
+  if (SUCCEEDED(hr)) {
+    while (!derives) {
+      winrt::com_ptr<IDebugHostSymbol> sp_type_symbol;
+      if (sp_super_class_enumerator->GetNext(sp_type_symbol.put()) != S_OK) break;
+      winrt::com_ptr<IDebugHostBaseClass> sp_base_class;
+      if (!sp_type_symbol.try_as(sp_base_class)) continue;
+      winrt::com_ptr<IDebugHostType> sp_base_type;
+      hr = sp_base_class->GetType(sp_base_type.put());
+      if (!SUCCEEDED(hr)) continue;
+      derives = DoesTypeDeriveFromObject(sp_base_type);
     }
   }
 
-  return false;
+  derives_from_object_[type_name] = derives;
+  return derives;
 }
 
-void Extension::TryRegisterType(winrt::com_ptr<IDebugHostType>& sp_type, std::u16string type_name) {
-  auto insertion_result = registered_handler_types_.insert({type_name, nullptr});
-  if (!insertion_result.second) return;
-  if (DoesTypeDeriveFromObject(sp_type)) {
+void Extension::RegisterTypes(const std::vector<std::u16string>& type_names) {
+  for (const std::u16string& type_name : type_names) {
+    auto insertion_result = registered_handler_types_.insert({type_name, nullptr});
+    if (!insertion_result.second) continue;
     winrt::com_ptr<IDebugHostTypeSignature> sp_object_type_signature;
     HRESULT hr = sp_debug_host_symbols_->CreateTypeSignature(reinterpret_cast<const wchar_t*>(type_name.c_str()), nullptr,
                                             sp_object_type_signature.put());
-    if (FAILED(hr)) return;
+    if (FAILED(hr)) continue;
     hr = sp_data_model_manager->RegisterModelForTypeSignature(
         sp_object_type_signature.get(), sp_object_data_model_.get());
+    if (FAILED(hr)) continue;
     insertion_result.first->second = sp_object_type_signature;
   }
 }
 
-winrt::com_ptr<IDebugHostType> Extension::GetV8ObjectType(winrt::com_ptr<IDebugHostContext>& sp_ctx, const char16_t* type_name) {
-  bool is_equal;
-  if (sp_v8_module_ctx_ == nullptr || !SUCCEEDED(sp_v8_module_ctx_->IsEqualTo(sp_ctx.get(), &is_equal)) || !is_equal) {
-    // Context changed; clear the dictionary.
-    sp_v8_object_types_.clear();
+void Extension::TryRegisterType(winrt::com_ptr<IDebugHostType>& sp_type, std::u16string type_name) {
+  if (registered_handler_types_.count(type_name) != 0) return;
+  if (DoesTypeDeriveFromObject(sp_type)) {
+    RegisterTypes({type_name});
+  } else {
+    registered_handler_types_.insert({type_name, nullptr});
+  }
+}
+
+void Extension::QueueTypeRegistration(winrt::com_ptr<IDebugHostModule>& sp_module,
+                                      const ModuleKey& key) {
+  for (const ModuleKey& registered : registered_modules_) {
+    if (registered == key) return;
+  }
+  registered_modules_.push_back(key);
+  modules_to_register_.emplace_back(key, sp_module);
+}
+
+void Extension::CancelTypeRegistration() {
+  // Forget the modules that weren't finished, so that they are passed over
+  // again from the start if they are found again.
+  for (const auto& pending : modules_to_register_) {
+    registered_modules_.erase(
+        std::remove(registered_modules_.begin(), registered_modules_.end(),
+                    pending.first),
+        registered_modules_.end());
   }
+  modules_to_register_.clear();
+  sp_type_enum_ = nullptr;
+}
 
-  GetV8Module(sp_ctx); // Will force the correct module to load
-  if (sp_v8_module_ == nullptr) return nullptr;
-
-  auto& dictionary_entry = sp_v8_object_types_[type_name];
-  if (dictionary_entry == nullptr) {
-    HRESULT hr = sp_v8_module_->FindTypeByName(reinterpret_cast<PCWSTR>(type_name), dictionary_entry.put());
-    if (SUCCEEDED(hr)) {
-      // It's too slow to enumerate all types in the v8 module up front and
-      // register type handlers for all of them, but we can opportunistically do
-      // so here for any types that we happen to be using. This makes the user
-      // experience a little nicer because you can avoid opening one extra level
-      // of data.
-      TryRegisterType(dictionary_entry, type_name);
+void Extension::ContinueTypeRegistration() {
+  // Registering a model can raise events that would start another slice.
+  if (modules_to_register_.empty() || registering_types_) return;
+  registering_types_ = true;
+  ScopedTrace trace("RegisterV8Types");
+  auto deadline = std::chrono::steady_clock::now() + kTypeRegistrationSlice;
+  std::vector<std::u16string> batch;
+  while (!modules_to_register_.empty() &&
+         std::chrono::steady_clock::now() < deadline) {
+    // The module at the front of the queue is the one being enumerated.
+    if (sp_type_enum_ == nullptr &&
+        FAILED(modules_to_register_.front().second->EnumerateChildren(
+            SymbolType, nullptr, sp_type_enum_.put()))) {
+      modules_to_register_.pop_front();
+      continue;
+    }
+    winrt::com_ptr<IDebugHostSymbol> sp_symbol;
+    if (sp_type_enum_->GetNext(sp_symbol.put()) != S_OK) {
+      sp_type_enum_ = nullptr;
+      modules_to_register_.pop_front();
+      continue;
+    }
+    winrt::com_ptr<IDebugHostType> sp_type;
+    TypeKind kind;
+    if (!sp_symbol.try_as(sp_type) || FAILED(sp_type->GetTypeKind(&kind)) ||
+        kind != TypeUDT) {
+      continue;
     }
+    _bstr_t name;
+    if (FAILED(sp_type->GetName(name.GetAddress())) || name.length() == 0) continue;
+    std::u16string type_name(reinterpret_cast<const char16_t*>(static_cast<wchar_t*>(name)));
+    // Only V8's internal classes can derive from v8::internal::Object.
+    if (type_name.compare(0, 14, u"v8::internal::") != 0) continue;
+    if (registered_handler_types_.count(type_name) != 0) continue;
+    if (DoesTypeDeriveFromObject(sp_type)) batch.push_back(std::move(type_name));
+  }
+  RegisterTypes(batch);
+  registering_types_ = false;
+}
+
+winrt::com_ptr<IDebugHostType> Extension::GetV8ObjectType(winrt::com_ptr<IDebugHostContext>& sp_ctx, const char16_t* type_name) {
+  ScopedTrace trace("GetV8ObjectType");
+  ScopedLatency latency(Timer::kTypeLookup);
+  V8ModuleInfo& module_info = GetV8ModuleInfo(sp_ctx);
+  if (module_info.sp_module == nullptr) return nullptr;
+
+  TypeCache::Outcome outcome;
+  auto sp_type = type_cache_.GetType(module_info.sp_module, module_info.key,
+                                     type_name, &outcome);
+  if (outcome == TypeCache::Outcome::kMiss) {
+    // The sliced pass registers type handlers for every type in the v8
+    // module, but it may not have reached this one yet. Only this type is
+    // registered here, as a command is waiting; the rest of the pass stays
+    // on the engine state callback.
+    TryRegisterType(sp_type, type_name);
   }
-  return dictionary_entry;
+  return sp_type;
 }
 
 winrt::com_ptr<IDebugHostModule> Extension::GetV8Module(winrt::com_ptr<IDebugHostContext>& sp_ctx) {
-  // Return the cached version if it exists and the context is the same
+  return GetV8ModuleInfo(sp_ctx).sp_module;
+}
+
+bool Extension::GetIsolateKeyLocation(winrt::com_ptr<IDebugHostContext>& sp_ctx, Location* p_location) {
+  V8ModuleInfo& module_info = GetV8ModuleInfo(sp_ctx);
+  if (module_info.sp_module == nullptr) return false;
+  *p_location = module_info.isolate_key_location;
+  return true;
+}
+
+void Extension::InvalidateModuleCache() {
+  _RPTF0(_CRT_WARN, "Modules changed; clearing cached V8 module state\n");
+  v8_modules_.clear();
+  CancelTypeRegistration();
+}
 
+void Extension::InvalidateTypeCache() {
+  _RPTF0(_CRT_WARN, "Symbols changed; clearing cached V8 types\n");
+  type_cache_.Clear();
+  teb_layout_ = TebLayout();
+  // Types that had no symbols before may have them now.
+  CancelTypeRegistration();
+  registered_modules_.clear();
+}
+
+HRESULT Extension::RegisterFunctionAlias(const wchar_t* name, IModelMethod* p_method) {
+  VARIANT vt_function;
+  vt_function.vt = VT_UNKNOWN;
+  vt_function.punkVal = p_method;
+
+  winrt::com_ptr<IModelObject> sp_function_model;
+  HRESULT hr = sp_data_model_manager->CreateIntrinsicObject(
+      ObjectMethod, &vt_function, sp_function_model.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_debug_host_extensibility_->CreateFunctionAlias(name, sp_function_model.get());
+  if (FAILED(hr)) return hr;
+  function_aliases_.emplace_back(name, sp_function_model);
+  return S_OK;
+}
+
+ArenaPtr Extension::GetDecodeArena() {
+  // Nothing would say when the target runs, so each call gets its own arena.
+  if (!watching_events_) return std::make_shared<Arena>();
+  std::lock_guard<std::mutex> lock(arena_mutex_);
+  if (decode_arena_ == nullptr) decode_arena_ = std::make_shared<Arena>();
+  return decode_arena_;
+}
+
+void Extension::ReleaseDecodeArena() {
+  std::lock_guard<std::mutex> lock(arena_mutex_);
+  // Objects still held by the debugger keep the old arena alive.
+  decode_arena_.reset();
+}
+
+std::shared_ptr<const CodeRangeIndex> Extension::GetCodeIndex() {
+  if (!watching_events_) return nullptr;
+  ULONG proc_id = GetCurrentProcessSystemId();
+  std::lock_guard<std::mutex> lock(code_index_mutex_);
+  auto it = code_indexes_.find(proc_id);
+  return it != code_indexes_.end() ? it->second : nullptr;
+}
+
+void Extension::SetCodeIndex(std::shared_ptr<const CodeRangeIndex> index) {
+  ULONG proc_id = GetCurrentProcessSystemId();
+  std::lock_guard<std::mutex> lock(code_index_mutex_);
+  code_indexes_[proc_id] = std::move(index);
+}
+
+void Extension::ReleaseCodeIndexes() {
+  std::lock_guard<std::mutex> lock(code_index_mutex_);
+  code_indexes_.clear();
+}
+
+std::shared_ptr<HistogramCache> Extension::GetHistogramCache() {
+  // Cached type names would outlive a reload of V8 that nothing reported.
+  if (!watching_events_) return std::make_shared<HistogramCache>();
+  ULONG proc_id = GetCurrentProcessSystemId();
+  std::lock_guard<std::mutex> lock(histogram_cache_mutex_);
+  std::shared_ptr<HistogramCache>& cache = histogram_caches_[proc_id];
+  if (cache == nullptr) cache = std::make_shared<HistogramCache>();
+  return cache;
+}
+
+void Extension::ReleaseHistogramCaches() {
+  std::lock_guard<std::mutex> lock(histogram_cache_mutex_);
+  histogram_caches_.clear();
+}
+
+V8ModuleInfo& Extension::GetV8ModuleInfo(winrt::com_ptr<IDebugHostContext>& sp_ctx) {
   // Note: Context will often have the CUSTOM flag set, which never compares equal.
   // So for now DON'T compare by context, but by proc_id. (An API is in progress
   // to compare by address space, which should be usable when shipped).
-  /*
-  if (sp_v8_module_ != nullptr) {
-    bool is_equal;
-    if (SUCCEEDED(sp_v8_module_ctx_->IsEqualTo(sp_ctx.get(), &is_equal)) && is_equal) {
-      return sp_v8_module_;
-    } else {
-      sp_v8_module_ = nullptr;
-      sp_v8_module_ctx_ = nullptr;
-    }
-  }
-  */
-  winrt::com_ptr<IDebugSystemObjects> sp_sys_objects;
-  ULONG proc_id = 0;
-  if (sp_debug_control.try_as(sp_sys_objects))
-  {
-    if(SUCCEEDED(sp_sys_objects->GetCurrentProcessSystemId(&proc_id))) {
-      if (proc_id == v8_module_proc_id_ && sp_v8_module_ != nullptr) return sp_v8_module_;
-    }
+  ULONG proc_id = GetCurrentProcessSystemId();
+
+  // Entries stay valid until a module load/unload clears them, so this only
+  // searches the process's modules once, whether or not V8 is found.
+  auto insertion_result = v8_modules_.try_emplace(proc_id);
+  V8ModuleInfo& module_info = insertion_result.first->second;
+  if (!insertion_result.second) {
+    if (watching_events_ || IsModuleCurrent(module_info)) return module_info;
+    module_info = V8ModuleInfo();
   }
 
+  ScopedTrace trace("FindV8Module");
+  ScopedLatency latency(Timer::kModuleDiscovery);
+  IncrementCounter(Counter::kModuleDiscoveries);
+
   // Loop through the modules looking for the one that holds the "isolate_key_"
   winrt::com_ptr<IDebugHostSymbolEnumerator> sp_enum;
   if (SUCCEEDED(sp_debug_host_symbols_->EnumerateModules(sp_ctx.get(), sp_enum.put()))) {
@@ -142,9 +358,17 @@ winrt::com_ptr<IDebugHostModule> Extension::GetV8Module(winrt::com_ptr<IDebugHos
         // The below symbol is specific to the main V8 module
         hr = sp_module->FindSymbolByName(L"isolate_key_", sp_isolate_sym.put());
         if (SUCCEEDED(hr)) {
-          sp_v8_module_ = sp_module;
-          sp_v8_module_ctx_ = sp_ctx;
-          v8_module_proc_id_ = proc_id;
+          winrt::com_ptr<IDebugHostData> sp_isolate_key_data;
+          if (!sp_isolate_sym.try_as(sp_isolate_key_data) ||
+              FAILED(sp_isolate_key_data->GetLocation(&module_info.isolate_key_location))) {
+            continue;
+          }
+          module_info.sp_module = sp_module;
+          module_info.key = GetModuleKey(sp_module);
+          // Register the rest of V8's object types a slice at a time, each
+          // time the target stops. Each image is passed over once, as
+          // registration is by name.
+          QueueTypeRegistration(sp_module, module_info.key);
           // Output location
           BSTR module_name;
           if(SUCCEEDED(sp_module->GetImageName(true, &module_name))) {
@@ -157,8 +381,76 @@ winrt::com_ptr<IDebugHostModule> Extension::GetV8Module(winrt::com_ptr<IDebugHos
       }
     }
   }
-  // This will be the located module, or still nullptr if above fails
-  return sp_v8_module_;
+  return module_info;
+}
+
+static void OnModulesChanged() {
+  if (Extension::current_extension_ != nullptr) {
+    Extension::current_extension_->InvalidateModuleCache();
+    // Instance type numbers, and so the cached type names, come from V8.
+    Extension::current_extension_->ReleaseHistogramCaches();
+  }
+}
+
+static void OnSymbolsChanged() {
+  if (Extension::current_extension_ != nullptr) {
+    Extension::current_extension_->InvalidateModuleCache();
+    Extension::current_extension_->InvalidateTypeCache();
+  }
+}
+
+HRESULT ModuleEventCallbacks::GetInterestMask(PULONG mask) {
+  *mask = DEBUG_EVENT_LOAD_MODULE | DEBUG_EVENT_UNLOAD_MODULE |
+          DEBUG_EVENT_EXIT_PROCESS | DEBUG_EVENT_CHANGE_SYMBOL_STATE |
+          DEBUG_EVENT_CHANGE_ENGINE_STATE;
+  return S_OK;
+}
+
+HRESULT ModuleEventCallbacks::LoadModule(ULONG64 image_file_handle,
+                                         ULONG64 base_offset, ULONG module_size,
+                                         PCSTR module_name, PCSTR image_name,
+                                         ULONG check_sum,
+                                         ULONG time_date_stamp) {
+  OnModulesChanged();
+  return DEBUG_STATUS_NO_CHANGE;
+}
+
+HRESULT ModuleEventCallbacks::UnloadModule(PCSTR image_base_name,
+                                           ULONG64 base_offset) {
+  OnModulesChanged();
+  return DEBUG_STATUS_NO_CHANGE;
+}
+
+HRESULT ModuleEventCallbacks::ExitProcess(ULONG exit_code) {
+  OnModulesChanged();
+  return DEBUG_STATUS_NO_CHANGE;
+}
+
+HRESULT ModuleEventCallbacks::ChangeSymbolState(ULONG flags, ULONG64 argument) {
+  // Reloading symbols invalidates the symbols and types we have resolved.
+  if (flags & (DEBUG_CSS_LOADS | DEBUG_CSS_UNLOADS)) {
+    OnSymbolsChanged();
+  }
+  return DEBUG_STATUS_NO_CHANGE;
+}
+
+HRESULT ModuleEventCallbacks::ChangeEngineState(ULONG flags, ULONG64 argument) {
+  // Anything decoded so far describes memory the target is about to change.
+  if ((flags & DEBUG_CES_EXECUTION_STATUS) &&
+      (argument & DEBUG_STATUS_MASK) != DEBUG_STATUS_BREAK &&
+      Extension::current_extension_ != nullptr) {
+    Extension::current_extension_->ReleaseDecodeArena();
+    Extension::current_extension_->ReleaseCodeIndexes();
+  }
+  // Stopping leaves the engine thread waiting for commands, so use the time
+  // to register more types.
+  if ((flags & DEBUG_CES_EXECUTION_STATUS) &&
+      (argument & DEBUG_STATUS_MASK) == DEBUG_STATUS_BREAK &&
+      (argument & DEBUG_STATUS_INSIDE_WAIT) == 0 &&
+      Extension::current_extension_ != nullptr) {
+    Extension::current_extension_->ContinueTypeRegistration();
+  }
+  return DEBUG_STATUS_NO_CHANGE;
 }
 
 bool Extension::Initialize() {
@@ -168,9 +460,22 @@ bool Extension::Initialize() {
   if (!sp_debug_host.try_as(sp_debug_host_symbols_)) return false;
   if (!sp_debug_host.try_as(sp_debug_host_extensibility_)) return false;
 
+  // The caches below are kept current by module and execution events. They
+  // come through a client of our own, so that callbacks set on the shared
+  // client are left alone. Without them the extension still loads, but
+  // doesn't keep anything between calls that an event would have cleared.
+  if (SUCCEEDED(sp_debug_client->CreateClient(sp_event_client_.put())) &&
+      SUCCEEDED(sp_event_client_->SetEventCallbacks(&module_event_callbacks_))) {
+    watching_events_ = true;
+  } else {
+    _RPTF0(_CRT_WARN, "No debugger events; caches are checked on every call\n");
+    sp_event_client_ = nullptr;
+  }
+
+  HRESULT hr = S_OK;
   // Create an instance of the DataModel 'parent' for v8::internal::Object types
   auto object_data_model{winrt::make<V8ObjectDataModel>()};
-  HRESULT hr = sp_data_model_manager->CreateDataModelObject(
+  hr = sp_data_model_manager->CreateDataModelObject(
       object_data_model.get(), sp_object_data_model_.put());
   if (FAILED(hr)) return false;
   hr = sp_object_data_model_->SetConcept(__uuidof(IStringDisplayableConcept),
@@ -230,39 +535,63 @@ bool Extension::Initialize() {
   hr = sp_data_model_manager->RegisterModelForTypeSignature(
       sp_maybe_handle_type_signature_.get(), sp_local_data_model_.get());
 
-  // Register the @$currisolate function alias.
-  auto curr_isolate_function{winrt::make<CurrIsolateAlias>()};
-
-  VARIANT vt_curr_isolate_function;
-  vt_curr_isolate_function.vt = VT_UNKNOWN;
-  vt_curr_isolate_function.punkVal =
-      static_cast<IModelMethod*>(curr_isolate_function.get());
-
-  hr = sp_data_model_manager->CreateIntrinsicObject(
-      ObjectMethod, &vt_curr_isolate_function, sp_curr_isolate_model_.put());
-  hr = sp_debug_host_extensibility_->CreateFunctionAlias(pcur_isolate,
-                                                     sp_curr_isolate_model_.get());
-
-  // Register the @$listchunks function alias.
-  auto list_chunks_function{winrt::make<ListChunksAlias>()};
-
-  VARIANT vt_list_chunks_function;
-  vt_list_chunks_function.vt = VT_UNKNOWN;
-  vt_list_chunks_function.punkVal =
-      static_cast<IModelMethod*>(list_chunks_function.get());
+  // Register the function aliases, e.g. @$curisolate().
+  hr = RegisterFunctionAlias(pcur_isolate, winrt::make<CurrIsolateAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pisolates, winrt::make<IsolatesAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(plist_chunks, winrt::make<ListChunksAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pfind_objects, winrt::make<FindObjectsAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pfind_string, winrt::make<FindStringAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pfind_refs, winrt::make<FindRefsAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pfeedback_census, winrt::make<FeedbackCensusAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pcode_census, winrt::make<CodeCensusAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pmap_transitions, winrt::make<MapTransitionsAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pfragmentation, winrt::make<FragmentationAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(plargest, winrt::make<LargestAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pcontext_retention, winrt::make<ContextRetentionAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pglobal_handles, winrt::make<GlobalHandlesAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(phandle_scopes, winrt::make<HandleScopesAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pjs_stack, winrt::make<JsStackAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pexport_objects, winrt::make<ExportObjectsAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pheap_stats, winrt::make<HeapStatsAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(ptype_cache_stats, winrt::make<TypeCacheStatsAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pv8dbg_stats, winrt::make<V8DbgStatsAlias>().get());
+  if (FAILED(hr)) return false;
+  hr = RegisterFunctionAlias(pv8dbg_trace, winrt::make<V8DbgTraceAlias>().get());
+  if (FAILED(hr)) return false;
 
-  hr = sp_data_model_manager->CreateIntrinsicObject(
-      ObjectMethod, &vt_list_chunks_function, sp_list_chunks_model_.put());
-  hr = sp_debug_host_extensibility_->CreateFunctionAlias(plist_chunks,
-                                                     sp_list_chunks_model_.get());
+  // If a target is already available, find V8 now to start registering types.
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  if (SUCCEEDED(sp_debug_host->GetCurrentContext(sp_ctx.put()))) {
+    GetV8Module(sp_ctx);
+  }
 
   return !FAILED(hr);
 }
 
 Extension::~Extension() {
   _RPTF0(_CRT_WARN, "Entered Extension::~Extension\n");
-  sp_debug_host_extensibility_->DestroyFunctionAlias(pcur_isolate);
-  sp_debug_host_extensibility_->DestroyFunctionAlias(plist_chunks);
+  if (sp_event_client_ != nullptr) sp_event_client_->SetEventCallbacks(nullptr);
+  for (const auto& function_alias : function_aliases_) {
+    sp_debug_host_extensibility_->DestroyFunctionAlias(function_alias.first.c_str());
+  }
 
   for (const auto& registered : registered_handler_types_) {
     if (registered.second != nullptr) {
@@ -1,7 +1,51 @@
 #pragma once
 
 #include "../utilities.h"
+#include "arena.h"
+#include "heap-sample.h"
+#include "js-stack.h"
+#include "type-cache.h"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
+
+// Clears cached module state whenever the set of loaded modules (or their
+// symbols) changes, releases the per-stop caches when the target resumes, and
+// continues registering V8's types when it stops.
+// Owned by the Extension, so doesn't reference count.
+struct ModuleEventCallbacks : DebugBaseEventCallbacks {
+  ULONG __stdcall AddRef() override { return 1; }
+  ULONG __stdcall Release() override { return 1; }
+  HRESULT __stdcall GetInterestMask(PULONG mask) override;
+  HRESULT __stdcall LoadModule(ULONG64 image_file_handle, ULONG64 base_offset,
+                               ULONG module_size, PCSTR module_name,
+                               PCSTR image_name, ULONG check_sum,
+                               ULONG time_date_stamp) override;
+  HRESULT __stdcall UnloadModule(PCSTR image_base_name,
+                                 ULONG64 base_offset) override;
+  HRESULT __stdcall ExitProcess(ULONG exit_code) override;
+  HRESULT __stdcall ChangeSymbolState(ULONG flags, ULONG64 argument) override;
+  HRESULT __stdcall ChangeEngineState(ULONG flags, ULONG64 argument) override;
+};
+
+// What we have resolved about V8 in one process. A null sp_module records
+// that the process has no V8 module, so it isn't searched for again.
+struct V8ModuleInfo {
+  winrt::com_ptr<IDebugHostModule> sp_module;
+  ModuleKey key;
+  Location isolate_key_location;
+};
+
+// Where the TLS slot arrays are in a _TEB, which belongs to the OS rather than
+// to any one V8 module. Resolved the first time a thread's isolate is read.
+struct TebLayout {
+  bool resolved = false;
+  ULONG64 tls_slots_offset = 0;
+  ULONG64 tls_expansion_slots_offset = 0;
+};
 
 class Extension {
  public:
@@ -9,7 +53,32 @@ class Extension {
   ~Extension();
   winrt::com_ptr<IDebugHostModule> GetV8Module(winrt::com_ptr<IDebugHostContext>& sp_ctx);
   winrt::com_ptr<IDebugHostType> Extension::GetV8ObjectType(winrt::com_ptr<IDebugHostContext>& sp_ctx, const char16_t* type_name = u"v8::internal::Object");
+  bool GetIsolateKeyLocation(winrt::com_ptr<IDebugHostContext>& sp_ctx, Location* p_location);
   void TryRegisterType(winrt::com_ptr<IDebugHostType>& sp_type, std::u16string type_name);
+  bool DoesTypeDeriveFromObject(winrt::com_ptr<IDebugHostType>& sp_type);
+  void InvalidateModuleCache();
+  void InvalidateTypeCache();
+  HRESULT RegisterFunctionAlias(const wchar_t* name, IModelMethod* p_method);
+  V8ModuleInfo& GetV8ModuleInfo(winrt::com_ptr<IDebugHostContext>& sp_ctx);
+  // The arena that objects decoded during the current stop are allocated
+  // from. A new one is started after the target runs.
+  ArenaPtr GetDecodeArena();
+  void ReleaseDecodeArena();
+  // The code index @$jsstack() built for the current process during this
+  // stop, or null if there isn't one yet. Dropped when the target runs.
+  std::shared_ptr<const CodeRangeIndex> GetCodeIndex();
+  void SetCodeIndex(std::shared_ptr<const CodeRangeIndex> index);
+  void ReleaseCodeIndexes();
+  // What @$heapstats() found in each chunk of the current process. Unlike the
+  // per-stop caches it is kept while the target runs, as each entry is
+  // checked against its chunk's contents before it is used.
+  std::shared_ptr<HistogramCache> GetHistogramCache();
+  void ReleaseHistogramCaches();
+  // Registers the type handler for more of the types of the V8 modules found
+  // so far, stopping after kTypeRegistrationSlice. Debug host objects are
+  // only used on the engine thread, so the pass over a module's types is
+  // done a slice at a time when the debugger would otherwise be idle.
+  void ContinueTypeRegistration();
   static Extension* current_extension_;
 
   winrt::com_ptr<IDebugHostMemory2> sp_debug_host_memory_;
@@ -22,13 +91,37 @@ class Extension {
   winrt::com_ptr<IDebugHostTypeSignature> sp_maybe_handle_type_signature_;
   winrt::com_ptr<IModelObject> sp_object_data_model_;
   winrt::com_ptr<IModelObject> sp_local_data_model_;
-  winrt::com_ptr<IModelObject> sp_curr_isolate_model_;
-  winrt::com_ptr<IModelObject> sp_list_chunks_model_;
+  TypeCache type_cache_;
+  TebLayout teb_layout_;
 
  private:
-  winrt::com_ptr<IDebugHostModule> sp_v8_module_;
-  std::unordered_map<std::u16string, winrt::com_ptr<IDebugHostType>> sp_v8_object_types_;
+  void RegisterTypes(const std::vector<std::u16string>& type_names);
+  void QueueTypeRegistration(winrt::com_ptr<IDebugHostModule>& sp_module,
+                             const ModuleKey& key);
+  void CancelTypeRegistration();
+
+  static constexpr std::chrono::milliseconds kTypeRegistrationSlice{20};
+
+  // Keyed by process id.
+  std::unordered_map<ULONG, V8ModuleInfo> v8_modules_;
   std::unordered_map<std::u16string, winrt::com_ptr<IDebugHostTypeSignature>> registered_handler_types_;
-  winrt::com_ptr<IDebugHostContext> sp_v8_module_ctx_;
-  ULONG v8_module_proc_id_;
+  std::unordered_map<std::wstring, bool> derives_from_object_;
+  // Modules whose types have been, or are being, registered.
+  std::vector<ModuleKey> registered_modules_;
+  // Modules still to be passed over, and the types left in the current one.
+  std::deque<std::pair<ModuleKey, winrt::com_ptr<IDebugHostModule>>> modules_to_register_;
+  winrt::com_ptr<IDebugHostSymbolEnumerator> sp_type_enum_;
+  bool registering_types_ = false;
+  std::vector<std::pair<std::wstring, winrt::com_ptr<IModelObject>>> function_aliases_;
+  ModuleEventCallbacks module_event_callbacks_;
+  winrt::com_ptr<IDebugClient> sp_event_client_;  // Receives the callbacks.
+  bool watching_events_ = false;
+  ArenaPtr decode_arena_;
+  std::mutex arena_mutex_;  // Guards decode_arena_.
+  // Keyed by process id.
+  std::unordered_map<ULONG, std::shared_ptr<const CodeRangeIndex>> code_indexes_;
+  std::mutex code_index_mutex_;  // Guards code_indexes_.
+  // Keyed by process id.
+  std::unordered_map<ULONG, std::shared_ptr<HistogramCache>> histogram_caches_;
+  std::mutex histogram_cache_mutex_;  // Guards histogram_caches_.
 };
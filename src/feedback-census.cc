@@ -0,0 +1,377 @@
+#include "feedback-census.h"
+#include "object.h"
+#include "trace.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint64_t kDefaultFunctionCount = 20;
+
+// FeedbackMetadata packs each entry's FeedbackSlotKind into 32-bit words,
+// this many bits per kind and as many kinds as fit in a word.
+constexpr int kSlotKindBits = 5;
+constexpr int kSlotKindsPerWord = 32 / kSlotKindBits;
+
+enum class IcState {
+  kOther,  // Not an IC's feedback entry, such as a call count.
+  kUninitialized,
+  kMonomorphic,
+  kPolymorphic,
+  kMegamorphic,
+};
+
+struct IcCounts {
+  void Add(IcState state) {
+    switch (state) {
+      case IcState::kUninitialized: ++uninitialized; break;
+      case IcState::kMonomorphic: ++monomorphic; break;
+      case IcState::kPolymorphic: ++polymorphic; break;
+      case IcState::kMegamorphic: ++megamorphic; break;
+      default: break;
+    }
+  }
+
+  uint64_t uninitialized = 0;
+  uint64_t monomorphic = 0;
+  uint64_t polymorphic = 0;
+  uint64_t megamorphic = 0;
+};
+
+// How a FeedbackSlotKind lays out its entries in a vector.
+struct SlotShape {
+  uint8_t entries = 0;  // 0 for kInvalid, which only marks extra entries.
+  bool is_ic = false;   // Whether the first entry holds IC state.
+};
+
+// Indexed by FeedbackSlotKind value.
+using SlotShapes = std::vector<SlotShape>;
+
+SlotShape GetSlotShape(const std::wstring& kind) {
+  if (kind == L"kInvalid") return {};
+  if (kind == L"kInstanceOf") return {1, true};
+  // Counters, type hints and literal sites take one entry and aren't ICs.
+  if (kind == L"kForIn" || kind == L"kCompareOp" || kind == L"kBinaryOp" ||
+      kind == L"kLiteral" || kind == L"kTypeOf" || kind == L"kJumpLoop" ||
+      kind == L"kCreateClosure" || kind == L"kTypeProfile") {
+    return {1, false};
+  }
+  // Every other kind is an IC with a feedback entry and an extra entry.
+  return {2, true};
+}
+
+struct FunctionFeedback {
+  uint64_t shared_function_info = 0;
+  uint64_t vectors = 0;
+  IcCounts counts;
+};
+
+// One pass over the heap. Which entries are ICs is read from each function's
+// FeedbackMetadata, once per SharedFunctionInfo, and only the feedback entry
+// of each IC is classified, the way V8 reads IC state: a weak reference is
+// monomorphic, a WeakFixedArray of maps is polymorphic, and the megamorphic
+// and uninitialized symbols mark those states.
+class FeedbackCensus {
+ public:
+  FeedbackCensus(const MemReader& reader, SlotShapes shapes)
+      : reader_(reader), shapes_(std::move(shapes)) {}
+
+  void VisitChunk(const ChunkData& chunk) {
+    HeapObjectWalker walker(reader_, cache_, chunk.area_start_address,
+                            chunk.area_end_address, chunk.allocation_top,
+                            chunk.allocation_limit);
+    HeapObjectInfo object;
+    while (walker.Next(&object)) {
+      if (IsFeedbackVector(walker, object)) VisitVector(walker, object);
+    }
+  }
+
+  uint64_t vectors() const { return vectors_; }
+  uint64_t skipped_vectors() const { return skipped_vectors_; }
+  const IcCounts& totals() const { return totals_; }
+
+  // The count functions with the most megamorphic, then polymorphic, ICs.
+  std::vector<FunctionFeedback> GetTopFunctions(size_t count) const {
+    std::vector<FunctionFeedback> functions;
+    functions.reserve(functions_.size());
+    for (const auto& entry : functions_) functions.push_back(entry.second);
+    auto worse = [](const FunctionFeedback& a, const FunctionFeedback& b) {
+      if (a.counts.megamorphic != b.counts.megamorphic) {
+        return a.counts.megamorphic > b.counts.megamorphic;
+      }
+      return a.counts.polymorphic > b.counts.polymorphic;
+    };
+    count = std::min(count, functions.size());
+    std::partial_sort(functions.begin(), functions.begin() + count,
+                      functions.end(), worse);
+    functions.resize(count);
+    return functions;
+  }
+
+ private:
+  bool IsFeedbackVector(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    uint16_t instance_type = object.map->instance_type;
+    auto it = is_vector_type_.find(instance_type);
+    if (it != is_vector_type_.end()) return it->second;
+    const ObjectLayout* layout = cache_.GetLayout(walker.reader(), object.tagged_ptr);
+    bool is_vector = layout != nullptr &&
+                     layout->type_name == "v8::internal::FeedbackVector";
+    is_vector_type_.emplace(instance_type, is_vector);
+    return is_vector;
+  }
+
+  void VisitVector(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    const MemReader& reader = walker.reader();
+    const ObjectLayout* layout = cache_.GetLayout(reader, object.tagged_ptr);
+    if (layout == nullptr) return;
+    const FieldLayout* length_field = layout->FindField("length");
+    const FieldLayout* slots_field = layout->FindField("raw_feedback_slots");
+    const FieldLayout* sfi_field = layout->FindField("shared_function_info");
+    int64_t length;
+    if (length_field == nullptr || slots_field == nullptr ||
+        !cache_.ReadInteger(reader, object.tagged_ptr, *length_field, &length) ||
+        length < 0 ||
+        slots_field->offset + length * cache_.tagged_size() > object.size) {
+      return;
+    }
+    uint64_t start = object.tagged_ptr & ~kHeapObjectTagMask;
+    if (!cache_.ReadTaggedArray(reader, start + slots_field->offset,
+                                static_cast<size_t>(length), &slots_)) {
+      return;
+    }
+    uint64_t sfi = 0;
+    const std::vector<uint8_t>* kinds = nullptr;
+    if (sfi_field != nullptr &&
+        cache_.ReadTagged(reader, start + sfi_field->offset, &sfi)) {
+      kinds = GetSlotKinds(sfi);
+    }
+    // Without the slot kinds there's no telling feedback entries from extra
+    // ones.
+    if (kinds == nullptr || kinds->size() != slots_.size()) {
+      ++skipped_vectors_;
+      return;
+    }
+
+    ++vectors_;
+    // Grouped by function, as each closure of a function can have its own
+    // vector.
+    FunctionFeedback& function = functions_[sfi];
+    function.shared_function_info = sfi;
+    ++function.vectors;
+    for (size_t i = 0; i < slots_.size();) {
+      uint8_t kind = (*kinds)[i];
+      SlotShape shape = kind < shapes_.size() ? shapes_[kind] : SlotShape{};
+      if (shape.entries == 0) break;  // The metadata doesn't match the vector.
+      if (shape.is_ic) {
+        IcState state = Classify(slots_[i]);
+        totals_.Add(state);
+        function.counts.Add(state);
+      }
+      i += shape.entries;
+    }
+  }
+
+  // Reads the kind of each vector entry from a SharedFunctionInfo's
+  // FeedbackMetadata, or returns null if it can't be read.
+  const std::vector<uint8_t>* GetSlotKinds(uint64_t sfi) {
+    auto it = slot_kinds_.find(sfi);
+    if (it != slot_kinds_.end()) return it->second.empty() ? nullptr : &it->second;
+    std::vector<uint8_t>& kinds = slot_kinds_[sfi];
+    ReadSlotKinds(sfi, &kinds);
+    return kinds.empty() ? nullptr : &kinds;
+  }
+
+  void ReadSlotKinds(uint64_t sfi, std::vector<uint8_t>* p_kinds) {
+    const ObjectLayout* sfi_layout = cache_.GetLayout(reader_, sfi);
+    const FieldLayout* metadata_field =
+        sfi_layout == nullptr
+            ? nullptr
+            : sfi_layout->FindField("outer_scope_info_or_feedback_metadata");
+    uint64_t metadata;
+    if (metadata_field == nullptr ||
+        !cache_.ReadTagged(reader_,
+                           (sfi & ~kHeapObjectTagMask) + metadata_field->offset,
+                           &metadata)) {
+      return;
+    }
+    const ObjectLayout* layout = cache_.GetLayout(reader_, metadata);
+    if (layout == nullptr ||
+        layout->type_name != "v8::internal::FeedbackMetadata") {
+      return;
+    }
+    const FieldLayout* count_field = layout->FindField("slot_count");
+    int64_t slot_count;
+    if (count_field == nullptr ||
+        !cache_.ReadInteger(reader_, metadata, *count_field, &slot_count) ||
+        slot_count <= 0 || slot_count > kMaxSlotCount) {
+      return;
+    }
+
+    // The kinds follow the header, which is padded to a whole tagged value.
+    uint32_t header_end = 0;
+    for (const FieldLayout& field : layout->fields) {
+      header_end = std::max(header_end, field.is_array ? field.offset
+                                                       : field.offset + field.size);
+    }
+    uint32_t tagged_size = static_cast<uint32_t>(cache_.tagged_size());
+    header_end = (header_end + tagged_size - 1) / tagged_size * tagged_size;
+    size_t count = static_cast<size_t>(slot_count);
+    std::vector<uint32_t> words((count + kSlotKindsPerWord - 1) / kSlotKindsPerWord);
+    if (!reader_((metadata & ~kHeapObjectTagMask) + header_end,
+                 words.size() * sizeof(uint32_t),
+                 reinterpret_cast<uint8_t*>(words.data()))) {
+      return;
+    }
+    p_kinds->resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      uint32_t word = words[i / kSlotKindsPerWord];
+      (*p_kinds)[i] = static_cast<uint8_t>(
+          (word >> (i % kSlotKindsPerWord * kSlotKindBits)) &
+          ((1u << kSlotKindBits) - 1));
+    }
+  }
+
+  IcState Classify(uint64_t value) {
+    if ((value & kHeapObjectTagMask) == kWeakHeapObjectTag) {
+      return IcState::kMonomorphic;  // Includes cleared references.
+    }
+    if ((value & kHeapObjectTagMask) != kHeapObjectTag) return IcState::kOther;
+
+    auto it = strong_states_.find(value);
+    if (it != strong_states_.end()) return it->second;
+    IcState state = IcState::kOther;
+    const ObjectLayout* layout = cache_.GetLayout(reader_, value);
+    if (layout == nullptr) {
+      // Leave it out of the cache, as the value may be garbage.
+      return state;
+    }
+    if (layout->type_name == "v8::internal::WeakFixedArray") {
+      state = IcState::kPolymorphic;
+    } else if (layout->type_name == "v8::internal::Symbol") {
+      // The sentinels are only recognizable by their root names, so decode
+      // each symbol once.
+      std::string brief = GetObjectBrief(reader_, value);
+      if (brief.find("megamorphic_symbol") != std::string::npos) {
+        state = IcState::kMegamorphic;
+      } else if (brief.find("uninitialized_symbol") != std::string::npos) {
+        state = IcState::kUninitialized;
+      }
+    }
+    // Polymorphic arrays are unique to their IC, so only cache values that
+    // are likely to be seen again.
+    if (state != IcState::kPolymorphic) strong_states_.emplace(value, state);
+    return state;
+  }
+
+  // Larger than any function's metadata, to reject garbage counts.
+  static constexpr int64_t kMaxSlotCount = 1 << 20;
+
+  MemReader reader_;
+  SlotShapes shapes_;
+  LayoutCache cache_;
+  std::unordered_map<uint16_t, bool> is_vector_type_;
+  std::unordered_map<uint64_t, IcState> strong_states_;
+  std::unordered_map<uint64_t, FunctionFeedback> functions_;
+  // By SharedFunctionInfo; empty if its metadata couldn't be read.
+  std::unordered_map<uint64_t, std::vector<uint8_t>> slot_kinds_;
+  std::vector<uint64_t> slots_;
+  IcCounts totals_;
+  uint64_t vectors_ = 0;
+  uint64_t skipped_vectors_ = 0;
+};
+
+SlotShapes GetSlotShapes(winrt::com_ptr<IDebugHostContext>& sp_ctx) {
+  SlotShapes shapes;
+  winrt::com_ptr<IDebugHostType> sp_type =
+      Extension::current_extension_->GetV8ObjectType(
+          sp_ctx, u"v8::internal::FeedbackSlotKind");
+  std::unordered_map<int64_t, std::wstring> names;
+  if (sp_type == nullptr || !GetEnumNames(sp_type, &names)) return shapes;
+  shapes.resize(size_t{1} << kSlotKindBits);
+  for (const auto& entry : names) {
+    if (entry.first >= 0 && static_cast<size_t>(entry.first) < shapes.size()) {
+      shapes[static_cast<size_t>(entry.first)] = GetSlotShape(entry.second);
+    }
+  }
+  return shapes;
+}
+
+HRESULT SetCounts(IModelObject* p_object, const IcCounts& counts) {
+  HRESULT hr = SetULong64Key(p_object, L"megamorphic", counts.megamorphic);
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(p_object, L"polymorphic", counts.polymorphic);
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(p_object, L"monomorphic", counts.monomorphic);
+  if (FAILED(hr)) return hr;
+  return SetULong64Key(p_object, L"uninitialized", counts.uninitialized);
+}
+
+}  // namespace
+
+HRESULT __stdcall FeedbackCensusAlias::Call(IModelObject* p_context_object,
+                                            ULONG64 arg_count,
+                                            _In_reads_(arg_count)
+                                                IModelObject** pp_arguments,
+                                            IModelObject** pp_result,
+                                            IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count > 1) return E_INVALIDARG;
+  uint64_t function_count = kDefaultFunctionCount;
+  if (arg_count == 1) {
+    VARIANT vt_count;
+    HRESULT hr = pp_arguments[0]->GetIntrinsicValueAs(VT_UI8, &vt_count);
+    if (FAILED(hr)) return hr;
+    function_count = vt_count.ullVal;
+  }
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  std::vector<ChunkData> chunks;
+  hr = GetMemoryChunks(chunks);
+  if (FAILED(hr)) return hr;
+
+  SlotShapes shapes = GetSlotShapes(sp_ctx);
+  if (shapes.empty()) return E_FAIL;  // No FeedbackSlotKind in the symbols.
+
+  ScopedTrace trace("FeedbackCensus");
+  FeedbackCensus census(GetMemReader(sp_ctx), std::move(shapes));
+  for (const ChunkData& chunk : chunks) census.VisitChunk(chunk);
+
+  ModelObjectVector functions;
+  for (const FunctionFeedback& function :
+       census.GetTopFunctions(static_cast<size_t>(function_count))) {
+    winrt::com_ptr<IModelObject> sp_entry, sp_function;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_entry.put());
+    if (FAILED(hr)) return hr;
+    if (function.shared_function_info != 0) {
+      hr = CreateV8HeapObjectModel(sp_ctx, function.shared_function_info,
+                                   sp_function.put());
+      if (FAILED(hr)) return hr;
+      hr = sp_entry->SetKey(L"function", sp_function.get(), nullptr);
+      if (FAILED(hr)) return hr;
+    }
+    hr = SetCounts(sp_entry.get(), function.counts);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"vectors", function.vectors);
+    if (FAILED(hr)) return hr;
+    functions.push_back(std::move(sp_entry));
+  }
+
+  winrt::com_ptr<IModelObject> sp_result, sp_functions;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"vectors", census.vectors());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"skipped_vectors", census.skipped_vectors());
+  if (FAILED(hr)) return hr;
+  hr = SetCounts(sp_result.get(), census.totals());
+  if (FAILED(hr)) return hr;
+  hr = CreateModelObjectList(sp_ctx, std::move(functions), sp_functions.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"functions", sp_functions.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
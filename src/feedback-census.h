@@ -0,0 +1,17 @@
+#pragma once
+
+#include <crtdbg.h>
+#include "../utilities.h"
+#include "extension.h"
+#include "list-chunks.h"
+#include "v8.h"
+
+// @$feedbackcensus([count]) - counts the inline cache states recorded in every
+// FeedbackVector on the heap, and lists the count functions (default 20) with
+// the most megamorphic, then polymorphic, ICs.
+struct FeedbackCensusAlias : winrt::implements<FeedbackCensusAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
@@ -0,0 +1,160 @@
+#include "find-objects.h"
+#include "object.h"
+#include "trace.h"
+#include <algorithm>
+
+HRESULT __stdcall FindObjectsAlias::Call(IModelObject* p_context_object,
+                                         ULONG64 arg_count,
+                                         _In_reads_(arg_count)
+                                             IModelObject** pp_arguments,
+                                         IModelObject** pp_result,
+                                         IKeyStore** pp_metadata) noexcept {
+  HRESULT hr = S_OK;
+  *pp_result = nullptr;
+  if (arg_count == 0) return E_INVALIDARG;
+
+  auto query = std::make_shared<ObjectQuery>();
+  for (ULONG64 i = 0; i < arg_count; ++i) {
+    VARIANT vt_arg;
+    hr = pp_arguments[i]->GetIntrinsicValue(&vt_arg);
+    if (FAILED(hr)) return hr;
+    if (vt_arg.vt == VT_BSTR) {
+      std::string name;
+      for (const wchar_t* p = vt_arg.bstrVal; *p != L'\0'; ++p) {
+        name.push_back(static_cast<char>(*p));
+      }
+      ::VariantClear(&vt_arg);
+      if (name.find("::") == std::string::npos) name = "v8::internal::" + name;
+      query->type_names.push_back(std::move(name));
+    } else {
+      ::VariantClear(&vt_arg);
+      hr = pp_arguments[i]->GetIntrinsicValueAs(VT_UI2, &vt_arg);
+      if (FAILED(hr)) return E_INVALIDARG;
+      query->instance_types.push_back(vt_arg.uiVal);
+    }
+  }
+
+  return CreateObjectSearch(query, pp_result);
+}
+
+HRESULT __stdcall FindStringAlias::Call(IModelObject* p_context_object,
+                                        ULONG64 arg_count,
+                                        _In_reads_(arg_count)
+                                            IModelObject** pp_arguments,
+                                        IModelObject** pp_result,
+                                        IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count != 1) return E_INVALIDARG;
+
+  VARIANT vt_text;
+  HRESULT hr = pp_arguments[0]->GetIntrinsicValue(&vt_text);
+  if (FAILED(hr)) return hr;
+  if (vt_text.vt != VT_BSTR) {
+    ::VariantClear(&vt_text);
+    return E_INVALIDARG;
+  }
+  auto query = std::make_shared<ObjectQuery>();
+  query->contents.emplace(reinterpret_cast<const char16_t*>(vt_text.bstrVal),
+                          ::SysStringLen(vt_text.bstrVal));
+  ::VariantClear(&vt_text);
+  return CreateObjectSearch(query, pp_result);
+}
+
+HRESULT CreateObjectSearch(std::shared_ptr<const ObjectQuery> query,
+                           IModelObject** pp_result) {
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+
+  winrt::com_ptr<IModelObject> sp_result;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+
+  auto sp_results{winrt::make<ObjectSearchResults>(query)};
+  hr = sp_result->SetConcept(__uuidof(IIterableConcept),
+                             sp_results.as<IIterableConcept>().get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
+
+ObjectSearchIterator::ObjectSearchIterator(
+    winrt::com_ptr<IDebugHostContext>& host_context,
+    std::shared_ptr<const ObjectQuery> query)
+    : sp_ctx(host_context), query(query), reader(GetMemReader(host_context)) {
+  if (query->contents.has_value()) contents_search.emplace(*query->contents);
+}
+
+HRESULT ObjectSearchIterator::Reset() noexcept {
+  _RPT0(_CRT_WARN, "Reset called on ObjectSearchIterator\n");
+  walker.reset();
+  chunk_index = 0;
+  return S_OK;
+}
+
+bool ObjectSearchIterator::IsMatchingType(const HeapObjectInfo& object) {
+  uint16_t instance_type = object.map->instance_type;
+  auto it = type_matches.find(instance_type);
+  if (it != type_matches.end()) return it->second;
+
+  // The first object of each instance type is decoded to learn its class
+  // name; the rest are matched on instance type alone.
+  bool any_type = query->instance_types.empty() && query->type_names.empty();
+  bool matches = any_type ||
+                 std::find(query->instance_types.begin(),
+                           query->instance_types.end(),
+                           instance_type) != query->instance_types.end();
+  const ObjectLayout* layout = nullptr;
+  if (!matches || query->contents.has_value()) {
+    layout = layout_cache.GetLayout(walker->reader(), object.tagged_ptr);
+  }
+  if (!matches && layout != nullptr) {
+    matches = std::find(query->type_names.begin(), query->type_names.end(),
+                        layout->type_name) != query->type_names.end();
+  }
+  if (matches && query->contents.has_value()) {
+    matches = layout != nullptr &&
+              layout->string_kind != StringKind::kNotString;
+  }
+  type_matches.emplace(instance_type, matches);
+  return matches;
+}
+
+bool ObjectSearchIterator::IsMatch(const HeapObjectInfo& object) {
+  if (!IsMatchingType(object)) return false;
+  return !contents_search.has_value() ||
+         contents_search->Matches(walker->reader(), layout_cache,
+                                  object.tagged_ptr);
+}
+
+HRESULT ObjectSearchIterator::GetNext(IModelObject** object, ULONG64 dimensions,
+                                      IModelObject** indexers,
+                                      IKeyStore** metadata) noexcept {
+  if (dimensions != 0) return E_INVALIDARG;
+  if (metadata != nullptr) *metadata = nullptr;
+  ScopedTrace trace("FindObjects.GetNext");
+
+  if (!chunks_populated) {
+    HRESULT hr = GetMemoryChunks(chunks);
+    if (FAILED(hr)) return hr;
+    chunks_populated = true;
+  }
+
+  HeapObjectInfo heap_object;
+  while (true) {
+    if (walker == nullptr) {
+      if (chunk_index >= chunks.size()) return E_BOUNDS;
+      const ChunkData& chunk = chunks[chunk_index++];
+      walker = std::make_unique<HeapObjectWalker>(
+          reader, layout_cache, chunk.area_start_address, chunk.area_end_address,
+          chunk.allocation_top, chunk.allocation_limit);
+    }
+    if (!walker->Next(&heap_object)) {
+      walker.reset();
+      continue;
+    }
+    if (IsMatch(heap_object)) break;
+  }
+  return CreateV8HeapObjectModel(sp_ctx, heap_object.tagged_ptr, object);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <crtdbg.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../utilities.h"
+#include "extension.h"
+#include "list-chunks.h"
+#include "v8.h"
+
+// The objects a heap search is looking for: any of the given instance types or
+// type names. With contents set, only strings holding that text match, and no
+// types means any string.
+struct ObjectQuery {
+  std::vector<uint16_t> instance_types;
+  std::vector<std::string> type_names;  // e.g. "v8::internal::JSArrayBuffer"
+  std::optional<std::u16string> contents;
+};
+
+// @$findobjects(type, ...) - each argument is an instance type number or a
+// class name such as "SharedFunctionInfo".
+struct FindObjectsAlias : winrt::implements<FindObjectsAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
+
+// @$findstring(text) - strings whose payload contains text.
+struct FindStringAlias : winrt::implements<FindStringAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
+
+// Walks the chunks lazily, so only as much of the heap is read as the results
+// consumed need. Only the map and size of each object are read; matches are
+// decoded in full when returned.
+struct ObjectSearchIterator
+    : winrt::implements<ObjectSearchIterator, IModelIterator> {
+  ObjectSearchIterator(winrt::com_ptr<IDebugHostContext>& host_context,
+                       std::shared_ptr<const ObjectQuery> query);
+
+  HRESULT __stdcall Reset() noexcept override;
+
+  HRESULT __stdcall GetNext(IModelObject** object, ULONG64 dimensions,
+                            IModelObject** indexers,
+                            IKeyStore** metadata) noexcept override;
+
+  bool IsMatch(const HeapObjectInfo& object);
+  bool IsMatchingType(const HeapObjectInfo& object);
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  std::shared_ptr<const ObjectQuery> query;
+  MemReader reader;
+  LayoutCache layout_cache;
+  bool chunks_populated = false;
+  std::vector<ChunkData> chunks;
+  size_t chunk_index = 0;
+  std::unique_ptr<HeapObjectWalker> walker;
+  // Whether each instance type seen so far matches the query.
+  std::unordered_map<uint16_t, bool> type_matches;
+  std::optional<StringPayloadSearch> contents_search;
+};
+
+// Creates the lazily evaluated collection of objects matching query.
+HRESULT CreateObjectSearch(std::shared_ptr<const ObjectQuery> query,
+                           IModelObject** pp_result);
+
+struct ObjectSearchResults
+    : winrt::implements<ObjectSearchResults, IIterableConcept> {
+  ObjectSearchResults(std::shared_ptr<const ObjectQuery> query) : query(query) {}
+
+  HRESULT __stdcall GetDefaultIndexDimensionality(
+      IModelObject* context_object, ULONG64* dimensionality) noexcept override {
+    // Results are found as the heap is walked, so can't be indexed.
+    *dimensionality = 0;
+    return S_OK;
+  }
+
+  HRESULT __stdcall GetIterator(IModelObject* context_object,
+                                IModelIterator** iterator) noexcept override {
+    winrt::com_ptr<IDebugHostContext> sp_ctx;
+    HRESULT hr = context_object->GetContext(sp_ctx.put());
+    if (FAILED(hr)) return hr;
+    auto sp_search_iterator{winrt::make<ObjectSearchIterator>(sp_ctx, query)};
+    *iterator = sp_search_iterator.as<IModelIterator>().detach();
+    return S_OK;
+  }
+
+  std::shared_ptr<const ObjectQuery> query;
+};
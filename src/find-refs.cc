@@ -0,0 +1,154 @@
+#include "find-refs.h"
+#include "curisolate.h"
+#include "object.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace {
+
+// A range that was scanned, and what owns it.
+struct ScannedRange {
+  MemoryRange range;
+  winrt::com_ptr<IModelObject> sp_thread_id;  // Null for heap chunks.
+};
+
+HRESULT CreateSlotEntry(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                        const PointerSlot& slot, const wchar_t* owner_key,
+                        IModelObject* p_owner, IModelObject** pp_entry) {
+  winrt::com_ptr<IModelObject> sp_entry, sp_slot, sp_compressed;
+  HRESULT hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(),
+                                                            sp_entry.put());
+  if (FAILED(hr)) return hr;
+  hr = CreateULong64(slot.address, sp_slot.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_entry->SetKey(L"slot", sp_slot.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateBool(slot.compressed, sp_compressed.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_entry->SetKey(L"compressed", sp_compressed.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  if (p_owner != nullptr) {
+    hr = sp_entry->SetKey(owner_key, p_owner, nullptr);
+    if (FAILED(hr)) return hr;
+  }
+  *pp_entry = sp_entry.detach();
+  return S_OK;
+}
+
+}  // namespace
+
+HRESULT __stdcall FindRefsAlias::Call(IModelObject* p_context_object,
+                                      ULONG64 arg_count,
+                                      _In_reads_(arg_count)
+                                          IModelObject** pp_arguments,
+                                      IModelObject** pp_result,
+                                      IKeyStore** pp_metadata) noexcept {
+  HRESULT hr = S_OK;
+  *pp_result = nullptr;
+  if (arg_count < 1 || arg_count > 2) return E_INVALIDARG;
+
+  VARIANT vt_address, vt_include_stacks;
+  hr = pp_arguments[0]->GetIntrinsicValueAs(VT_UI8, &vt_address);
+  if (FAILED(hr)) return hr;
+  bool include_stacks = false;
+  if (arg_count == 2) {
+    hr = pp_arguments[1]->GetIntrinsicValueAs(VT_BOOL, &vt_include_stacks);
+    if (FAILED(hr)) return hr;
+    include_stacks = vt_include_stacks.boolVal != VARIANT_FALSE;
+  }
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  MemReader reader = GetMemReader(sp_ctx);
+
+  uint64_t tagged_ptr = (vt_address.ullVal & ~kHeapObjectTagMask) | kHeapObjectTag;
+  std::vector<ChunkData> chunks;
+  hr = GetMemoryChunks(chunks);
+  if (FAILED(hr)) return hr;
+
+  // Look for compressed slots too if the heap uses pointer compression. The
+  // target may not be a valid object, so if it can't say, learn that from the
+  // first object of any chunk instead. A heap with no readable object at all
+  // is scanned for full pointers only, which can't match by accident as
+  // often.
+  LayoutCache layout_cache;
+  bool known = layout_cache.GetMap(reader, tagged_ptr) != nullptr;
+  for (size_t i = 0; !known && i < chunks.size(); ++i) {
+    known = layout_cache.GetMap(reader, chunks[i].area_start_address | kHeapObjectTag) !=
+            nullptr;
+  }
+  bool compressed = known && layout_cache.tagged_size() == 4;
+  std::vector<ScannedRange> scanned;
+  for (const ChunkData& chunk : chunks) {
+    scanned.push_back({{chunk.area_start_address, chunk.area_end_address}, nullptr});
+  }
+  if (include_stacks) {
+    std::vector<ThreadInfo> threads;
+    hr = GetThreads(sp_ctx, threads);
+    if (FAILED(hr)) return hr;
+    for (ThreadInfo& thread : threads) {
+      // The committed part of the stack, from the TIB at the start of the TEB.
+      ULONG64 stack_base, stack_limit;
+      if (SUCCEEDED(Extension::current_extension_->sp_debug_host_memory_->ReadPointers(
+              sp_ctx.get(), Location{thread.teb + offsetof(NT_TIB64, StackBase)},
+              1, &stack_base)) &&
+          SUCCEEDED(Extension::current_extension_->sp_debug_host_memory_->ReadPointers(
+              sp_ctx.get(), Location{thread.teb + offsetof(NT_TIB64, StackLimit)},
+              1, &stack_limit)) &&
+          stack_limit < stack_base) {
+        scanned.push_back({{stack_limit, stack_base}, thread.sp_id});
+      }
+    }
+  }
+  std::sort(scanned.begin(), scanned.end(),
+            [](const ScannedRange& a, const ScannedRange& b) {
+              return a.range.start < b.range.start;
+            });
+
+  std::vector<MemoryRange> ranges;
+  for (const ScannedRange& range : scanned) ranges.push_back(range.range);
+  std::vector<PointerSlot> slots;
+  {
+    ScopedTrace trace("FindRefs.Scan");
+    slots = ScanForPointer(ranges, reader, {tagged_ptr, compressed});
+  }
+
+  // Both lists are sorted, so one pass assigns each slot to its range. Heap
+  // slots are attributed to the object containing them by walking the chunk
+  // up to each slot in turn.
+  ScopedTrace trace("FindRefs.Attribute");
+  ModelObjectVector results;
+  auto slot = slots.begin();
+  for (ScannedRange& range : scanned) {
+    std::unique_ptr<HeapObjectWalker> walker;
+    HeapObjectInfo object{};
+    bool have_object = false;
+    for (; slot != slots.end() && slot->address < range.range.end; ++slot) {
+      winrt::com_ptr<IModelObject> sp_owner, sp_entry;
+      const wchar_t* owner_key = L"object";
+      if (range.sp_thread_id != nullptr) {
+        sp_owner = range.sp_thread_id;
+        owner_key = L"thread";
+      } else {
+        if (walker == nullptr) {
+          walker = std::make_unique<HeapObjectWalker>(
+              reader, layout_cache, range.range.start, range.range.end);
+          have_object = walker->Next(&object);
+        }
+        while (have_object &&
+               (object.tagged_ptr & ~kHeapObjectTagMask) + object.size <= slot->address) {
+          have_object = walker->Next(&object);
+        }
+        if (have_object) {
+          hr = CreateV8HeapObjectModel(sp_ctx, object.tagged_ptr, sp_owner.put());
+          if (FAILED(hr)) return hr;
+        }
+      }
+      hr = CreateSlotEntry(sp_ctx, *slot, owner_key, sp_owner.get(), sp_entry.put());
+      if (FAILED(hr)) return hr;
+      results.push_back(std::move(sp_entry));
+    }
+  }
+  return CreateModelObjectList(sp_ctx, std::move(results), pp_result);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <crtdbg.h>
+#include <vector>
+#include "../utilities.h"
+#include "extension.h"
+#include "list-chunks.h"
+#include "pointer-scan.h"
+#include "v8.h"
+
+// @$findrefs(address, [include_stacks]) - a conservative scan for slots that
+// point at the object at address. Every aligned slot in the heap (and thread
+// stacks if requested) is compared, so it works without any retainer
+// information, but values that merely look like the pointer are included.
+struct FindRefsAlias : winrt::implements<FindRefsAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
@@ -0,0 +1,197 @@
+#include "fragmentation.h"
+#include "object.h"
+#include "trace.h"
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+namespace {
+
+struct Occupancy {
+  void Add(const Occupancy& other) {
+    area_bytes += other.area_bytes;
+    live_bytes += other.live_bytes;
+    free_bytes += other.free_bytes;
+    unused_bytes += other.unused_bytes;
+    unwalked_bytes += other.unwalked_bytes;
+    largest_free_block = std::max(largest_free_block, other.largest_free_block);
+  }
+
+  // The share of the allocated part of the chunks that is free space between
+  // live objects, which only compaction can give back. Unused bytes at the end
+  // of a chunk are left out, as allocation can still use them.
+  double GetFragmentation() const {
+    uint64_t allocated = live_bytes + free_bytes;
+    return allocated == 0 ? 0 : static_cast<double>(free_bytes) / allocated;
+  }
+
+  uint64_t area_bytes = 0;
+  uint64_t live_bytes = 0;
+  uint64_t free_bytes = 0;
+  // In the linear allocation area or past the chunk's high water mark.
+  uint64_t unused_bytes = 0;
+  // Below the high water mark but past the first object the walk couldn't
+  // read, so neither known to be live nor known to be free.
+  uint64_t unwalked_bytes = 0;
+  uint64_t largest_free_block = 0;
+};
+
+// Measures chunks using each object's map and size. The first object of each
+// instance type is decoded to learn whether it is a filler. Objects of
+// variable sized types with no learned size rule are also decoded, to find
+// their size; @$v8dbgstats counts those as size_decodes.
+class OccupancyWalker {
+ public:
+  explicit OccupancyWalker(const MemReader& reader) : reader_(reader) {}
+
+  Occupancy Measure(const ChunkData& chunk) {
+    Occupancy occupancy;
+    occupancy.area_bytes = chunk.area_end_address - chunk.area_start_address;
+    HeapObjectWalker walker(reader_, cache_, chunk.area_start_address,
+                            chunk.area_end_address, chunk.allocation_top,
+                            chunk.allocation_limit);
+    HeapObjectInfo object;
+    uint64_t end = chunk.area_start_address;
+    while (walker.Next(&object)) {
+      if (IsFiller(walker, object)) {
+        occupancy.free_bytes += object.size;
+        occupancy.largest_free_block =
+            std::max(occupancy.largest_free_block, object.size);
+      } else {
+        occupancy.live_bytes += object.size;
+      }
+      end = (object.tagged_ptr & ~kHeapObjectTagMask) + object.size;
+    }
+
+    // The walker steps over the space's linear allocation area, all of which
+    // allocation can still use.
+    if (chunk.allocation_limit > chunk.allocation_top && end >= chunk.allocation_top) {
+      occupancy.unused_bytes += chunk.allocation_limit - chunk.allocation_top;
+      end = std::max(end, chunk.allocation_limit);
+    }
+
+    // The walk stops early at anything else it can't read, so the tail is
+    // only known to be unused above the high water mark. Without one, only a
+    // complete walk says so.
+    uint64_t top = std::min(chunk.high_water_mark, chunk.area_end_address);
+    if (end >= chunk.area_end_address || (top != 0 && end >= top)) {
+      occupancy.unused_bytes += chunk.area_end_address - end;
+    } else if (top != 0) {
+      occupancy.unwalked_bytes = top - end;
+      occupancy.unused_bytes += chunk.area_end_address - top;
+    } else {
+      occupancy.unwalked_bytes = chunk.area_end_address - end;
+    }
+    return occupancy;
+  }
+
+ private:
+  bool IsFiller(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    uint16_t instance_type = object.map->instance_type;
+    auto it = is_filler_type_.find(instance_type);
+    if (it != is_filler_type_.end()) return it->second;
+    const ObjectLayout* layout = cache_.GetLayout(walker.reader(), object.tagged_ptr);
+    bool is_filler = layout != nullptr &&
+                     (EndsWith(layout->type_name, "FreeSpace") ||
+                      EndsWith(layout->type_name, "Filler"));
+    is_filler_type_.emplace(instance_type, is_filler);
+    return is_filler;
+  }
+
+  static bool EndsWith(const std::string& value, std::string_view suffix) {
+    return value.size() >= suffix.size() &&
+           value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  MemReader reader_;
+  LayoutCache cache_;
+  std::unordered_map<uint16_t, bool> is_filler_type_;
+};
+
+HRESULT SetOccupancyKeys(IModelObject* p_object, const Occupancy& occupancy) {
+  HRESULT hr = SetULong64Key(p_object, L"area_bytes", occupancy.area_bytes);
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(p_object, L"live_bytes", occupancy.live_bytes);
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(p_object, L"free_bytes", occupancy.free_bytes);
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(p_object, L"unused_bytes", occupancy.unused_bytes);
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(p_object, L"unwalked_bytes", occupancy.unwalked_bytes);
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(p_object, L"largest_free_block", occupancy.largest_free_block);
+  if (FAILED(hr)) return hr;
+  winrt::com_ptr<IModelObject> sp_fragmentation;
+  hr = CreateNumber(occupancy.GetFragmentation(), sp_fragmentation.put());
+  if (FAILED(hr)) return hr;
+  return p_object->SetKey(L"fragmentation", sp_fragmentation.get(), nullptr);
+}
+
+}  // namespace
+
+HRESULT __stdcall FragmentationAlias::Call(IModelObject* p_context_object,
+                                           ULONG64 arg_count,
+                                           _In_reads_(arg_count)
+                                               IModelObject** pp_arguments,
+                                           IModelObject** pp_result,
+                                           IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count != 0) return E_INVALIDARG;
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  std::vector<ChunkData> chunks;
+  hr = GetMemoryChunks(chunks);
+  if (FAILED(hr)) return hr;
+
+  ScopedTrace trace("Fragmentation");
+  OccupancyWalker walker(GetMemReader(sp_ctx));
+  std::map<std::wstring, std::pair<uint64_t, Occupancy>> spaces;  // {chunks, totals}
+  ModelObjectVector chunk_entries;
+  for (const ChunkData& chunk : chunks) {
+    Occupancy occupancy = walker.Measure(chunk);
+    auto& space = spaces[chunk.space_name];
+    ++space.first;
+    space.second.Add(occupancy);
+
+    winrt::com_ptr<IModelObject> sp_entry;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_entry.put());
+    if (FAILED(hr)) return hr;
+    hr = sp_entry->SetKey(L"area_start", chunk.area_start.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    hr = sp_entry->SetKey(L"area_end", chunk.area_end.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    hr = sp_entry->SetKey(L"space", chunk.space.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    hr = SetOccupancyKeys(sp_entry.get(), occupancy);
+    if (FAILED(hr)) return hr;
+    chunk_entries.push_back(std::move(sp_entry));
+  }
+
+  winrt::com_ptr<IModelObject> sp_result, sp_spaces, sp_chunks;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_spaces.put());
+  if (FAILED(hr)) return hr;
+  for (const auto& space : spaces) {
+    winrt::com_ptr<IModelObject> sp_space;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_space.put());
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_space.get(), L"chunks", space.second.first);
+    if (FAILED(hr)) return hr;
+    hr = SetOccupancyKeys(sp_space.get(), space.second.second);
+    if (FAILED(hr)) return hr;
+    hr = sp_spaces->SetKey(space.first.c_str(), sp_space.get(), nullptr);
+    if (FAILED(hr)) return hr;
+  }
+  hr = sp_result->SetKey(L"spaces", sp_spaces.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateModelObjectList(sp_ctx, std::move(chunk_entries), sp_chunks.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"chunks", sp_chunks.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <crtdbg.h>
+#include "../utilities.h"
+#include "extension.h"
+#include "list-chunks.h"
+#include "v8.h"
+
+// @$fragmentation() - how full each chunk is: bytes of live objects, of free
+// space fillers between them, unused at the end of the chunk, and left
+// unwalked where the walk stopped early, with totals and a fragmentation
+// score for each space.
+struct FragmentationAlias : winrt::implements<FragmentationAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
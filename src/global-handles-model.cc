@@ -0,0 +1,235 @@
+#include "global-handles-model.h"
+#include "curisolate.h"
+#include "object.h"
+#include "trace.h"
+#include <algorithm>
+#include <map>
+
+namespace {
+
+// NodeBlock::kBlockSize, which is a static constant and so not in the
+// block's fields.
+constexpr uint64_t kNodesPerBlock = 256;
+
+std::wstring GetStateName(const GlobalHandleSource& source, uint8_t state) {
+  auto it = source.state_names.find(state);
+  return it != source.state_names.end() ? it->second
+                                        : L"state " + std::to_wstring(state);
+}
+
+bool GetTypeSize(winrt::com_ptr<IDebugHostType>& sp_type, uint64_t* p_size) {
+  ULONG64 size;
+  if (sp_type == nullptr || FAILED(sp_type->GetSize(&size))) return false;
+  *p_size = size;
+  return true;
+}
+
+bool GetOffset(winrt::com_ptr<IDebugHostType>& sp_type, const wchar_t* field_name,
+               uint64_t* p_offset) {
+  ULONG64 offset;
+  if (sp_type == nullptr || !GetFieldOffset(sp_type, field_name, &offset)) {
+    return false;
+  }
+  *p_offset = offset;
+  return true;
+}
+
+}  // namespace
+
+HRESULT FindGlobalHandles(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                          std::shared_ptr<const GlobalHandleSource>* p_source) {
+  ScopedTrace trace("FindGlobalHandles");
+  winrt::com_ptr<IModelObject> sp_isolate, sp_global_handles;
+  HRESULT hr = GetCurrentIsolate(sp_isolate);
+  if (FAILED(hr)) return hr;
+  hr = sp_isolate->GetRawValue(SymbolField, L"global_handles_", RawSearchNone,
+                               sp_global_handles.put());
+  if (FAILED(hr)) return hr;
+  VARIANT vt_global_handles;
+  hr = sp_global_handles->GetIntrinsicValue(&vt_global_handles);
+  if (FAILED(hr) || vt_global_handles.vt != VT_UI8) return E_FAIL;
+
+  Extension* extension = Extension::current_extension_;
+  auto source = std::make_shared<GlobalHandleSource>();
+  source->reader = GetMemReader(sp_ctx);
+  winrt::com_ptr<IDebugHostType> sp_space_type =
+      extension->GetV8ObjectType(sp_ctx, u"v8::internal::GlobalHandles");
+  uint64_t space = vt_global_handles.ullVal;
+  uint64_t offset;
+  if (GetOffset(sp_space_type, L"regular_nodes_", &offset)) {
+    // Newer versions keep the blocks in a NodeSpace, held by a unique_ptr.
+    if (!source->reader(space + offset, sizeof(space),
+                        reinterpret_cast<uint8_t*>(&space))) {
+      return E_FAIL;
+    }
+    sp_space_type = extension->GetV8ObjectType(
+        sp_ctx,
+        u"v8::internal::GlobalHandles::NodeSpace<v8::internal::GlobalHandles::Node>");
+  }
+  if (!GetOffset(sp_space_type, L"first_used_block_", &offset) ||
+      !source->reader(space + offset, sizeof(source->first_block),
+                      reinterpret_cast<uint8_t*>(&source->first_block))) {
+    return E_FAIL;
+  }
+
+  winrt::com_ptr<IDebugHostType> sp_block_type = extension->GetV8ObjectType(
+      sp_ctx,
+      u"v8::internal::GlobalHandles::NodeBlock<v8::internal::GlobalHandles::Node>");
+  if (sp_block_type == nullptr) {
+    sp_block_type =
+        extension->GetV8ObjectType(sp_ctx, u"v8::internal::GlobalHandles::NodeBlock");
+  }
+  winrt::com_ptr<IDebugHostType> sp_node_type =
+      extension->GetV8ObjectType(sp_ctx, u"v8::internal::GlobalHandles::Node");
+  GlobalHandleLayout& layout = source->layout;
+  if (!GetTypeSize(sp_block_type, &layout.block_size) ||
+      !GetOffset(sp_block_type, L"nodes_", &layout.nodes_offset) ||
+      !GetOffset(sp_block_type, L"next_used_", &layout.next_used_offset) ||
+      !GetTypeSize(sp_node_type, &layout.node_size) ||
+      !GetOffset(sp_node_type, L"object_", &layout.object_offset) ||
+      !GetOffset(sp_node_type, L"class_id_", &layout.class_id_offset) ||
+      !GetOffset(sp_node_type, L"flags_", &layout.flags_offset) ||
+      layout.node_size == 0 || layout.nodes_offset >= layout.block_size ||
+      layout.next_used_offset + sizeof(uint64_t) > layout.block_size) {
+    return E_FAIL;
+  }
+  layout.nodes_per_block = std::min(
+      kNodesPerBlock, (layout.block_size - layout.nodes_offset) / layout.node_size);
+
+  winrt::com_ptr<IDebugHostType> sp_state_type = extension->GetV8ObjectType(
+      sp_ctx, u"v8::internal::GlobalHandles::Node::State");
+  if (sp_state_type != nullptr) GetEnumNames(sp_state_type, &source->state_names);
+  layout.state_mask = kDefaultGlobalHandleStateMask;
+  if (!source->state_names.empty()) {
+    int64_t highest_state = 0;
+    for (const auto& entry : source->state_names) {
+      highest_state = std::max(highest_state, entry.first);
+    }
+    layout.state_mask = GetGlobalHandleStateMask(highest_state);
+  }
+
+  *p_source = std::move(source);
+  return S_OK;
+}
+
+HRESULT __stdcall GlobalHandlesAlias::Call(IModelObject* p_context_object,
+                                           ULONG64 arg_count,
+                                           _In_reads_(arg_count)
+                                               IModelObject** pp_arguments,
+                                           IModelObject** pp_result,
+                                           IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count != 0) return E_INVALIDARG;
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  std::shared_ptr<const GlobalHandleSource> source;
+  hr = FindGlobalHandles(sp_ctx, &source);
+  if (FAILED(hr)) return hr;
+
+  winrt::com_ptr<IModelObject> sp_result;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+  auto sp_iterable = winrt::make<GlobalHandles>(source).as<IIterableConcept>();
+  hr = sp_result->SetConcept(__uuidof(IIterableConcept), sp_iterable.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = SetMethodKey(sp_result.get(), L"census",
+                    winrt::make<GlobalHandleCensusMethod>(source));
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
+
+HRESULT __stdcall GlobalHandleIterator::GetNext(IModelObject** object,
+                                                ULONG64 dimensions,
+                                                IModelObject** indexers,
+                                                IKeyStore** metadata) noexcept {
+  if (dimensions > 1) return E_INVALIDARG;
+  if (walker == nullptr) {
+    walker = std::make_unique<GlobalHandleWalker>(source->reader, source->layout,
+                                                  source->first_block);
+  }
+  GlobalHandle handle;
+  if (!walker->Next(&handle)) return E_BOUNDS;
+  if (metadata != nullptr) *metadata = nullptr;
+
+  if (dimensions == 1) {
+    HRESULT hr = CreateULong64(position, indexers);
+    if (FAILED(hr)) return hr;
+  }
+  ++position;
+
+  winrt::com_ptr<IModelObject> sp_value, sp_target;
+  HRESULT hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_value.put());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_value.get(), L"location", handle.location);
+  if (FAILED(hr)) return hr;
+  if ((handle.object & kHeapObjectTagMask) == kHeapObjectTag) {
+    hr = CreateV8HeapObjectModel(sp_ctx, handle.object, sp_target.put());
+  } else {
+    hr = CreateULong64(handle.object, sp_target.put());
+  }
+  if (FAILED(hr)) return hr;
+  hr = sp_value->SetKey(L"object", sp_target.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = SetStringKey(sp_value.get(), L"state", GetStateName(*source, handle.state));
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_value.get(), L"class_id", handle.class_id);
+  if (FAILED(hr)) return hr;
+
+  *object = sp_value.detach();
+  return S_OK;
+}
+
+HRESULT __stdcall GlobalHandleCensusMethod::Call(IModelObject* p_context_object,
+                                                 ULONG64 arg_count,
+                                                 _In_reads_(arg_count)
+                                                     IModelObject** pp_arguments,
+                                                 IModelObject** pp_result,
+                                                 IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count != 0) return E_INVALIDARG;
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+
+  ScopedTrace trace("GlobalHandleCensus");
+  LayoutCache cache;
+  std::map<std::wstring, uint64_t> by_state, by_class_id, by_type;
+  uint64_t handles = 0;
+  GlobalHandleWalker walker(source->reader, source->layout, source->first_block);
+  GlobalHandle handle;
+  while (walker.Next(&handle)) {
+    ++handles;
+    ++by_state[GetStateName(*source, handle.state)];
+    if (handle.class_id != 0) ++by_class_id[std::to_wstring(handle.class_id)];
+    const ObjectLayout* layout =
+        (handle.object & kHeapObjectTagMask) == kHeapObjectTag
+            ? cache.GetLayout(source->reader, handle.object)
+            : nullptr;
+    std::string type = layout != nullptr ? layout->type_name : "unknown";
+    ++by_type[std::wstring(type.begin(), type.end())];
+  }
+
+  winrt::com_ptr<IModelObject> sp_result, sp_by_state, sp_by_class_id, sp_by_type;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"handles", handles);
+  if (FAILED(hr)) return hr;
+  hr = CreateCountList(sp_ctx, L"state", by_state, sp_by_state.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"by_state", sp_by_state.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateCountList(sp_ctx, L"class_id", by_class_id, sp_by_class_id.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"by_class_id", sp_by_class_id.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateCountList(sp_ctx, L"type", by_type, sp_by_type.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"by_type", sp_by_type.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <crtdbg.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "../utilities.h"
+#include "extension.h"
+#include "global-handles.h"
+#include "v8.h"
+
+// Everything needed to walk the current isolate's global handles, found once
+// per @$globalhandles() call and shared by its iterators and census().
+struct GlobalHandleSource {
+  MemReader reader;
+  GlobalHandleLayout layout;
+  uint64_t first_block;
+  std::unordered_map<int64_t, std::wstring> state_names;  // Node::State
+};
+
+HRESULT FindGlobalHandles(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                          std::shared_ptr<const GlobalHandleSource>* p_source);
+
+// @$globalhandles() - the current isolate's global (persistent) handles, each
+// with its location, target object, state and class id. They are read a block
+// at a time as the collection is iterated. census() counts them by state,
+// class id and target type.
+struct GlobalHandlesAlias : winrt::implements<GlobalHandlesAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
+
+struct GlobalHandleCensusMethod
+    : winrt::implements<GlobalHandleCensusMethod, IModelMethod> {
+  GlobalHandleCensusMethod(std::shared_ptr<const GlobalHandleSource> source)
+      : source(std::move(source)) {}
+
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+
+  std::shared_ptr<const GlobalHandleSource> source;
+};
+
+struct GlobalHandleIterator
+    : winrt::implements<GlobalHandleIterator, IModelIterator> {
+  GlobalHandleIterator(winrt::com_ptr<IDebugHostContext>& host_context,
+                       std::shared_ptr<const GlobalHandleSource> source)
+      : sp_ctx(host_context), source(std::move(source)) {}
+
+  HRESULT __stdcall Reset() noexcept override {
+    walker.reset();
+    position = 0;
+    return S_OK;
+  }
+
+  HRESULT __stdcall GetNext(IModelObject** object, ULONG64 dimensions,
+                            IModelObject** indexers,
+                            IKeyStore** metadata) noexcept override;
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  std::shared_ptr<const GlobalHandleSource> source;
+  std::unique_ptr<GlobalHandleWalker> walker;
+  ULONG64 position = 0;
+};
+
+struct GlobalHandles : winrt::implements<GlobalHandles, IIterableConcept> {
+  GlobalHandles(std::shared_ptr<const GlobalHandleSource> source)
+      : source(std::move(source)) {}
+
+  HRESULT __stdcall GetDefaultIndexDimensionality(
+      IModelObject* context_object, ULONG64* dimensionality) noexcept override {
+    *dimensionality = 1;
+    return S_OK;
+  }
+
+  HRESULT __stdcall GetIterator(IModelObject* context_object,
+                                IModelIterator** iterator) noexcept override {
+    winrt::com_ptr<IDebugHostContext> sp_ctx;
+    HRESULT hr = context_object->GetContext(sp_ctx.put());
+    if (FAILED(hr)) return hr;
+    *iterator = winrt::make<GlobalHandleIterator>(sp_ctx, source)
+                    .as<IModelIterator>()
+                    .detach();
+    return S_OK;
+  }
+
+  std::shared_ptr<const GlobalHandleSource> source;
+};
@@ -0,0 +1,44 @@
+#include "global-handles.h"
+#include "trace.h"
+#include <cstring>
+
+bool GlobalHandleWalker::Next(GlobalHandle* handle) {
+  while (true) {
+    if (block_.empty() || next_node_ >= layout_.nodes_per_block) {
+      if (!ReadNextBlock()) return false;
+    }
+    uint64_t offset = layout_.nodes_offset + next_node_ * layout_.node_size;
+    const uint8_t* node = block_.data() + offset;
+    ++next_node_;
+    uint8_t flags;
+    memcpy(&flags, node + layout_.flags_offset, sizeof(flags));
+    if ((flags & layout_.state_mask) == kFreeGlobalHandle) continue;
+
+    handle->location = block_address_ + offset;
+    handle->state = flags & layout_.state_mask;
+    memcpy(&handle->object, node + layout_.object_offset, sizeof(handle->object));
+    memcpy(&handle->class_id, node + layout_.class_id_offset,
+           sizeof(handle->class_id));
+    return true;
+  }
+}
+
+uint8_t GetGlobalHandleStateMask(int64_t highest_state) {
+  uint8_t mask = 1;
+  while (mask < highest_state && mask != 0xFF) mask = (mask << 1) | 1;
+  return mask;
+}
+
+bool GlobalHandleWalker::ReadNextBlock() {
+  ScopedTrace trace("ReadGlobalHandleBlock");
+  if (next_block_ == 0 || !seen_blocks_.insert(next_block_).second) return false;
+  block_.resize(static_cast<size_t>(layout_.block_size));
+  if (!reader_(next_block_, block_.size(), block_.data())) {
+    block_.clear();
+    return false;
+  }
+  block_address_ = next_block_;
+  memcpy(&next_block_, block_.data() + layout_.next_used_offset, sizeof(next_block_));
+  next_node_ = 0;
+  return true;
+}
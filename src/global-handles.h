@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+#include "mem-reader.h"
+
+// Where the parts of V8's global handle blocks are, as found in V8's symbols.
+// Handles live in GlobalHandles::NodeBlocks of NodeBlock::kBlockSize nodes,
+// and the blocks with any node in use are linked through next_used_.
+struct GlobalHandleLayout {
+  uint64_t block_size;
+  uint64_t nodes_offset;  // Of the node array within a block.
+  uint64_t nodes_per_block;
+  uint64_t next_used_offset;
+  uint64_t node_size;
+  uint64_t object_offset;
+  uint64_t class_id_offset;
+  uint64_t flags_offset;
+  uint8_t state_mask;  // The low bits of flags_ that hold Node::NodeState.
+};
+
+// Older versions of V8 have five node states, in three bits.
+constexpr uint8_t kDefaultGlobalHandleStateMask = 7;
+constexpr uint8_t kFreeGlobalHandle = 0;
+
+// Returns the mask of the fewest low bits that hold every state up to
+// highest_state. Newer versions of V8 have three states, in two bits, and
+// use the next bit for other flags.
+uint8_t GetGlobalHandleStateMask(int64_t highest_state);
+
+struct GlobalHandle {
+  uint64_t location;  // Of the node, which is what a v8::Global points to.
+  uint64_t object;
+  uint16_t class_id;
+  uint8_t state;
+};
+
+// Steps through the nodes in use in the chain of used blocks that starts at
+// first_block, reading each block with a single read.
+class GlobalHandleWalker {
+ public:
+  GlobalHandleWalker(MemReader reader, const GlobalHandleLayout& layout,
+                     uint64_t first_block)
+      : reader_(std::move(reader)), layout_(layout), next_block_(first_block) {}
+
+  // Moves to the next node in use. Returns false after the last block, or at
+  // a block that can't be read or has been seen before.
+  bool Next(GlobalHandle* handle);
+
+ private:
+  bool ReadNextBlock();
+
+  MemReader reader_;
+  GlobalHandleLayout layout_;
+  uint64_t next_block_;
+  uint64_t block_address_ = 0;
+  uint64_t next_node_ = 0;
+  std::vector<uint8_t> block_;
+  std::unordered_set<uint64_t> seen_blocks_;
+};
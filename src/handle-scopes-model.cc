@@ -0,0 +1,124 @@
+#include "handle-scopes-model.h"
+#include "curisolate.h"
+#include "object.h"
+#include "trace.h"
+#include <map>
+
+namespace {
+
+// Finds the HandleScopeImplementer's blocks and HandleScopeData::next.
+HRESULT FindHandleBlocks(winrt::com_ptr<IModelObject>& sp_isolate,
+                         const MemReader& reader, std::vector<uint64_t>* blocks,
+                         uint64_t* next) {
+  winrt::com_ptr<IModelObject> sp_implementer_ptr, sp_implementer, sp_blocks,
+      sp_scope_data;
+  HRESULT hr = sp_isolate->GetRawValue(SymbolField, L"handle_scope_implementer_",
+                                       RawSearchNone, sp_implementer_ptr.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_implementer_ptr->Dereference(sp_implementer.put());
+  if (FAILED(hr)) return hr;
+  // A DetachableVector<Address*>.
+  hr = sp_implementer->GetRawValue(SymbolField, L"blocks_", RawSearchNone,
+                                   sp_blocks.put());
+  if (FAILED(hr)) return hr;
+  ULONG64 data, size;
+  hr = GetFieldValue(sp_blocks, L"data_", &data);
+  if (FAILED(hr)) return hr;
+  hr = GetFieldValue(sp_blocks, L"size_", &size);
+  if (FAILED(hr)) return hr;
+  blocks->resize(static_cast<size_t>(size));
+  if (size != 0 && !reader(data, blocks->size() * sizeof(uint64_t),
+                           reinterpret_cast<uint8_t*>(blocks->data()))) {
+    return E_FAIL;
+  }
+
+  hr = sp_isolate->GetRawValue(SymbolField, L"handle_scope_data_", RawSearchNone,
+                               sp_scope_data.put());
+  if (FAILED(hr)) return hr;
+  ULONG64 next_value;
+  hr = GetFieldValue(sp_scope_data, L"next", &next_value);
+  if (FAILED(hr)) return hr;
+  *next = next_value;
+  return S_OK;
+}
+
+}  // namespace
+
+HRESULT __stdcall HandleScopesAlias::Call(IModelObject* p_context_object,
+                                          ULONG64 arg_count,
+                                          _In_reads_(arg_count)
+                                              IModelObject** pp_arguments,
+                                          IModelObject** pp_result,
+                                          IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count != 0) return E_INVALIDARG;
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  winrt::com_ptr<IModelObject> sp_isolate;
+  hr = GetCurrentIsolate(sp_isolate);
+  if (FAILED(hr)) return hr;
+
+  ScopedTrace trace("HandleScopes");
+  MemReader reader = GetMemReader(sp_ctx);
+  std::vector<uint64_t> block_addresses;
+  uint64_t next;
+  hr = FindHandleBlocks(sp_isolate, reader, &block_addresses, &next);
+  if (FAILED(hr)) return hr;
+
+  // Each block is read once, and each distinct map decoded once, so a block
+  // of a thousand handles to a few types costs a handful of reads.
+  LayoutCache cache;
+  std::vector<uint64_t> values;
+  std::map<std::wstring, uint64_t> by_type;
+  uint64_t handles = 0;
+  ModelObjectVector blocks;
+  for (const HandleBlock& block : GetHandleBlocks(block_addresses, next)) {
+    std::map<std::wstring, uint64_t> block_types;
+    if (ReadHandles(reader, block, &values)) {
+      for (uint64_t value : values) {
+        const ObjectLayout* layout = (value & kHeapObjectTagMask) == kHeapObjectTag
+                                         ? cache.GetLayout(reader, value)
+                                         : nullptr;
+        std::string type = layout != nullptr ? layout->type_name
+                           : (value & 1) == 0 ? "Smi"
+                                              : "unknown";
+        ++block_types[std::wstring(type.begin(), type.end())];
+      }
+    }
+    handles += values.size();
+    for (const auto& type : block_types) by_type[type.first] += type.second;
+
+    winrt::com_ptr<IModelObject> sp_block, sp_types;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_block.put());
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_block.get(), L"address", block.address);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_block.get(), L"handles", values.size());
+    if (FAILED(hr)) return hr;
+    hr = CreateCountList(sp_ctx, L"type", block_types, sp_types.put());
+    if (FAILED(hr)) return hr;
+    hr = sp_block->SetKey(L"by_type", sp_types.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    blocks.push_back(std::move(sp_block));
+  }
+
+  winrt::com_ptr<IModelObject> sp_result, sp_by_type, sp_blocks;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"handles", handles);
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"blocks", blocks.size());
+  if (FAILED(hr)) return hr;
+  hr = CreateCountList(sp_ctx, L"type", by_type, sp_by_type.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"by_type", sp_by_type.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateModelObjectList(sp_ctx, std::move(blocks), sp_blocks.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"block_list", sp_blocks.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <crtdbg.h>
+#include "../utilities.h"
+#include "extension.h"
+#include "handle-scopes.h"
+#include "v8.h"
+
+// @$handlescopes() - the current isolate's HandleScope blocks: how many live
+// handles there are, how many each block holds, and the types of the objects
+// they refer to. Blocks fill in the order scopes create handles, so a block
+// full of one type usually points at the loop that made them.
+struct HandleScopesAlias : winrt::implements<HandleScopesAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
@@ -0,0 +1,29 @@
+#include "handle-scopes.h"
+#include "trace.h"
+
+std::vector<HandleBlock> GetHandleBlocks(const std::vector<uint64_t>& blocks,
+                                         uint64_t next, size_t block_slots) {
+  std::vector<HandleBlock> result;
+  result.reserve(blocks.size());
+  for (uint64_t block : blocks) {
+    size_t handles = block_slots;
+    if (next >= block && next < block + block_slots * sizeof(uint64_t)) {
+      handles = static_cast<size_t>((next - block) / sizeof(uint64_t));
+    }
+    result.push_back({block, handles});
+  }
+  return result;
+}
+
+bool ReadHandles(const MemReader& reader, const HandleBlock& block,
+                 std::vector<uint64_t>* values) {
+  ScopedTrace trace("ReadHandleBlock");
+  values->resize(block.handles);
+  if (block.handles != 0 &&
+      !reader(block.address, block.handles * sizeof(uint64_t),
+              reinterpret_cast<uint8_t*>(values->data()))) {
+    values->clear();
+    return false;
+  }
+  return true;
+}
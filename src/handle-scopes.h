@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "mem-reader.h"
+
+// Handles created in a HandleScope live in blocks of kHandleBlockSize slots
+// (v8::internal::KB - 2) owned by the isolate's HandleScopeImplementer. Every
+// block is full except the current one, which is used up to the isolate's
+// HandleScopeData::next.
+constexpr size_t kHandleBlockSlots = 1022;
+
+struct HandleBlock {
+  uint64_t address;
+  size_t handles;
+};
+
+// Finds how many handles each block holds, given the blocks in the order the
+// HandleScopeImplementer lists them and HandleScopeData::next.
+std::vector<HandleBlock> GetHandleBlocks(const std::vector<uint64_t>& blocks,
+                                         uint64_t next,
+                                         size_t block_slots = kHandleBlockSlots);
+
+// Reads the values of the handles in block with a single read. Returns false,
+// leaving values empty, if the block can't be read.
+bool ReadHandles(const MemReader& reader, const HandleBlock& block,
+                 std::vector<uint64_t>* values);
@@ -0,0 +1,107 @@
+#include "heap-diff.h"
+#include "top-n.h"
+#include "trace.h"
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+struct Totals {
+  uint64_t count = 0;
+  uint64_t bytes = 0;
+};
+
+using Histogram = std::unordered_map<uint16_t, Totals>;
+
+// Counts the objects of each instance type and, if objects isn't null, maps
+// each object's address to its map.
+bool IndexTable(ObjectTableReader& table, Histogram* histogram,
+                std::unordered_map<uint64_t, uint64_t>* objects) {
+  ScopedTrace trace("IndexObjectTable");
+  if (objects != nullptr) objects->reserve(static_cast<size_t>(table.row_count()));
+  std::vector<ObjectRow> rows;
+  for (size_t block = 0; block < table.block_count(); ++block) {
+    if (!table.ReadBlock(block, &rows)) return false;
+    for (const ObjectRow& row : rows) {
+      Totals& totals = (*histogram)[row.instance_type];
+      ++totals.count;
+      totals.bytes += row.size;
+      if (objects != nullptr) objects->emplace(row.address, row.map);
+    }
+  }
+  return true;
+}
+
+struct SmallerObject {
+  bool operator()(const ObjectRow& a, const ObjectRow& b) const {
+    return a.size < b.size;
+  }
+};
+
+}  // namespace
+
+bool DiffObjectTables(ObjectTableReader& before, ObjectTableReader& after,
+                      size_t max_new_objects, HeapDiff* diff) {
+  ScopedTrace trace("DiffObjectTables");
+  *diff = HeapDiff();
+  Histogram before_types, after_types;
+  std::unordered_map<uint64_t, uint64_t> before_objects;
+  bool before_ok = false;
+  std::thread worker([&]() {
+    before_ok = IndexTable(before, &before_types, &before_objects);
+  });
+  bool after_ok = IndexTable(after, &after_types, nullptr);
+  worker.join();
+  if (!before_ok || !after_ok) return false;
+
+  std::unordered_map<std::string, TypeDelta> types;
+  for (const auto& [instance_type, totals] : before_types) {
+    TypeDelta& delta = types[before.GetTypeLabel(instance_type)];
+    delta.before_count += totals.count;
+    delta.before_bytes += totals.bytes;
+  }
+  std::unordered_map<uint16_t, TypeDelta*> after_deltas;
+  for (const auto& [instance_type, totals] : after_types) {
+    TypeDelta& delta = types[after.GetTypeLabel(instance_type)];
+    delta.after_count += totals.count;
+    delta.after_bytes += totals.bytes;
+    after_deltas[instance_type] = &delta;
+  }
+
+  BoundedTopN<ObjectRow, SmallerObject> largest(max_new_objects);
+  std::vector<ObjectRow> rows;
+  for (size_t block = 0; block < after.block_count(); ++block) {
+    if (!after.ReadBlock(block, &rows)) return false;
+    for (const ObjectRow& row : rows) {
+      auto it = before_objects.find(row.address);
+      if (it != before_objects.end() && it->second == row.map) continue;
+      TypeDelta* delta = after_deltas[row.instance_type];
+      ++delta->new_count;
+      delta->new_bytes += row.size;
+      ++diff->new_objects;
+      diff->new_bytes += row.size;
+      largest.Push(row);
+    }
+  }
+  diff->largest_new_objects = largest.Take();
+
+  std::unordered_set<uint64_t> before_maps;
+  for (const ObjectTableMap& map : before.maps()) before_maps.insert(map.address);
+  for (const ObjectTableMap& map : after.maps()) {
+    if (before_maps.count(map.address) == 0) diff->new_maps.push_back(map);
+  }
+
+  for (auto& [type, delta] : types) {
+    delta.type = type;
+    diff->types.push_back(std::move(delta));
+  }
+  std::sort(diff->types.begin(), diff->types.end(),
+            [](const TypeDelta& a, const TypeDelta& b) {
+              return a.bytes_delta() != b.bytes_delta()
+                         ? a.bytes_delta() > b.bytes_delta()
+                         : a.type < b.type;
+            });
+  return true;
+}
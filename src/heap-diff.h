@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "object-table.h"
+
+// The objects of one type on both sides of a diff. Types are matched by name,
+// so tables from builds that number instance types differently still line up.
+struct TypeDelta {
+  int64_t count_delta() const { return static_cast<int64_t>(after_count - before_count); }
+  int64_t bytes_delta() const { return static_cast<int64_t>(after_bytes - before_bytes); }
+
+  std::string type;
+  uint64_t before_count = 0;
+  uint64_t before_bytes = 0;
+  uint64_t after_count = 0;
+  uint64_t after_bytes = 0;
+  uint64_t new_count = 0;  // Objects only in the second table.
+  uint64_t new_bytes = 0;
+};
+
+struct HeapDiff {
+  std::vector<TypeDelta> types;  // By growth in bytes, greatest first.
+  uint64_t new_objects = 0;
+  uint64_t new_bytes = 0;
+  std::vector<ObjectRow> largest_new_objects;  // Largest first.
+  std::vector<ObjectTableMap> new_maps;  // In the order the second table lists them.
+};
+
+// Compares two object tables, such as ones exported from dumps taken minutes
+// apart. An object is new if the first table has no object at its address
+// with the same map. The first table is indexed on a worker thread while the
+// second is counted, then the second is read again to find its new objects,
+// of which the max_new_objects largest are kept. Returns false if either
+// table can't be read.
+bool DiffObjectTables(ObjectTableReader& before, ObjectTableReader& after,
+                      size_t max_new_objects, HeapDiff* diff);
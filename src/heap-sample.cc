@@ -0,0 +1,52 @@
+#include "heap-sample.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+constexpr double kZ95 = 1.96;
+
+}  // namespace
+
+std::vector<size_t> PickSample(size_t population, double fraction, uint64_t seed) {
+  fraction = std::clamp(fraction, 0.0, 1.0);
+  size_t count = static_cast<size_t>(std::llround(population * fraction));
+  if (count == 0 && population != 0) count = 1;
+  std::vector<size_t> indexes(population);
+  for (size_t i = 0; i < population; ++i) indexes[i] = i;
+  // A partial Fisher-Yates shuffle; only the first count places are needed.
+  std::mt19937_64 random(seed);
+  for (size_t i = 0; i < count; ++i) {
+    std::uniform_int_distribution<size_t> pick(i, population - 1);
+    std::swap(indexes[i], indexes[pick(random)]);
+  }
+  indexes.resize(count);
+  std::sort(indexes.begin(), indexes.end());
+  return indexes;
+}
+
+SampleEstimate EstimateTotal(const std::vector<SampledChunk>& sample,
+                             size_t population, double population_area) {
+  size_t n = sample.size();
+  double sample_area = 0, sample_value = 0;
+  for (const SampledChunk& chunk : sample) {
+    sample_area += chunk.area;
+    sample_value += chunk.value;
+  }
+  if (n == 0 || sample_area == 0) return {0, 0};
+  double ratio = sample_value / sample_area;
+  double value = ratio * population_area;
+  if (n < 2 || n >= population) return {value, 0};
+
+  // Var = N^2 (1 - n/N) s^2 / n, where s^2 is the variance of the residuals
+  // from the ratio, value - ratio * area.
+  double squares = 0;
+  for (const SampledChunk& chunk : sample) {
+    double residual = chunk.value - ratio * chunk.area;
+    squares += residual * residual;
+  }
+  double N = static_cast<double>(population);
+  double variance = N * N * (1 - n / N) * (squares / (n - 1)) / n;
+  return {value, kZ95 * std::sqrt(variance)};
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "chunk-cache.h"
+
+// Picks round(population * fraction) distinct indexes in [0, population) at
+// random, at least one if population isn't empty, in increasing order so that
+// the chunks they name are read in address order.
+std::vector<size_t> PickSample(size_t population, double fraction, uint64_t seed);
+
+// A total and the half width of its 95% confidence interval.
+struct SampleEstimate {
+  double value;
+  double margin;
+};
+
+// One sampled chunk: its usable area in bytes, and what walking it counted.
+struct SampledChunk {
+  double area;
+  double value;
+};
+
+// Estimates the total of a quantity over all population chunks, whose areas
+// add up to population_area, from its value in a simple random sample of
+// them. Chunks vary in size, so the estimate scales the value per byte of
+// the sample (a ratio estimator) rather than the value per chunk. The margin
+// shrinks to zero as the sample grows to the whole population, so a sample
+// of every chunk gives the same totals as a full walk.
+SampleEstimate EstimateTotal(const std::vector<SampledChunk>& sample,
+                             size_t population, double population_area);
+
+// The objects of one instance type in a chunk.
+struct TypeCount {
+  uint16_t instance_type;
+  uint64_t objects;
+  uint64_t bytes;
+};
+
+// What @$heapstats found in each chunk it walked, kept while the target is
+// stepped so that later queries only walk the chunks that changed.
+struct HistogramCache {
+  ChunkCache<std::vector<TypeCount>> chunks;
+  std::unordered_map<uint16_t, std::string> type_names;
+};
@@ -0,0 +1,251 @@
+#include "heap-stats.h"
+#include "heap-sample.h"
+#include "list-chunks.h"
+#include "object.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+
+namespace {
+
+constexpr double kDefaultFraction = 0.1;
+
+// What one type holds in each sampled chunk, indexed by sample position.
+struct TypeSample {
+  std::string name;
+  std::vector<double> objects;
+  std::vector<double> bytes;
+};
+
+struct TypeEstimate {
+  std::string name;
+  SampleEstimate objects;
+  SampleEstimate bytes;
+};
+
+// Counts the objects and bytes of each type in each sampled chunk. Chunks
+// whose fingerprint is unchanged since an earlier query are taken from the
+// cache; the rest are walked with the same walker as full scans.
+class ChunkSampler {
+ public:
+  ChunkSampler(const MemReader& reader, HistogramCache& cache, size_t sample_size)
+      : reader_(reader), cache_(cache), sample_size_(sample_size) {}
+
+  void VisitChunk(size_t position, const ChunkData& chunk) {
+    uint64_t start = chunk.area_start_address, end = chunk.area_end_address;
+    areas_.push_back(static_cast<double>(end - start));
+    uint64_t fingerprint;
+    bool fingerprinted = FingerprintChunk(
+        reader_, start, end,
+        {chunk.allocated_bytes, chunk.high_water_mark, chunk.allocation_top,
+         chunk.allocation_limit},
+        &fingerprint);
+    const std::vector<TypeCount>* counts =
+        fingerprinted ? cache_.chunks.Find(start, end, fingerprint) : nullptr;
+    std::vector<TypeCount> walked;
+    if (counts == nullptr) {
+      walked = WalkChunk(chunk);
+      counts = &walked;
+      ++walked_chunks_;
+    }
+    for (const TypeCount& count : *counts) {
+      TypeSample& type = GetType(count.instance_type);
+      type.objects[position] += static_cast<double>(count.objects);
+      type.bytes[position] += static_cast<double>(count.bytes);
+    }
+    if (fingerprinted && counts == &walked) {
+      cache_.chunks.Store(start, end, fingerprint, std::move(walked));
+    }
+  }
+
+  size_t walked_chunks() const { return walked_chunks_; }
+
+  // Estimates for all types together, followed by each type in decreasing
+  // order of estimated bytes.
+  std::vector<TypeEstimate> Estimate(size_t population, double population_area) {
+    std::vector<TypeEstimate> estimates;
+    TypeSample all{"", std::vector<double>(sample_size_), std::vector<double>(sample_size_)};
+    for (const TypeSample& type : types_) {
+      for (size_t i = 0; i < sample_size_; ++i) {
+        all.objects[i] += type.objects[i];
+        all.bytes[i] += type.bytes[i];
+      }
+    }
+    estimates.push_back(EstimateType(all, population, population_area));
+    for (const TypeSample& type : types_) {
+      estimates.push_back(EstimateType(type, population, population_area));
+    }
+    std::sort(estimates.begin() + 1, estimates.end(),
+              [](const TypeEstimate& a, const TypeEstimate& b) {
+                return a.bytes.value > b.bytes.value;
+              });
+    return estimates;
+  }
+
+ private:
+  std::vector<TypeCount> WalkChunk(const ChunkData& chunk) {
+    std::unordered_map<uint16_t, TypeCount> counts;
+    HeapObjectWalker walker(reader_, layouts_, chunk.area_start_address,
+                            chunk.area_end_address, chunk.allocation_top,
+                            chunk.allocation_limit);
+    HeapObjectInfo object;
+    while (walker.Next(&object)) {
+      uint16_t instance_type = object.map->instance_type;
+      if (cache_.type_names.count(instance_type) == 0) {
+        const ObjectLayout* layout = layouts_.GetLayout(walker.reader(), object.tagged_ptr);
+        cache_.type_names[instance_type] =
+            layout != nullptr ? layout->type_name
+                              : "instance type " + std::to_string(instance_type);
+      }
+      TypeCount& count = counts.try_emplace(instance_type, TypeCount{instance_type, 0, 0})
+                             .first->second;
+      ++count.objects;
+      count.bytes += object.size;
+    }
+    std::vector<TypeCount> result;
+    for (const auto& [instance_type, count] : counts) result.push_back(count);
+    return result;
+  }
+
+  TypeSample& GetType(uint16_t instance_type) {
+    auto it = type_indexes_.find(instance_type);
+    if (it == type_indexes_.end()) {
+      const std::string& name = cache_.type_names[instance_type];
+      // Types that share a name, such as the string representations that
+      // decode as the same class, are counted together.
+      size_t index = 0;
+      while (index < types_.size() && types_[index].name != name) ++index;
+      if (index == types_.size()) {
+        types_.push_back({name, std::vector<double>(sample_size_),
+                          std::vector<double>(sample_size_)});
+      }
+      it = type_indexes_.emplace(instance_type, index).first;
+    }
+    return types_[it->second];
+  }
+
+  TypeEstimate EstimateType(const TypeSample& type, size_t population,
+                            double population_area) const {
+    std::vector<SampledChunk> objects, bytes;
+    for (size_t i = 0; i < sample_size_; ++i) {
+      objects.push_back({areas_[i], type.objects[i]});
+      bytes.push_back({areas_[i], type.bytes[i]});
+    }
+    return {type.name, EstimateTotal(objects, population, population_area),
+            EstimateTotal(bytes, population, population_area)};
+  }
+
+  MemReader reader_;
+  LayoutCache layouts_;
+  HistogramCache& cache_;
+  size_t sample_size_;
+  size_t walked_chunks_ = 0;
+  std::vector<double> areas_;
+  std::vector<TypeSample> types_;
+  std::unordered_map<uint16_t, size_t> type_indexes_;
+};
+
+HRESULT SetEstimateKeys(IModelObject* p_object, const TypeEstimate& estimate) {
+  winrt::com_ptr<IModelObject> sp_objects, sp_objects_margin, sp_bytes, sp_bytes_margin;
+  HRESULT hr = CreateNumber(std::round(estimate.objects.value), sp_objects.put());
+  if (FAILED(hr)) return hr;
+  hr = p_object->SetKey(L"objects", sp_objects.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateNumber(std::round(estimate.objects.margin), sp_objects_margin.put());
+  if (FAILED(hr)) return hr;
+  hr = p_object->SetKey(L"objects_margin", sp_objects_margin.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateNumber(std::round(estimate.bytes.value), sp_bytes.put());
+  if (FAILED(hr)) return hr;
+  hr = p_object->SetKey(L"bytes", sp_bytes.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateNumber(std::round(estimate.bytes.margin), sp_bytes_margin.put());
+  if (FAILED(hr)) return hr;
+  return p_object->SetKey(L"bytes_margin", sp_bytes_margin.get(), nullptr);
+}
+
+}  // namespace
+
+HRESULT __stdcall HeapStatsAlias::Call(IModelObject* p_context_object,
+                                       ULONG64 arg_count,
+                                       _In_reads_(arg_count)
+                                           IModelObject** pp_arguments,
+                                       IModelObject** pp_result,
+                                       IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count > 2) return E_INVALIDARG;
+  double fraction = kDefaultFraction;
+  if (arg_count >= 1) {
+    VARIANT vt_fraction;
+    HRESULT hr = pp_arguments[0]->GetIntrinsicValueAs(VT_R8, &vt_fraction);
+    if (FAILED(hr)) return hr;
+    if (!(vt_fraction.dblVal > 0 && vt_fraction.dblVal <= 1)) return E_INVALIDARG;
+    fraction = vt_fraction.dblVal;
+  }
+  uint64_t seed = std::random_device()();
+  if (arg_count == 2) {
+    VARIANT vt_seed;
+    HRESULT hr = pp_arguments[1]->GetIntrinsicValueAs(VT_UI8, &vt_seed);
+    if (FAILED(hr)) return hr;
+    seed = vt_seed.ullVal;
+  }
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  std::vector<ChunkData> chunks;
+  hr = GetMemoryChunks(chunks);
+  if (FAILED(hr)) return hr;
+
+  ScopedTrace trace("HeapStats");
+  double population_area = 0;
+  for (const ChunkData& chunk : chunks) {
+    population_area += static_cast<double>(chunk.area_end_address - chunk.area_start_address);
+  }
+  std::shared_ptr<HistogramCache> cache =
+      Extension::current_extension_->GetHistogramCache();
+  std::vector<uint64_t> chunk_starts;
+  for (const ChunkData& chunk : chunks) chunk_starts.push_back(chunk.area_start_address);
+  cache->chunks.Sweep(chunk_starts);
+  std::vector<size_t> sample = PickSample(chunks.size(), fraction, seed);
+  ChunkSampler sampler(GetMemReader(sp_ctx), *cache, sample.size());
+  for (size_t i = 0; i < sample.size(); ++i) sampler.VisitChunk(i, chunks[sample[i]]);
+  std::vector<TypeEstimate> estimates = sampler.Estimate(chunks.size(), population_area);
+
+  winrt::com_ptr<IModelObject> sp_result;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"chunks", chunks.size());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"sampled_chunks", sample.size());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"walked_chunks", sampler.walked_chunks());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"seed", seed);
+  if (FAILED(hr)) return hr;
+  hr = SetEstimateKeys(sp_result.get(), estimates[0]);
+  if (FAILED(hr)) return hr;
+
+  ModelObjectVector types;
+  for (size_t i = 1; i < estimates.size(); ++i) {
+    winrt::com_ptr<IModelObject> sp_type, sp_name;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_type.put());
+    if (FAILED(hr)) return hr;
+    hr = CreateString(ConvertToU16String(estimates[i].name), sp_name.put());
+    if (FAILED(hr)) return hr;
+    hr = sp_type->SetKey(L"type", sp_name.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    hr = SetEstimateKeys(sp_type.get(), estimates[i]);
+    if (FAILED(hr)) return hr;
+    types.push_back(std::move(sp_type));
+  }
+  winrt::com_ptr<IModelObject> sp_types;
+  hr = CreateModelObjectList(sp_ctx, std::move(types), sp_types.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"by_type", sp_types.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <crtdbg.h>
+#include "../utilities.h"
+#include "extension.h"
+#include "v8.h"
+
+// @$heapstats([fraction], [seed]) - objects and bytes by type, estimated from
+// a random sample of fraction (default 0.1) of the chunks, each with the half
+// width of its 95% confidence interval. Smaller fractions are faster and less
+// accurate; @$heapstats(1) walks every chunk and gives exact totals. Passing
+// a seed repeats an earlier sample. What each chunk held is kept between
+// stops, so while stepping only the chunks that changed are walked again.
+struct HeapStatsAlias : winrt::implements<HeapStatsAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
@@ -0,0 +1,236 @@
+#include "js-stack-model.h"
+#include "curisolate.h"
+#include "list-chunks.h"
+#include "object.h"
+#include "trace.h"
+#include <unordered_map>
+
+namespace {
+
+constexpr uint64_t kDefaultFrameCount = 100;
+
+constexpr size_t kMaxScriptNameLength = 256;
+
+// The frame type markers of the JSEntry frames, or none if StackFrame::Type
+// isn't in the symbols.
+std::vector<uint64_t> GetEntryFrameMarkers(winrt::com_ptr<IDebugHostContext>& sp_ctx) {
+  std::vector<uint64_t> markers;
+  winrt::com_ptr<IDebugHostType> sp_type = Extension::current_extension_->GetV8ObjectType(
+      sp_ctx, u"v8::internal::StackFrame::Type");
+  std::unordered_map<int64_t, std::wstring> names;
+  if (sp_type == nullptr || !GetEnumNames(sp_type, &names)) return markers;
+  for (const auto& entry : names) {
+    if (entry.second == L"ENTRY" || entry.second == L"CONSTRUCT_ENTRY") {
+      markers.push_back(GetFrameTypeMarker(entry.first));
+    }
+  }
+  return markers;
+}
+
+// Indexes every Code and InstructionStream object in the code spaces. Other
+// spaces are only walked if the chunks don't say which spaces hold code.
+std::shared_ptr<const CodeRangeIndex> BuildCodeIndex(const MemReader& reader) {
+  ScopedTrace trace("BuildCodeIndex");
+  auto index = std::make_shared<CodeRangeIndex>();
+  std::vector<ChunkData> chunks;
+  if (FAILED(GetMemoryChunks(chunks))) return index;
+  bool have_code_spaces = false;
+  for (const ChunkData& chunk : chunks) {
+    if (chunk.space_name.find(L"CODE") != std::wstring::npos) have_code_spaces = true;
+  }
+
+  LayoutCache cache;
+  std::unordered_map<uint16_t, bool> is_code_type;
+  for (const ChunkData& chunk : chunks) {
+    if (have_code_spaces && chunk.space_name.find(L"CODE") == std::wstring::npos) {
+      continue;
+    }
+    HeapObjectWalker walker(reader, cache, chunk.area_start_address,
+                            chunk.area_end_address, chunk.allocation_top,
+                            chunk.allocation_limit);
+    HeapObjectInfo object;
+    while (walker.Next(&object)) {
+      uint16_t instance_type = object.map->instance_type;
+      auto it = is_code_type.find(instance_type);
+      if (it == is_code_type.end()) {
+        const ObjectLayout* layout = cache.GetLayout(walker.reader(), object.tagged_ptr);
+        bool is_code = layout != nullptr &&
+                       (layout->type_name == "v8::internal::Code" ||
+                        layout->type_name == "v8::internal::InstructionStream");
+        it = is_code_type.emplace(instance_type, is_code).first;
+      }
+      if (!it->second) continue;
+      uint64_t start = object.tagged_ptr & ~kHeapObjectTagMask;
+      index->Add({start, start + object.size, object.tagged_ptr});
+    }
+  }
+  index->Build();
+  return index;
+}
+
+std::shared_ptr<const CodeRangeIndex> GetCodeIndex(const MemReader& reader) {
+  std::shared_ptr<const CodeRangeIndex> index =
+      Extension::current_extension_->GetCodeIndex();
+  if (index == nullptr) {
+    index = BuildCodeIndex(reader);
+    Extension::current_extension_->SetCodeIndex(index);
+  }
+  return index;
+}
+
+HRESULT GetRegister(winrt::com_ptr<IDebugHostContext>& sp_ctx, const wchar_t* name,
+                    uint64_t* p_value) {
+  winrt::com_ptr<IModelObject> sp_thread, sp_registers, sp_user, sp_register;
+  if (!GetCurrentThread(sp_ctx, sp_thread.put())) return E_FAIL;
+  HRESULT hr = sp_thread->GetKeyValue(L"Registers", sp_registers.put(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = sp_registers->GetKeyValue(L"User", sp_user.put(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = sp_user->GetKeyValue(name, sp_register.put(), nullptr);
+  if (FAILED(hr)) return hr;
+  VARIANT vt_value;
+  hr = sp_register->GetIntrinsicValueAs(VT_UI8, &vt_value);
+  if (FAILED(hr)) return hr;
+  *p_value = vt_value.ullVal;
+  return S_OK;
+}
+
+bool ReadField(const MemReader& reader, LayoutCache& cache, uint64_t tagged_ptr,
+               const char* name, uint64_t* value) {
+  const ObjectLayout* layout = cache.GetLayout(reader, tagged_ptr);
+  const FieldLayout* field = layout != nullptr ? layout->FindField(name) : nullptr;
+  return field != nullptr &&
+         cache.ReadTagged(reader, (tagged_ptr & ~kHeapObjectTagMask) + field->offset,
+                          value);
+}
+
+bool IsType(const MemReader& reader, LayoutCache& cache, uint64_t tagged_ptr,
+            const char* type_name) {
+  if ((tagged_ptr & kHeapObjectTagMask) != kHeapObjectTag) return false;
+  const ObjectLayout* layout = cache.GetLayout(reader, tagged_ptr);
+  return layout != nullptr && layout->type_name == type_name;
+}
+
+// The name of the script that function's code came from, or "" if unknown.
+std::u16string GetScriptName(const MemReader& reader, LayoutCache& cache,
+                             uint64_t function) {
+  uint64_t shared, script, name;
+  if (!ReadField(reader, cache, function, "shared_function_info", &shared)) return u"";
+  // Renamed when DebugInfo moved out of SharedFunctionInfo.
+  if (!ReadField(reader, cache, shared, "script_or_debug_info", &script) &&
+      !ReadField(reader, cache, shared, "script", &script)) {
+    return u"";
+  }
+  if (!IsType(reader, cache, script, "v8::internal::Script") ||
+      !ReadField(reader, cache, script, "name", &name)) {
+    return u"";
+  }
+  std::u16string result;
+  ReadV8String(reader, cache, name, kMaxScriptNameLength,
+               [&result](const char16_t* data, size_t length) {
+                 result.append(data, length);
+                 return true;
+               });
+  return result;
+}
+
+}  // namespace
+
+HRESULT __stdcall JsStackAlias::Call(IModelObject* p_context_object,
+                                     ULONG64 arg_count,
+                                     _In_reads_(arg_count)
+                                         IModelObject** pp_arguments,
+                                     IModelObject** pp_result,
+                                     IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count > 1) return E_INVALIDARG;
+  uint64_t max_frames = kDefaultFrameCount;
+  if (arg_count == 1) {
+    VARIANT vt_count;
+    HRESULT hr = pp_arguments[0]->GetIntrinsicValueAs(VT_UI8, &vt_count);
+    if (FAILED(hr)) return hr;
+    max_frames = vt_count.ullVal;
+  }
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  winrt::com_ptr<IModelObject> sp_isolate, sp_thread_local_top;
+  hr = GetCurrentIsolate(sp_isolate);
+  if (FAILED(hr)) return hr;
+  hr = sp_isolate->GetRawValue(SymbolField, L"thread_local_top_", RawSearchNone,
+                               sp_thread_local_top.put());
+  if (FAILED(hr)) return hr;
+  // c_entry_fp_ is the exit frame of the last call from JavaScript into C++,
+  // and the walk stops where the outermost JavaScript was entered.
+  ULONG64 fp, stack_end;
+  hr = GetFieldValue(sp_thread_local_top, L"c_entry_fp_", &fp);
+  if (FAILED(hr)) return hr;
+  hr = GetFieldValue(sp_thread_local_top, L"js_entry_sp_", &stack_end);
+  if (FAILED(hr)) return hr;
+  if (fp == 0 && stack_end == 0) {
+    // The thread isn't running JavaScript.
+    return CreateModelObjectList(sp_ctx, {}, pp_result);
+  }
+  if (fp == 0) {
+    // Not in a call out of JavaScript, so start from the thread's own frame.
+    uint64_t rbp;
+    hr = GetRegister(sp_ctx, L"rbp", &rbp);
+    if (FAILED(hr)) return hr;
+    fp = rbp;
+  }
+
+  ScopedTrace trace("JsStack");
+  MemReader reader = GetMemReader(sp_ctx);
+  std::shared_ptr<const CodeRangeIndex> index = GetCodeIndex(reader);
+  LayoutCache cache;
+  ModelObjectVector frames;
+  for (const StackFrame& frame :
+       WalkFramePointers(reader, fp, stack_end, static_cast<size_t>(max_frames),
+                         GetEntryFrameMarkers(sp_ctx))) {
+    winrt::com_ptr<IModelObject> sp_frame;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_frame.put());
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_frame.get(), L"fp", frame.fp);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_frame.get(), L"pc", frame.pc);
+    if (FAILED(hr)) return hr;
+
+    // Code on the heap is found in the index; anything else is embedded in
+    // the binary, such as builtins and the interpreter.
+    const CodeRange* code = index->Find(frame.pc);
+    if (code != nullptr) {
+      winrt::com_ptr<IModelObject> sp_code;
+      hr = CreateV8HeapObjectModel(sp_ctx, code->tagged_ptr, sp_code.put());
+      if (FAILED(hr)) return hr;
+      hr = sp_frame->SetKey(L"code", sp_code.get(), nullptr);
+      if (FAILED(hr)) return hr;
+      hr = SetULong64Key(sp_frame.get(), L"pc_offset", frame.pc - code->start);
+      if (FAILED(hr)) return hr;
+    }
+
+    uint64_t function;
+    bool is_js = ReadFrameFunction(reader, frame.fp, &function) &&
+                 IsType(reader, cache, function, "v8::internal::JSFunction");
+    hr = SetStringKey(sp_frame.get(), L"type", is_js ? L"javascript" : L"native");
+    if (FAILED(hr)) return hr;
+    if (is_js) {
+      winrt::com_ptr<IModelObject> sp_function, sp_name, sp_script;
+      hr = CreateV8HeapObjectModel(sp_ctx, function, sp_function.put());
+      if (FAILED(hr)) return hr;
+      hr = sp_frame->SetKey(L"function", sp_function.get(), nullptr);
+      if (FAILED(hr)) return hr;
+      hr = CreateString(ConvertToU16String(GetObjectBrief(reader, function)),
+                        sp_name.put());
+      if (FAILED(hr)) return hr;
+      hr = sp_frame->SetKey(L"name", sp_name.get(), nullptr);
+      if (FAILED(hr)) return hr;
+      hr = CreateString(GetScriptName(reader, cache, function), sp_script.put());
+      if (FAILED(hr)) return hr;
+      hr = sp_frame->SetKey(L"script", sp_script.get(), nullptr);
+      if (FAILED(hr)) return hr;
+    }
+    frames.push_back(std::move(sp_frame));
+  }
+  return CreateModelObjectList(sp_ctx, std::move(frames), pp_result);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <crtdbg.h>
+#include "../utilities.h"
+#include "extension.h"
+#include "js-stack.h"
+#include "v8.h"
+
+// @$jsstack([count]) - the JavaScript frames of the current thread, found by
+// following V8's frame pointers from the isolate's last exit to C++ rather
+// than through the debugger's unwinder. Each frame's pc is looked up in an
+// index of code space that is built once per stop. At most count frames
+// (default 100) are returned.
+struct JsStackAlias : winrt::implements<JsStackAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
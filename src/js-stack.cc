@@ -0,0 +1,84 @@
+#include "js-stack.h"
+#include <algorithm>
+
+namespace {
+
+// StandardFrameConstants on x64, below fp.
+constexpr uint64_t kContextOrFrameTypeOffset = 8;
+constexpr uint64_t kFunctionOffset = 16;
+
+// EntryFrameConstants::kNextExitFrameFPOffset on Windows x64, below fp: where
+// JSEntry saves the isolate's c_entry_fp, past the callee-saved registers.
+constexpr uint64_t kNextExitFrameFPOffset = 10 * 8 + 10 * 16;
+
+constexpr uint64_t kHeapObjectTag = 1;
+
+}  // namespace
+
+void CodeRangeIndex::Build() {
+  std::sort(ranges_.begin(), ranges_.end(),
+            [](const CodeRange& a, const CodeRange& b) { return a.start < b.start; });
+}
+
+const CodeRange* CodeRangeIndex::Find(uint64_t pc) const {
+  // The last range starting at or before pc is the only one that can hold it,
+  // as objects don't overlap.
+  auto it = std::upper_bound(
+      ranges_.begin(), ranges_.end(), pc,
+      [](uint64_t pc, const CodeRange& range) { return pc < range.start; });
+  if (it == ranges_.begin()) return nullptr;
+  --it;
+  return pc < it->end ? &*it : nullptr;
+}
+
+uint64_t GetFrameTypeMarker(int64_t type) {
+  return static_cast<uint64_t>(type) << 1;
+}
+
+std::vector<StackFrame> WalkFramePointers(const MemReader& reader, uint64_t fp,
+                                          uint64_t stack_end, size_t max_frames,
+                                          const std::vector<uint64_t>& entry_markers) {
+  std::vector<StackFrame> frames;
+  auto is_past_end = [stack_end](uint64_t fp, uint64_t caller_fp) {
+    return caller_fp <= fp || (stack_end != 0 && caller_fp >= stack_end);
+  };
+  while (frames.size() < max_frames) {
+    uint64_t saved[2];  // {caller fp, return address}
+    if (!reader(fp, sizeof(saved), reinterpret_cast<uint8_t*>(saved))) break;
+    uint64_t caller_fp = saved[0];
+    if (is_past_end(fp, caller_fp)) break;
+    frames.push_back({caller_fp, saved[1]});
+    fp = caller_fp;
+
+    uint64_t marker;
+    if (entry_markers.empty() ||
+        !reader(fp - kContextOrFrameTypeOffset, sizeof(marker),
+                reinterpret_cast<uint8_t*>(&marker)) ||
+        std::find(entry_markers.begin(), entry_markers.end(), marker) ==
+            entry_markers.end()) {
+      continue;
+    }
+    uint64_t exit_fp;
+    if (!reader(fp - kNextExitFrameFPOffset, sizeof(exit_fp),
+                reinterpret_cast<uint8_t*>(&exit_fp)) ||
+        is_past_end(fp, exit_fp)) {
+      break;  // The outermost entry, or a bad frame.
+    }
+    fp = exit_fp;
+  }
+  return frames;
+}
+
+bool ReadFrameFunction(const MemReader& reader, uint64_t fp, uint64_t* function) {
+  uint64_t slots[2];  // {function, context or frame type marker}
+  if (!reader(fp - kFunctionOffset, sizeof(slots), reinterpret_cast<uint8_t*>(slots))) {
+    return false;
+  }
+  static_assert(kContextOrFrameTypeOffset + 8 == kFunctionOffset,
+                "slots are read together");
+  if ((slots[1] & kHeapObjectTag) == 0 || (slots[0] & kHeapObjectTag) == 0) {
+    return false;
+  }
+  *function = slots[0];
+  return true;
+}
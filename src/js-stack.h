@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "mem-reader.h"
+
+// The extent of one Code (or InstructionStream) object in code space.
+struct CodeRange {
+  uint64_t start;
+  uint64_t end;
+  uint64_t tagged_ptr;
+};
+
+// Maps program counters to the code objects that hold them. Ranges are added
+// in any order, sorted once, then searched in O(log n).
+class CodeRangeIndex {
+ public:
+  void Add(const CodeRange& range) { ranges_.push_back(range); }
+
+  // Sorts the ranges. Call after the last Add and before Find.
+  void Build();
+
+  // The range holding pc, or null if pc isn't in any of them.
+  const CodeRange* Find(uint64_t pc) const;
+
+  size_t size() const { return ranges_.size(); }
+
+ private:
+  std::vector<CodeRange> ranges_;
+};
+
+struct StackFrame {
+  uint64_t fp;
+  uint64_t pc;  // Where execution is in the frame: the callee's return address.
+};
+
+// The value a typed frame keeps in its frame type slot for a
+// StackFrame::Type (StackFrame::TypeToMarker).
+uint64_t GetFrameTypeMarker(int64_t type);
+
+// Follows the chain of frame pointers that every V8 frame keeps, starting
+// with the frame whose fp is given: each frame saves its caller's fp at fp and
+// the return address into its caller just above it. Returns the callers, in
+// order. Stops at a caller fp of 0, one that doesn't move up the stack, one at
+// or beyond stack_end (0 for no limit), an unreadable frame, or max_frames.
+//
+// A JSEntry frame, whose frame type marker is one of entry_markers, was called
+// from C++, which need not keep frame pointers. As V8's StackFrameIterator
+// does, the walk continues from the exit frame that the entry frame saved,
+// that of the call out of JavaScript that led to it, skipping the C++ frames.
+std::vector<StackFrame> WalkFramePointers(const MemReader& reader, uint64_t fp,
+                                          uint64_t stack_end, size_t max_frames,
+                                          const std::vector<uint64_t>& entry_markers);
+
+// Reads the function of the JavaScript frame whose fp is given. Stack slots
+// are whole words even when heap pointers are compressed. False for a typed
+// (non-JavaScript) frame, which holds a Smi frame type marker where a
+// JavaScript frame holds its context, or if the function slot isn't a heap
+// object.
+bool ReadFrameFunction(const MemReader& reader, uint64_t fp, uint64_t* function);
@@ -0,0 +1,148 @@
+#include "largest.h"
+#include "object.h"
+#include "top-n.h"
+#include "trace.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+struct LargeObject {
+  uint64_t size;
+  uint64_t tagged_ptr;
+};
+
+struct IsSmaller {
+  bool operator()(const LargeObject& a, const LargeObject& b) const {
+    return a.size < b.size;
+  }
+};
+
+// Selects the largest objects while walking chunks by map and size. No object
+// is bigger than the chunk it is in, so once count objects are kept, chunks
+// no bigger than the smallest of them are skipped, as is the rest of a chunk
+// once too few bytes are left in it.
+class LargestObjects {
+ public:
+  LargestObjects(const MemReader& reader, size_t count, std::string type_name)
+      : reader_(reader), type_name_(std::move(type_name)), top_(count) {}
+
+  void VisitChunk(const ChunkData& chunk) {
+    if (!CanHold(chunk.area_end_address - chunk.area_start_address)) return;
+    HeapObjectWalker walker(reader_, cache_, chunk.area_start_address,
+                            chunk.area_end_address, chunk.allocation_top,
+                            chunk.allocation_limit);
+    HeapObjectInfo object;
+    while (walker.Next(&object)) {
+      if (CanHold(object.size) && IsWanted(walker, object)) {
+        top_.Push({object.size, object.tagged_ptr});
+      }
+      uint64_t end = (object.tagged_ptr & ~kHeapObjectTagMask) + object.size;
+      if (!CanHold(chunk.area_end_address - end)) break;
+    }
+  }
+
+  // Returns the largest objects, largest first. Call once, after the walk.
+  std::vector<LargeObject> Take() { return top_.Take(); }
+
+  // The type of an object already walked, or "" if it couldn't be decoded.
+  std::string GetTypeName(uint64_t tagged_ptr) {
+    const ObjectLayout* layout = cache_.GetLayout(reader_, tagged_ptr);
+    return layout != nullptr ? layout->type_name : std::string();
+  }
+
+ private:
+  // Whether an object of size bytes could still make the selection. Nothing
+  // can if the count is 0, so then no chunk is walked at all.
+  bool CanHold(uint64_t size) const {
+    if (!top_.full()) return true;
+    return !top_.empty() && size > top_.least().size;
+  }
+
+  bool IsWanted(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    if (type_name_.empty()) return true;
+    uint16_t instance_type = object.map->instance_type;
+    auto it = is_wanted_type_.find(instance_type);
+    if (it != is_wanted_type_.end()) return it->second;
+    const ObjectLayout* layout = cache_.GetLayout(walker.reader(), object.tagged_ptr);
+    bool is_wanted = layout != nullptr && layout->type_name == type_name_;
+    is_wanted_type_.emplace(instance_type, is_wanted);
+    return is_wanted;
+  }
+
+  MemReader reader_;
+  LayoutCache cache_;
+  std::string type_name_;  // Empty to select objects of any type.
+  std::unordered_map<uint16_t, bool> is_wanted_type_;
+  BoundedTopN<LargeObject, IsSmaller> top_;
+};
+
+}  // namespace
+
+HRESULT __stdcall LargestAlias::Call(IModelObject* p_context_object,
+                                     ULONG64 arg_count,
+                                     _In_reads_(arg_count)
+                                         IModelObject** pp_arguments,
+                                     IModelObject** pp_result,
+                                     IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count < 1 || arg_count > 2) return E_INVALIDARG;
+  VARIANT vt_count;
+  HRESULT hr = pp_arguments[0]->GetIntrinsicValueAs(VT_UI8, &vt_count);
+  if (FAILED(hr)) return hr;
+  std::string type_name;
+  if (arg_count == 2) {
+    VARIANT vt_type;
+    hr = pp_arguments[1]->GetIntrinsicValue(&vt_type);
+    if (FAILED(hr)) return hr;
+    if (vt_type.vt != VT_BSTR) {
+      ::VariantClear(&vt_type);
+      return E_INVALIDARG;
+    }
+    for (const wchar_t* p = vt_type.bstrVal; *p != L'\0'; ++p) {
+      type_name.push_back(static_cast<char>(*p));
+    }
+    ::VariantClear(&vt_type);
+    if (type_name.find("::") == std::string::npos) {
+      type_name = "v8::internal::" + type_name;
+    }
+  }
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  std::vector<ChunkData> chunks;
+  hr = GetMemoryChunks(chunks);
+  if (FAILED(hr)) return hr;
+
+  ScopedTrace trace("Largest");
+  // Largest chunks first, so that large object spaces fill the selection and
+  // more of the regular pages can be skipped.
+  std::sort(chunks.begin(), chunks.end(), [](const ChunkData& a, const ChunkData& b) {
+    return a.area_end_address - a.area_start_address >
+           b.area_end_address - b.area_start_address;
+  });
+  LargestObjects largest(GetMemReader(sp_ctx), static_cast<size_t>(vt_count.ullVal),
+                         std::move(type_name));
+  for (const ChunkData& chunk : chunks) largest.VisitChunk(chunk);
+
+  ModelObjectVector entries;
+  for (const LargeObject& object : largest.Take()) {
+    winrt::com_ptr<IModelObject> sp_entry, sp_object, sp_type;
+    hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_entry.put());
+    if (FAILED(hr)) return hr;
+    hr = CreateV8HeapObjectModel(sp_ctx, object.tagged_ptr, sp_object.put());
+    if (FAILED(hr)) return hr;
+    hr = sp_entry->SetKey(L"object", sp_object.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"size", object.size);
+    if (FAILED(hr)) return hr;
+    hr = CreateString(ConvertToU16String(largest.GetTypeName(object.tagged_ptr)),
+                      sp_type.put());
+    if (FAILED(hr)) return hr;
+    hr = sp_entry->SetKey(L"type", sp_type.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    entries.push_back(std::move(sp_entry));
+  }
+  return CreateModelObjectList(sp_ctx, std::move(entries), pp_result);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <crtdbg.h>
+#include "../utilities.h"
+#include "extension.h"
+#include "list-chunks.h"
+#include "v8.h"
+
+// @$largest(count, [type]) - the count largest objects on the heap, including
+// large object spaces, optionally only those of the given type (such as
+// "JSArray" or "v8::internal::SeqOneByteString").
+struct LargestAlias : winrt::implements<LargestAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
@@ -1,5 +1,8 @@
 #include "list-chunks.h"
 #include "curisolate.h"
+#include "stats.h"
+#include "trace.h"
+#include <unordered_map>
 
 // v8dbg!ListChunksAlias::Call
 HRESULT __stdcall ListChunksAlias::Call(IModelObject* p_context_object,
@@ -29,6 +32,98 @@ HRESULT __stdcall ListChunksAlias::Call(IModelObject* p_context_object,
 }
 
 HRESULT MemoryChunkIterator::PopulateChunkData() {
+  return GetMemoryChunks(chunks);
+}
+
+namespace {
+
+// Names a space by its "id_", an AllocationSpace. The enum's names are looked
+// up once and kept in p_names. Falls back to the space's index in the heap.
+std::wstring GetSpaceName(winrt::com_ptr<IModelObject>& sp_space, size_t index,
+                          std::unordered_map<int64_t, std::wstring>* p_names) {
+  winrt::com_ptr<IModelObject> sp_id;
+  winrt::com_ptr<IDebugHostType> sp_id_type;
+  VARIANT vt_id;
+  if (SUCCEEDED(sp_space->GetRawValue(SymbolField, L"id_", RawSearchNone, sp_id.put())) &&
+      SUCCEEDED(sp_id->GetIntrinsicValueAs(VT_I8, &vt_id))) {
+    if (p_names->empty() && SUCCEEDED(sp_id->GetTypeInfo(sp_id_type.put()))) {
+      GetEnumNames(sp_id_type, p_names);
+    }
+    auto it = p_names->find(vt_id.llVal);
+    if (it != p_names->end()) return it->second;
+  }
+  return L"space " + std::to_wstring(index);
+}
+
+// Reads a word-sized field straight from its location, as it may be wrapped
+// in std::atomic.
+bool ReadWordField(winrt::com_ptr<IModelObject>& sp_object, const wchar_t* name,
+                   uint64_t* value) {
+  winrt::com_ptr<IModelObject> sp_field;
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  Location location;
+  ULONG64 bytes_read;
+  return SUCCEEDED(sp_object->GetRawValue(SymbolField, name, RawSearchNone,
+                                          sp_field.put())) &&
+         SUCCEEDED(sp_field->GetLocation(&location)) &&
+         SUCCEEDED(sp_field->GetContext(sp_ctx.put())) &&
+         SUCCEEDED(Extension::current_extension_->sp_debug_host_memory_->ReadBytes(
+             sp_ctx.get(), location, value, sizeof(*value), &bytes_read)) &&
+         bytes_read == sizeof(*value);
+}
+
+// Reads the top and limit of the LinearAllocationArea in field of sp_owner,
+// or of the one that field points to.
+bool ReadAllocationInfo(winrt::com_ptr<IModelObject>& sp_owner, const wchar_t* field,
+                        uint64_t* p_top, uint64_t* p_limit) {
+  winrt::com_ptr<IModelObject> sp_info, sp_target;
+  if (FAILED(sp_owner->GetRawValue(SymbolField, field, RawSearchNone, sp_info.put()))) {
+    return false;
+  }
+  if (SUCCEEDED(sp_info->Dereference(sp_target.put()))) sp_info = sp_target;
+  return ReadWordField(sp_info, L"top_", p_top) &&
+         ReadWordField(sp_info, L"limit_", p_limit) && *p_top <= *p_limit;
+}
+
+// Finds the linear allocation area a space bump allocates into. Depending on
+// the V8 version it is kept by the space (in SpaceWithLinearArea, a base of
+// the space's real type) or by the heap for each kind of space. Large object
+// spaces have none.
+void GetAllocationArea(winrt::com_ptr<IModelObject>& sp_heap, uint64_t space_address,
+                       const std::wstring& space_name, uint64_t* p_top,
+                       uint64_t* p_limit) {
+  *p_top = *p_limit = 0;
+  if (space_name.find(L"LO_SPACE") != std::wstring::npos) return;
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  winrt::com_ptr<IModelObject> sp_space;
+  if (SUCCEEDED(sp_heap->GetContext(sp_ctx.put()))) {
+    winrt::com_ptr<IDebugHostType> sp_type = Extension::current_extension_->GetV8ObjectType(
+        sp_ctx, space_name == L"NEW_SPACE" ? u"v8::internal::NewSpace"
+                                           : u"v8::internal::PagedSpace");
+    if (sp_type != nullptr &&
+        SUCCEEDED(sp_data_model_manager->CreateTypedObject(
+            sp_ctx.get(), Location{space_address}, sp_type.get(), sp_space.put())) &&
+        ReadAllocationInfo(sp_space, L"allocation_info_", p_top, p_limit)) {
+      return;
+    }
+  }
+
+  const wchar_t* heap_field = space_name == L"NEW_SPACE"    ? L"new_allocation_info_"
+                              : space_name == L"OLD_SPACE"  ? L"old_allocation_info_"
+                              : space_name == L"CODE_SPACE" ? L"code_allocation_info_"
+                                                            : nullptr;
+  if (heap_field == nullptr || !ReadAllocationInfo(sp_heap, heap_field, p_top, p_limit)) {
+    *p_top = *p_limit = 0;
+  }
+}
+
+}  // namespace
+
+HRESULT GetMemoryChunks(std::vector<ChunkData>& chunks) {
+  ScopedTrace trace("GetMemoryChunks");
+  ScopedLatency latency(Timer::kChunkList);
+  IncrementCounter(Counter::kChunkListBuilds);
   winrt::com_ptr<IModelObject> sp_isolate, sp_heap, sp_space;
   chunks.clear();
 
@@ -56,12 +151,21 @@ HRESULT MemoryChunkIterator::PopulateChunkData() {
 
   // Loop through all the spaces in the array
   winrt::com_ptr<IModelObject> sp_space_ptr;
+  std::unordered_map<int64_t, std::wstring> space_names;
+  size_t space_index = 0;
   while (sp_space_iterator->GetNext(sp_space_ptr.put(), 0, nullptr, nullptr) != E_BOUNDS) {
     // Should have gotten a "v8::internal::Space *". Dereference, then get field
     // "memory_chunk_list_" [Type: v8::base::List<v8::internal::MemoryChunk>]
     winrt::com_ptr<IModelObject> sp_space, sp_chunk_list, sp_mem_chunk_ptr, sp_mem_chunk;
     hr = sp_space_ptr->Dereference(sp_space.put());
     if (FAILED(hr)) return hr;
+    std::wstring space_name = GetSpaceName(sp_space, space_index++, &space_names);
+    VARIANT vt_space;
+    uint64_t allocation_top = 0, allocation_limit = 0;
+    if (SUCCEEDED(sp_space_ptr->GetIntrinsicValueAs(VT_UI8, &vt_space))) {
+      GetAllocationArea(sp_heap, vt_space.ullVal, space_name, &allocation_top,
+                        &allocation_limit);
+    }
     hr = sp_space->GetRawValue(SymbolField, L"memory_chunk_list_", RawSearchNone, sp_chunk_list.put());
     if (FAILED(hr)) return hr;
 
@@ -100,6 +204,24 @@ HRESULT MemoryChunkIterator::PopulateChunkData() {
       chunk_entry.area_start = sp_start;
       chunk_entry.area_end = sp_end;
       chunk_entry.space = sp_space;
+      chunk_entry.area_start_address = vt_start.ullVal;
+      chunk_entry.area_end_address = vt_end.ullVal;
+      chunk_entry.space_name = space_name;
+      // The mark is kept as an offset from the chunk's own address.
+      uint64_t high_water_mark;
+      chunk_entry.high_water_mark =
+          ReadWordField(sp_mem_chunk, L"high_water_mark_", &high_water_mark) &&
+                  high_water_mark != 0
+              ? vt_front_val.ullVal + high_water_mark
+              : 0;
+      if (!ReadWordField(sp_mem_chunk, L"allocated_bytes_",
+                         &chunk_entry.allocated_bytes)) {
+        chunk_entry.allocated_bytes = 0;
+      }
+      bool holds_allocation_area = allocation_top >= chunk_entry.area_start_address &&
+                                   allocation_limit <= chunk_entry.area_end_address;
+      chunk_entry.allocation_top = holds_allocation_area ? allocation_top : 0;
+      chunk_entry.allocation_limit = holds_allocation_area ? allocation_limit : 0;
       chunks.push_back(chunk_entry);
 
       // Follow the list_node_.next_ to the next memory chunk
@@ -19,8 +19,22 @@ struct ChunkData {
   winrt::com_ptr<IModelObject> area_start;
   winrt::com_ptr<IModelObject> area_end;
   winrt::com_ptr<IModelObject> space;
+  uint64_t area_start_address;
+  uint64_t area_end_address;
+  // Where the highest allocation in the chunk has ended, or 0 if unknown.
+  uint64_t high_water_mark;
+  uint64_t allocated_bytes;  // 0 if unknown.
+  // The space's linear allocation area, if it is in this chunk: objects end
+  // at its top, and nothing has been allocated from there to its limit yet.
+  // Both 0 otherwise.
+  uint64_t allocation_top;
+  uint64_t allocation_limit;
+  std::wstring space_name;  // The space's AllocationSpace, e.g. "OLD_SPACE".
 };
 
+// Collects the MemoryChunks of every space in the current isolate's heap.
+HRESULT GetMemoryChunks(std::vector<ChunkData>& chunks);
+
 
 struct MemoryChunkIterator: winrt::implements<MemoryChunkIterator, IModelIterator> {
   MemoryChunkIterator(winrt::com_ptr<IDebugHostContext>& host_context): sp_ctx(host_context){};
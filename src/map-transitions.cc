@@ -0,0 +1,329 @@
+#include "map-transitions.h"
+#include "object.h"
+#include "trace.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint64_t kDefaultCount = 20;
+constexpr uint32_t kNoMap = UINT32_MAX;
+
+// Maps are linked by index rather than by pointer, to keep each node small
+// enough for heaps with hundreds of thousands of maps.
+struct MapNode {
+  uint64_t address;
+  uint64_t back_pointer;  // Parent map, or a constructor for a root map.
+  uint32_t parent = kNoMap;
+  uint32_t first_child = kNoMap;
+  uint32_t next_sibling = kNoMap;
+  uint32_t children = 0;
+  uint32_t depth = 0;
+  uint32_t instances = 0;
+  bool deprecated = false;
+};
+
+struct TransitionTree {
+  uint32_t root;
+  uint32_t maps = 0;
+  uint32_t depth = 0;  // Of the deepest map; a lone root has depth 0.
+  uint32_t width = 0;  // Most transitions out of any one map.
+};
+
+// Collects every Map and counts every object's map in one pass over the heap,
+// then links the maps by their back pointers. A transitioned map's back
+// pointer is its parent; a root map's holds its constructor instead.
+class TransitionForest {
+ public:
+  explicit TransitionForest(const MemReader& reader) : reader_(reader) {}
+
+  void VisitChunk(const ChunkData& chunk) {
+    HeapObjectWalker walker(reader_, cache_, chunk.area_start_address,
+                            chunk.area_end_address, chunk.allocation_top,
+                            chunk.allocation_limit);
+    HeapObjectInfo object;
+    while (walker.Next(&object)) {
+      uint64_t start = object.tagged_ptr & ~kHeapObjectTagMask;
+      uint64_t map;
+      if (cache_.ReadTagged(walker.reader(), start, &map)) ++instances_[map];
+      if (IsMap(walker, object)) VisitMap(walker, object);
+    }
+  }
+
+  // Links the maps into trees. Call once, after the pass.
+  void Build() {
+    std::sort(nodes_.begin(), nodes_.end(),
+              [](const MapNode& a, const MapNode& b) { return a.address < b.address; });
+    for (MapNode& node : nodes_) {
+      auto it = instances_.find(node.address);
+      if (it != instances_.end()) node.instances = it->second;
+    }
+    instances_ = {};
+
+    for (uint32_t i = 0; i < nodes_.size(); ++i) {
+      MapNode& node = nodes_[i];
+      if (node.deprecated) ++deprecated_;
+      uint32_t parent = Find(node.back_pointer);
+      if (parent == kNoMap || parent == i) continue;
+      node.parent = parent;
+      node.next_sibling = nodes_[parent].first_child;
+      nodes_[parent].first_child = i;
+      ++nodes_[parent].children;
+      ++transitions_;
+    }
+
+    // Walk down from each root. Maps on a cycle of corrupt back pointers are
+    // never reached, and so belong to no tree.
+    std::vector<uint32_t> stack;
+    for (uint32_t i = 0; i < nodes_.size(); ++i) {
+      if (nodes_[i].parent != kNoMap) continue;
+      TransitionTree tree;
+      tree.root = i;
+      stack.push_back(i);
+      while (!stack.empty()) {
+        MapNode& node = nodes_[stack.back()];
+        stack.pop_back();
+        ++tree.maps;
+        tree.depth = std::max(tree.depth, node.depth);
+        tree.width = std::max(tree.width, node.children);
+        for (uint32_t child = node.first_child; child != kNoMap;
+             child = nodes_[child].next_sibling) {
+          nodes_[child].depth = node.depth + 1;
+          stack.push_back(child);
+        }
+      }
+      trees_.push_back(tree);
+    }
+  }
+
+  size_t maps() const { return nodes_.size(); }
+  uint64_t transitions() const { return transitions_; }
+  uint64_t deprecated() const { return deprecated_; }
+  const std::vector<TransitionTree>& trees() const { return trees_; }
+  const MapNode& node(uint32_t index) const { return nodes_[index]; }
+
+  uint64_t leaves() const {
+    return std::count_if(nodes_.begin(), nodes_.end(),
+                         [](const MapNode& node) { return node.children == 0; });
+  }
+
+  // The count trees that are greatest by key, greatest first.
+  template <typename Key>
+  std::vector<TransitionTree> GetTopTrees(size_t count, Key key) const {
+    std::vector<TransitionTree> trees = trees_;
+    count = std::min(count, trees.size());
+    std::partial_sort(trees.begin(), trees.begin() + count, trees.end(),
+                      [&key](const TransitionTree& a, const TransitionTree& b) {
+                        return key(a) > key(b);
+                      });
+    trees.resize(count);
+    return trees;
+  }
+
+  // The count maps matching filter with the most instances, most first.
+  template <typename Filter>
+  std::vector<uint32_t> GetTopMaps(size_t count, Filter filter) const {
+    std::vector<uint32_t> maps;
+    for (uint32_t i = 0; i < nodes_.size(); ++i) {
+      if (filter(nodes_[i])) maps.push_back(i);
+    }
+    count = std::min(count, maps.size());
+    std::partial_sort(maps.begin(), maps.begin() + count, maps.end(),
+                      [this](uint32_t a, uint32_t b) {
+                        return nodes_[a].instances > nodes_[b].instances;
+                      });
+    maps.resize(count);
+    return maps;
+  }
+
+ private:
+  uint32_t Find(uint64_t address) const {
+    auto it = std::lower_bound(
+        nodes_.begin(), nodes_.end(), address,
+        [](const MapNode& node, uint64_t address) { return node.address < address; });
+    if (it == nodes_.end() || it->address != address) return kNoMap;
+    return static_cast<uint32_t>(it - nodes_.begin());
+  }
+
+  bool IsMap(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    uint16_t instance_type = object.map->instance_type;
+    auto it = is_map_type_.find(instance_type);
+    if (it != is_map_type_.end()) return it->second;
+    const ObjectLayout* layout = cache_.GetLayout(walker.reader(), object.tagged_ptr);
+    bool is_map = layout != nullptr && layout->type_name == "v8::internal::Map";
+    if (is_map) {
+      // The field was renamed when native contexts moved into it.
+      back_pointer_field_ =
+          layout->FindField("constructor_or_back_pointer_or_native_context");
+      if (back_pointer_field_ == nullptr) {
+        back_pointer_field_ = layout->FindField("constructor_or_back_pointer");
+      }
+      bit_field3_ = layout->FindField("bit_field3");
+      is_deprecated_bit_ =
+          bit_field3_ != nullptr ? bit_field3_->FindBitField("is_deprecated") : nullptr;
+    }
+    is_map_type_.emplace(instance_type, is_map);
+    return is_map;
+  }
+
+  void VisitMap(HeapObjectWalker& walker, const HeapObjectInfo& object) {
+    if (back_pointer_field_ == nullptr) return;
+    MapNode node;
+    node.address = object.tagged_ptr;
+    if (!cache_.ReadTagged(walker.reader(),
+                           (object.tagged_ptr & ~kHeapObjectTagMask) +
+                               back_pointer_field_->offset,
+                           &node.back_pointer)) {
+      return;
+    }
+    uint64_t deprecated;
+    if (is_deprecated_bit_ != nullptr &&
+        cache_.ReadBitField(walker.reader(), object.tagged_ptr, *bit_field3_,
+                            *is_deprecated_bit_, &deprecated)) {
+      node.deprecated = deprecated != 0;
+    }
+    nodes_.push_back(node);
+  }
+
+  MemReader reader_;
+  LayoutCache cache_;
+  std::unordered_map<uint16_t, bool> is_map_type_;
+  const FieldLayout* back_pointer_field_ = nullptr;
+  const FieldLayout* bit_field3_ = nullptr;
+  const BitFieldLayout* is_deprecated_bit_ = nullptr;
+  std::unordered_map<uint64_t, uint32_t> instances_;  // By map address.
+  std::vector<MapNode> nodes_;  // Sorted by address once built.
+  std::vector<TransitionTree> trees_;
+  uint64_t transitions_ = 0;
+  uint64_t deprecated_ = 0;
+};
+
+HRESULT CreateTreeList(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                       const TransitionForest& forest,
+                       const std::vector<TransitionTree>& trees,
+                       IModelObject** pp_list) {
+  ModelObjectVector entries;
+  for (const TransitionTree& tree : trees) {
+    winrt::com_ptr<IModelObject> sp_entry, sp_root;
+    HRESULT hr =
+        sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_entry.put());
+    if (FAILED(hr)) return hr;
+    hr = CreateV8HeapObjectModel(sp_ctx, forest.node(tree.root).address,
+                                 sp_root.put());
+    if (FAILED(hr)) return hr;
+    hr = sp_entry->SetKey(L"root", sp_root.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"maps", tree.maps);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"depth", tree.depth);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"width", tree.width);
+    if (FAILED(hr)) return hr;
+    entries.push_back(std::move(sp_entry));
+  }
+  return CreateModelObjectList(sp_ctx, std::move(entries), pp_list);
+}
+
+HRESULT CreateMapList(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                      const TransitionForest& forest,
+                      const std::vector<uint32_t>& maps, IModelObject** pp_list) {
+  ModelObjectVector entries;
+  for (uint32_t index : maps) {
+    const MapNode& node = forest.node(index);
+    winrt::com_ptr<IModelObject> sp_entry, sp_map;
+    HRESULT hr =
+        sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_entry.put());
+    if (FAILED(hr)) return hr;
+    hr = CreateV8HeapObjectModel(sp_ctx, node.address, sp_map.put());
+    if (FAILED(hr)) return hr;
+    hr = sp_entry->SetKey(L"map", sp_map.get(), nullptr);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"instances", node.instances);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"depth", node.depth);
+    if (FAILED(hr)) return hr;
+    entries.push_back(std::move(sp_entry));
+  }
+  return CreateModelObjectList(sp_ctx, std::move(entries), pp_list);
+}
+
+}  // namespace
+
+HRESULT __stdcall MapTransitionsAlias::Call(IModelObject* p_context_object,
+                                            ULONG64 arg_count,
+                                            _In_reads_(arg_count)
+                                                IModelObject** pp_arguments,
+                                            IModelObject** pp_result,
+                                            IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count > 1) return E_INVALIDARG;
+  uint64_t count = kDefaultCount;
+  if (arg_count == 1) {
+    VARIANT vt_count;
+    HRESULT hr = pp_arguments[0]->GetIntrinsicValueAs(VT_UI8, &vt_count);
+    if (FAILED(hr)) return hr;
+    count = vt_count.ullVal;
+  }
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  std::vector<ChunkData> chunks;
+  hr = GetMemoryChunks(chunks);
+  if (FAILED(hr)) return hr;
+
+  ScopedTrace trace("MapTransitions");
+  TransitionForest forest(GetMemReader(sp_ctx));
+  for (const ChunkData& chunk : chunks) forest.VisitChunk(chunk);
+  forest.Build();
+
+  winrt::com_ptr<IModelObject> sp_result;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"maps", forest.maps());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"trees", forest.trees().size());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"transitions", forest.transitions());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"leaves", forest.leaves());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"deprecated", forest.deprecated());
+  if (FAILED(hr)) return hr;
+
+  size_t top = static_cast<size_t>(count);
+  winrt::com_ptr<IModelObject> sp_deepest, sp_widest, sp_leaves, sp_deprecated;
+  hr = CreateTreeList(
+      sp_ctx, forest,
+      forest.GetTopTrees(top, [](const TransitionTree& tree) { return tree.depth; }),
+      sp_deepest.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"deepest_trees", sp_deepest.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateTreeList(
+      sp_ctx, forest,
+      forest.GetTopTrees(top, [](const TransitionTree& tree) { return tree.width; }),
+      sp_widest.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"widest_trees", sp_widest.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateMapList(
+      sp_ctx, forest,
+      forest.GetTopMaps(top, [](const MapNode& node) { return node.children == 0; }),
+      sp_leaves.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"leaf_maps", sp_leaves.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateMapList(
+      sp_ctx, forest,
+      forest.GetTopMaps(top, [](const MapNode& node) {
+        return node.deprecated && node.instances != 0;
+      }),
+      sp_deprecated.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"deprecated_maps", sp_deprecated.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <crtdbg.h>
+#include "../utilities.h"
+#include "extension.h"
+#include "list-chunks.h"
+#include "v8.h"
+
+// @$maptransitions([count]) - builds the map transition forest from the back
+// pointers of every Map on the heap, and lists the count (default 20) deepest
+// and widest trees, the leaf maps with the most instances, and the deprecated
+// maps that still have instances.
+struct MapTransitionsAlias : winrt::implements<MapTransitionsAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Reads size bytes of target memory at address into buffer. Returns false
+// unless all of them could be read.
+using MemReader =
+  std::function<bool(uint64_t address, size_t size, uint8_t* buffer)>;
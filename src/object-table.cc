@@ -0,0 +1,330 @@
+#include "object-table.h"
+#include "trace.h"
+#include <cstring>
+
+namespace {
+
+constexpr char kMagic[8] = {'V', '8', 'O', 'B', 'J', 'T', 'B', '1'};
+constexpr size_t kTrailerSize = sizeof(uint64_t) + sizeof(kMagic);
+
+void PutVarint(std::string* out, uint64_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void PutString(std::string* out, std::string_view value) {
+  PutVarint(out, value.size());
+  out->append(value);
+}
+
+uint64_t ZigZag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Reads from a byte range, failing rather than reading past its end.
+class Decoder {
+ public:
+  Decoder(const uint8_t* data, size_t size) : next_(data), end_(data + size) {}
+
+  bool GetVarint(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (next_ == end_) return false;
+      uint8_t byte = *next_++;
+      *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+  }
+
+  bool GetString(std::string* value) {
+    uint64_t size;
+    if (!GetVarint(&size) || size > static_cast<uint64_t>(end_ - next_)) return false;
+    value->assign(reinterpret_cast<const char*>(next_), static_cast<size_t>(size));
+    next_ += size;
+    return true;
+  }
+
+  // Splits off the next size bytes, for a column prefixed with its length.
+  bool GetColumn(Decoder* column) {
+    uint64_t size;
+    if (!GetVarint(&size) || size > static_cast<uint64_t>(end_ - next_)) return false;
+    *column = Decoder(next_, static_cast<size_t>(size));
+    next_ += size;
+    return true;
+  }
+
+ private:
+  const uint8_t* next_;
+  const uint8_t* end_;
+};
+
+// Offsets can be past 4GB, which long can't hold on Windows.
+bool Seek(FILE* file, uint64_t offset, int origin) {
+#ifdef _WIN32
+  return _fseeki64(file, static_cast<int64_t>(offset), origin) == 0;
+#else
+  return fseeko(file, static_cast<off_t>(offset), origin) == 0;
+#endif
+}
+
+bool Tell(FILE* file, uint64_t* offset) {
+#ifdef _WIN32
+  int64_t position = _ftelli64(file);
+#else
+  int64_t position = ftello(file);
+#endif
+  if (position < 0) return false;
+  *offset = static_cast<uint64_t>(position);
+  return true;
+}
+
+bool ReadAt(FILE* file, uint64_t offset, size_t size, std::vector<uint8_t>* buffer) {
+  buffer->resize(size);
+  return Seek(file, offset, SEEK_SET) &&
+         fread(buffer->data(), 1, size, file) == size;
+}
+
+}  // namespace
+
+ObjectTableWriter::ObjectTableWriter(FILE* file) : file_(file) {
+  Write(std::string(kMagic, sizeof(kMagic)));
+}
+
+uint32_t ObjectTableWriter::BeginChunk(uint64_t start, std::string_view space) {
+  uint32_t space_id = 0;
+  while (space_id < spaces_.size() && spaces_[space_id] != space) ++space_id;
+  if (space_id == spaces_.size()) spaces_.emplace_back(space);
+  chunks_.push_back({start, space_id});
+  return static_cast<uint32_t>(chunks_.size() - 1);
+}
+
+void ObjectTableWriter::SetTypeName(uint16_t instance_type, std::string_view name) {
+  type_names_[instance_type] = name;
+}
+
+void ObjectTableWriter::Add(uint64_t address, uint64_t map,
+                            uint16_t instance_type, uint64_t size) {
+  auto it = map_ids_.find(map);
+  if (it == map_ids_.end()) {
+    it = map_ids_.emplace(map, static_cast<uint32_t>(maps_.size())).first;
+    maps_.push_back({map, instance_type});
+  }
+  block_.addresses.push_back(address);
+  block_.sizes.push_back(size);
+  block_.maps.push_back(it->second);
+  block_.chunks.push_back(chunks_.empty() ? 0 : static_cast<uint32_t>(chunks_.size() - 1));
+  ++row_count_;
+  if (block_.addresses.size() == kObjectTableBlockRows) FlushBlock();
+}
+
+void ObjectTableWriter::FlushBlock() {
+  size_t rows = block_.addresses.size();
+  if (rows == 0) return;
+  ScopedTrace trace("WriteObjectTableBlock");
+  std::string column, out;
+  PutVarint(&out, rows);
+
+  uint64_t previous = 0;
+  for (uint64_t address : block_.addresses) {
+    PutVarint(&column, ZigZag(static_cast<int64_t>(address - previous)));
+    previous = address;
+  }
+  PutString(&out, column);
+  column.clear();
+  for (uint64_t size : block_.sizes) PutVarint(&column, size);
+  PutString(&out, column);
+  column.clear();
+  for (uint32_t map : block_.maps) PutVarint(&column, map);
+  PutString(&out, column);
+  column.clear();
+  for (size_t i = 0; i < rows;) {
+    size_t run = 1;
+    while (i + run < rows && block_.chunks[i + run] == block_.chunks[i]) ++run;
+    PutVarint(&column, block_.chunks[i]);
+    PutVarint(&column, run);
+    i += run;
+  }
+  PutString(&out, column);
+
+  blocks_.push_back({offset_, rows});
+  Write(out);
+  block_ = Block();
+}
+
+void ObjectTableWriter::Write(const std::string& bytes) {
+  if (failed_) return;
+  if (fwrite(bytes.data(), 1, bytes.size(), file_) != bytes.size()) failed_ = true;
+  offset_ += bytes.size();
+}
+
+bool ObjectTableWriter::Finish() {
+  FlushBlock();
+  uint64_t footer_offset = offset_;
+  std::string footer;
+  PutVarint(&footer, maps_.size());
+  uint64_t previous = 0;
+  for (const ObjectTableMap& map : maps_) {
+    PutVarint(&footer, ZigZag(static_cast<int64_t>(map.address - previous)));
+    PutVarint(&footer, map.instance_type);
+    previous = map.address;
+  }
+  PutVarint(&footer, type_names_.size());
+  for (const auto& [instance_type, name] : type_names_) {
+    PutVarint(&footer, instance_type);
+    PutString(&footer, name);
+  }
+  PutVarint(&footer, spaces_.size());
+  for (const std::string& space : spaces_) PutString(&footer, space);
+  PutVarint(&footer, chunks_.size());
+  for (const ObjectTableChunk& chunk : chunks_) {
+    PutVarint(&footer, chunk.start);
+    PutVarint(&footer, chunk.space);
+  }
+  PutVarint(&footer, blocks_.size());
+  for (const BlockEntry& block : blocks_) {
+    PutVarint(&footer, block.offset);
+    PutVarint(&footer, block.rows);
+  }
+  for (int i = 0; i < 8; ++i) {
+    footer.push_back(static_cast<char>(footer_offset >> (i * 8)));
+  }
+  footer.append(kMagic, sizeof(kMagic));
+  Write(footer);
+  if (fflush(file_) != 0) failed_ = true;
+  return !failed_;
+}
+
+bool ObjectTableReader::Open() {
+  ScopedTrace trace("OpenObjectTable");
+  uint64_t file_size;
+  if (!Seek(file_, 0, SEEK_END) || !Tell(file_, &file_size) ||
+      file_size < sizeof(kMagic) + kTrailerSize) {
+    return false;
+  }
+  if (!ReadAt(file_, 0, sizeof(kMagic), &buffer_) ||
+      memcmp(buffer_.data(), kMagic, sizeof(kMagic)) != 0) {
+    return false;
+  }
+  uint64_t trailer_offset = file_size - kTrailerSize;
+  if (!ReadAt(file_, trailer_offset, kTrailerSize, &buffer_) ||
+      memcmp(buffer_.data() + sizeof(uint64_t), kMagic, sizeof(kMagic)) != 0) {
+    return false;
+  }
+  uint64_t footer_offset = 0;
+  for (int i = 0; i < 8; ++i) {
+    footer_offset |= static_cast<uint64_t>(buffer_[i]) << (i * 8);
+  }
+  if (footer_offset < sizeof(kMagic) || footer_offset > trailer_offset ||
+      !ReadAt(file_, footer_offset, static_cast<size_t>(trailer_offset - footer_offset),
+              &buffer_)) {
+    return false;
+  }
+
+  Decoder footer(buffer_.data(), buffer_.size());
+  uint64_t count, previous = 0;
+  if (!footer.GetVarint(&count)) return false;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t delta, instance_type;
+    if (!footer.GetVarint(&delta) || !footer.GetVarint(&instance_type)) return false;
+    previous += static_cast<uint64_t>(UnZigZag(delta));
+    maps_.push_back({previous, static_cast<uint16_t>(instance_type)});
+  }
+  if (!footer.GetVarint(&count)) return false;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t instance_type;
+    std::string name;
+    if (!footer.GetVarint(&instance_type) || !footer.GetString(&name)) return false;
+    type_names_[static_cast<uint16_t>(instance_type)] = std::move(name);
+  }
+  if (!footer.GetVarint(&count)) return false;
+  for (uint64_t i = 0; i < count; ++i) {
+    std::string space;
+    if (!footer.GetString(&space)) return false;
+    spaces_.push_back(std::move(space));
+  }
+  if (!footer.GetVarint(&count)) return false;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t start, space;
+    if (!footer.GetVarint(&start) || !footer.GetVarint(&space) ||
+        space >= spaces_.size()) {
+      return false;
+    }
+    chunks_.push_back({start, static_cast<uint32_t>(space)});
+  }
+  if (!footer.GetVarint(&count)) return false;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t offset, rows;
+    if (!footer.GetVarint(&offset) || !footer.GetVarint(&rows)) return false;
+    blocks_.push_back({offset, 0, rows});
+    row_count_ += rows;
+  }
+  // Each block ends where the next one, or the footer, starts. Every row
+  // takes at least a byte, so a larger row count is a corrupt file rather
+  // than something to allocate for.
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    uint64_t end = i + 1 < blocks_.size() ? blocks_[i + 1].offset : footer_offset;
+    if (blocks_[i].offset < sizeof(kMagic) || end < blocks_[i].offset) return false;
+    blocks_[i].size = end - blocks_[i].offset;
+    if (blocks_[i].rows > blocks_[i].size) return false;
+  }
+  return true;
+}
+
+std::string_view ObjectTableReader::GetTypeName(uint16_t instance_type) const {
+  auto it = type_names_.find(instance_type);
+  return it == type_names_.end() ? std::string_view() : it->second;
+}
+
+std::string ObjectTableReader::GetTypeLabel(uint16_t instance_type) const {
+  std::string_view name = GetTypeName(instance_type);
+  return name.empty() ? "instance type " + std::to_string(instance_type)
+                      : std::string(name);
+}
+
+bool ObjectTableReader::ReadBlock(size_t index, std::vector<ObjectRow>* rows) {
+  ScopedTrace trace("ReadObjectTableBlock");
+  rows->clear();
+  if (index >= blocks_.size()) return false;
+  const BlockEntry& entry = blocks_[index];
+  if (!ReadAt(file_, entry.offset, static_cast<size_t>(entry.size), &buffer_)) {
+    return false;
+  }
+  Decoder block(buffer_.data(), buffer_.size());
+  Decoder addresses(nullptr, 0), sizes(nullptr, 0), maps(nullptr, 0),
+      chunks(nullptr, 0);
+  uint64_t count;
+  if (!block.GetVarint(&count) || count != entry.rows ||
+      !block.GetColumn(&addresses) || !block.GetColumn(&sizes) ||
+      !block.GetColumn(&maps) || !block.GetColumn(&chunks)) {
+    return false;
+  }
+
+  rows->resize(static_cast<size_t>(count));
+  uint64_t address = 0, chunk = 0, run = 0;
+  for (ObjectRow& row : *rows) {
+    uint64_t delta, size, map;
+    if (!addresses.GetVarint(&delta) || !sizes.GetVarint(&size) ||
+        !maps.GetVarint(&map) || map >= maps_.size()) {
+      rows->clear();
+      return false;
+    }
+    if (run == 0 && (!chunks.GetVarint(&chunk) || !chunks.GetVarint(&run) ||
+                     run == 0 || chunk >= chunks_.size())) {
+      rows->clear();
+      return false;
+    }
+    --run;
+    address += static_cast<uint64_t>(UnZigZag(delta));
+    row = {address, maps_[map].address, maps_[map].instance_type, size,
+           static_cast<uint32_t>(chunk)};
+  }
+  return true;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A file listing every heap object, laid out by column so that it can be
+// loaded into analysis tools without the debugger. Rows are written in blocks
+// of kObjectTableBlockRows, and each column of a block is encoded on its own:
+//
+//   address   first address, then zigzag deltas from the previous row
+//   size      varint
+//   map       varint index into the map dictionary, which also holds each
+//             map's instance type
+//   chunk     (chunk index, run length) pairs
+//
+// The dictionaries of maps, type names, spaces and chunks and the index of
+// blocks are written at the end, so the writer holds only one block of rows
+// and the dictionaries, however many objects there are. All integers are
+// little endian or LEB128 varints.
+constexpr size_t kObjectTableBlockRows = 64 * 1024;
+
+struct ObjectRow {
+  uint64_t address;  // Untagged.
+  uint64_t map;
+  uint16_t instance_type;
+  uint64_t size;
+  uint32_t chunk;
+};
+
+struct ObjectTableMap {
+  uint64_t address;
+  uint16_t instance_type;
+};
+
+struct ObjectTableChunk {
+  uint64_t start;
+  uint32_t space;  // Index into the space names.
+};
+
+class ObjectTableWriter {
+ public:
+  // The file must be empty and opened for binary writing. It isn't closed.
+  explicit ObjectTableWriter(FILE* file);
+
+  // Starts the rows of a new chunk, returning its index.
+  uint32_t BeginChunk(uint64_t start, std::string_view space);
+
+  // Names an instance type, such as "v8::internal::JSObject".
+  void SetTypeName(uint16_t instance_type, std::string_view name);
+
+  // Adds an object in the current chunk.
+  void Add(uint64_t address, uint64_t map, uint16_t instance_type, uint64_t size);
+
+  // Writes the last block and the dictionaries. Returns false if any write
+  // failed along the way.
+  bool Finish();
+
+  uint64_t row_count() const { return row_count_; }
+
+ private:
+  struct Block {
+    std::vector<uint64_t> addresses;
+    std::vector<uint64_t> sizes;
+    std::vector<uint32_t> maps;
+    std::vector<uint32_t> chunks;
+  };
+  struct BlockEntry {
+    uint64_t offset;
+    uint64_t rows;
+  };
+
+  void FlushBlock();
+  void Write(const std::string& bytes);
+
+  FILE* file_;
+  bool failed_ = false;
+  uint64_t offset_ = 0;
+  uint64_t row_count_ = 0;
+  Block block_;
+  std::vector<ObjectTableMap> maps_;
+  std::unordered_map<uint64_t, uint32_t> map_ids_;
+  std::unordered_map<uint16_t, std::string> type_names_;
+  std::vector<std::string> spaces_;
+  std::vector<ObjectTableChunk> chunks_;
+  std::vector<BlockEntry> blocks_;
+};
+
+class ObjectTableReader {
+ public:
+  explicit ObjectTableReader(FILE* file) : file_(file) {}
+
+  // Reads the dictionaries and block index. Returns false if the file isn't
+  // a complete object table.
+  bool Open();
+
+  size_t block_count() const { return blocks_.size(); }
+  uint64_t row_count() const { return row_count_; }
+  const std::vector<std::string>& spaces() const { return spaces_; }
+  const std::vector<ObjectTableChunk>& chunks() const { return chunks_; }
+  const std::vector<ObjectTableMap>& maps() const { return maps_; }
+
+  // The name of instance_type, or "" if the writer didn't name it.
+  std::string_view GetTypeName(uint16_t instance_type) const;
+
+  // The name of instance_type, or "instance type <n>" if it has none.
+  std::string GetTypeLabel(uint16_t instance_type) const;
+
+  // Decodes the rows of one block, so that a file is read one block at a time.
+  bool ReadBlock(size_t index, std::vector<ObjectRow>* rows);
+
+ private:
+  struct BlockEntry {
+    uint64_t offset;
+    uint64_t size;  // In bytes.
+    uint64_t rows;
+  };
+
+  FILE* file_;
+  uint64_t row_count_ = 0;
+  std::vector<ObjectTableMap> maps_;
+  std::unordered_map<uint16_t, std::string> type_names_;
+  std::vector<std::string> spaces_;
+  std::vector<ObjectTableChunk> chunks_;
+  std::vector<BlockEntry> blocks_;
+  std::vector<uint8_t> buffer_;
+};
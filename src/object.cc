@@ -2,6 +2,76 @@
 #include "object.h"
 #include "extension.h"
 #include "v8.h"
+#include "stats.h"
+
+MemReader GetMemReader(winrt::com_ptr<IDebugHostContext> sp_context) {
+  return [sp_context](uint64_t address, size_t size, uint8_t* p_buffer) {
+    ScopedLatency latency(Timer::kMemoryRead);
+    IncrementCounter(Counter::kMemoryReads);
+    IncrementCounter(Counter::kBytesRead, size);
+    ULONG64 bytes_read;
+    Location loc{address};
+    HRESULT hr = Extension::current_extension_->sp_debug_host_memory_->ReadBytes(
+        sp_context.get(), loc, p_buffer, size, &bytes_read);
+    return SUCCEEDED(hr) && bytes_read == size;
+  };
+}
+
+HRESULT CreateV8HeapObjectModel(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                                uint64_t tagged_ptr, IModelObject** pp_result) {
+  auto& sp_object_data_model = Extension::current_extension_->sp_object_data_model_;
+  winrt::com_ptr<IModelObject> sp_result, sp_address;
+  HRESULT hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(),
+                                                            sp_result.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->AddParentModel(sp_object_data_model.get(), nullptr,
+                                 /*override=*/false);
+  if (FAILED(hr)) return hr;
+
+  // Supply the decoded object up front, as V8ObjectDataModel would otherwise
+  // read the pointer from the object's location.
+  winrt::com_ptr<IV8CachedObject> sp_cached_object =
+      winrt::make<V8CachedObject>(sp_ctx, tagged_ptr);
+  hr = sp_result->SetContextForDataModel(sp_object_data_model.get(),
+                                         sp_cached_object.get());
+  if (FAILED(hr)) return hr;
+
+  hr = CreateULong64(tagged_ptr, sp_address.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"address", sp_address.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
+
+HRESULT __stdcall V8StringContentsMethod::Call(IModelObject* p_context_object,
+                                               ULONG64 arg_count,
+                                               IModelObject** pp_arguments,
+                                               IModelObject** pp_result,
+                                               IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count > 1) return E_INVALIDARG;
+  size_t max_length = SIZE_MAX;
+  if (arg_count == 1) {
+    VARIANT vt_max_length;
+    HRESULT hr = pp_arguments[0]->GetIntrinsicValueAs(VT_UI8, &vt_max_length);
+    if (FAILED(hr)) return hr;
+    max_length = static_cast<size_t>(vt_max_length.ullVal);
+  }
+
+  // Appending chunk by chunk keeps this linear even for huge cons trees.
+  std::u16string contents;
+  LayoutCache layout_cache;
+  StringReadResult result = ReadV8String(
+      GetMemReader(sp_ctx_), layout_cache, tagged_ptr_, max_length,
+      [&contents](const char16_t* data, size_t length) {
+        contents.append(data, length);
+        return true;
+      });
+  if (result == StringReadResult::kFailed) return E_FAIL;
+  return CreateString(std::move(contents), pp_result);
+}
 
 HRESULT V8LocalValueProperty::GetValue(PCWSTR pwsz_key,
                                        IModelObject* p_v8_local_instance,
@@ -7,14 +7,21 @@
 #include <string>
 #include <comutil.h>
 
+// Reads target memory through the debug host for the given context.
+MemReader GetMemReader(winrt::com_ptr<IDebugHostContext> sp_context);
+
 // The representation of the underlying V8 object that will be cached on the
 // DataModel representation. (Needs to implement IUnknown).
 struct __declspec(uuid("6392E072-37BB-4220-A5FF-114098923A02")) IV8CachedObject: IUnknown {
   virtual HRESULT __stdcall GetCachedV8HeapObject(V8HeapObject** pp_heap_object) = 0;
 };
 
+// Decoded data is allocated from the arena for the current stop, which this
+// keeps alive for as long as the debugger holds on to the object.
 struct V8CachedObject: winrt::implements<V8CachedObject, IV8CachedObject> {
-  V8CachedObject(IModelObject* p_v8_object_instance) {
+  V8CachedObject(IModelObject* p_v8_object_instance)
+      : arena(Extension::current_extension_->GetDecodeArena()),
+        heap_object(arena.get()) {
     Location loc;
     HRESULT hr = p_v8_object_instance->GetLocation(&loc);
     if(FAILED(hr)) return; // TODO error handling
@@ -23,13 +30,6 @@ struct V8CachedObject: winrt::implements<V8CachedObject, IV8CachedObject> {
     hr = p_v8_object_instance->GetContext(sp_context.put());
     if (FAILED(hr)) return;
 
-    auto mem_reader = [&sp_context](uint64_t address, size_t size, uint8_t *p_buffer) {
-      ULONG64 bytes_read;
-      Location loc{address};
-      HRESULT hr = Extension::current_extension_->sp_debug_host_memory_->ReadBytes(sp_context.get(), loc, p_buffer, size, &bytes_read);
-      return SUCCEEDED(hr);
-    };
-
     winrt::com_ptr<IDebugHostType> sp_type;
     _bstr_t type_name;
     bool compressed_pointer = SUCCEEDED(p_v8_object_instance->GetTypeInfo(sp_type.put()))
@@ -39,9 +39,16 @@ struct V8CachedObject: winrt::implements<V8CachedObject, IV8CachedObject> {
     uint64_t tagged_ptr;
     Extension::current_extension_->sp_debug_host_memory_->ReadPointers(sp_context.get(), loc, 1, &tagged_ptr);
     if (compressed_pointer) tagged_ptr = static_cast<uint32_t>(tagged_ptr);
-    heap_object = ::GetHeapObject(mem_reader, tagged_ptr, loc.GetOffset());
+    heap_object = ::GetHeapObject(GetMemReader(sp_context), tagged_ptr,
+                                  loc.GetOffset(), arena.get());
   }
 
+  V8CachedObject(winrt::com_ptr<IDebugHostContext>& sp_context, uint64_t tagged_ptr)
+      : arena(Extension::current_extension_->GetDecodeArena()),
+        heap_object(::GetHeapObject(GetMemReader(sp_context), tagged_ptr,
+                                    tagged_ptr, arena.get())) {}
+
+  ArenaPtr arena;  // Must be declared before heap_object, which it holds.
   V8HeapObject heap_object;
 
   HRESULT __stdcall GetCachedV8HeapObject(V8HeapObject** pp_heap_object) noexcept override {
@@ -50,6 +57,27 @@ struct V8CachedObject: winrt::implements<V8CachedObject, IV8CachedObject> {
   }
 };
 
+// Creates a model object for the heap object at tagged_ptr, for results (such
+// as from a heap search) that weren't read from a typed field. It also has an
+// "address" key, as there is no location to show.
+HRESULT CreateV8HeapObjectModel(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                                uint64_t tagged_ptr, IModelObject** pp_result);
+
+// The 'contents' method on V8 strings: flattens the whole string, or the first
+// max_length code units if an argument is given.
+struct V8StringContentsMethod : winrt::implements<V8StringContentsMethod, IModelMethod> {
+  V8StringContentsMethod(winrt::com_ptr<IDebugHostContext>& sp_ctx, uint64_t tagged_ptr)
+      : sp_ctx_(sp_ctx), tagged_ptr_(tagged_ptr) {}
+
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx_;
+  uint64_t tagged_ptr_;
+};
+
 struct V8ObjectKeyEnumerator: winrt::implements<V8ObjectKeyEnumerator, IKeyEnumerator>
 {
   V8ObjectKeyEnumerator(winrt::com_ptr<IV8CachedObject> &v8_cached_object)
@@ -174,6 +202,17 @@ struct V8ObjectDataModel: winrt::implements<V8ObjectDataModel, IDataModelConcept
         const char16_t *p_key = reinterpret_cast<const char16_t*>(key);
         if (k.name.compare(p_key) == 0) {
           *has_key = true;
+          if (key_value != nullptr && k.type == PropertyType::kStringContents) {
+            hr = context_object->GetContext(sp_ctx.put());
+            if (FAILED(hr)) return hr;
+            auto contents_method{winrt::make<V8StringContentsMethod>(
+                sp_ctx, p_v8_heap_object->tagged_ptr)};
+            VARIANT vt_method;
+            vt_method.vt = VT_UNKNOWN;
+            vt_method.punkVal = static_cast<IModelMethod*>(contents_method.get());
+            return sp_data_model_manager->CreateIntrinsicObject(
+                ObjectMethod, &vt_method, key_value);
+          }
           if(key_value != nullptr) {
             winrt::com_ptr<IModelObject> sp_value;
             // TODO: if this property was a compressed pointer, then can we
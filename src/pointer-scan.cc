@@ -0,0 +1,188 @@
+#include "pointer-scan.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "trace.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define V8DBG_USE_SSE2 1
+#endif
+
+namespace {
+
+// Bytes read from the target per block handed to a worker.
+constexpr size_t kScanBlockSize = 1024 * 1024;
+
+// A block that can't be read whole is read again in pieces of this size, so
+// one unreadable page doesn't hide the rest of the block.
+constexpr size_t kPageSize = 4096;
+
+// Checks the 4 byte aligned value at offset, which has already been found to
+// equal the lower half of the target.
+inline void CheckCandidate(const uint8_t* data, size_t size, uint64_t base,
+                           size_t offset, const PointerTarget& target,
+                           std::vector<PointerSlot>* slots) {
+  uint64_t address = base + offset;
+  uint32_t upper;
+  if (address % 8 == 0 && offset + 8 <= size) {
+    memcpy(&upper, data + offset + 4, sizeof(upper));
+    if (upper == static_cast<uint32_t>(target.tagged_ptr >> 32)) {
+      slots->push_back({address, false});
+      return;
+    }
+  }
+  if (target.compressed) slots->push_back({address, true});
+}
+
+// Checks each 4 byte aligned value in [begin, end) one at a time.
+void FindSlotsScalar(const uint8_t* data, size_t size, uint64_t base,
+                     size_t begin, size_t end, const PointerTarget& target,
+                     std::vector<PointerSlot>* slots) {
+  uint32_t lower = static_cast<uint32_t>(target.tagged_ptr);
+  for (size_t offset = begin; offset + 4 <= end; offset += 4) {
+    uint32_t value;
+    memcpy(&value, data + offset, sizeof(value));
+    if (value != lower) continue;
+    // An uncompressed match covers the next value too.
+    size_t before = slots->size();
+    CheckCandidate(data, size, base, offset, target, slots);
+    if (slots->size() > before && !slots->back().compressed) offset += 4;
+  }
+}
+
+}  // namespace
+
+void FindPointerSlots(const uint8_t* data, size_t size, uint64_t base,
+                      const PointerTarget& target, std::vector<PointerSlot>* slots) {
+  // Slots are aligned in the target's address space, not in data.
+  size_t offset = static_cast<size_t>((4 - base % 4) % 4);
+  size_t start = offset;
+
+#if defined(V8DBG_USE_SSE2)
+  // Find candidates 64 bytes at a time. Blocks start 8 byte aligned so that a
+  // full pointer is the two halves of one 64-bit lane.
+  size_t aligned = static_cast<size_t>((8 - base % 8) % 8);
+  FindSlotsScalar(data, size, base, start, std::min(aligned, size), target, slots);
+  const __m128i lower = _mm_set1_epi32(static_cast<int>(target.tagged_ptr));
+  for (offset = aligned; offset + 64 <= size; offset += 64) {
+    const __m128i* block = reinterpret_cast<const __m128i*>(data + offset);
+    __m128i eq0 = _mm_cmpeq_epi32(_mm_loadu_si128(block), lower);
+    __m128i eq1 = _mm_cmpeq_epi32(_mm_loadu_si128(block + 1), lower);
+    __m128i eq2 = _mm_cmpeq_epi32(_mm_loadu_si128(block + 2), lower);
+    __m128i eq3 = _mm_cmpeq_epi32(_mm_loadu_si128(block + 3), lower);
+    __m128i any = _mm_or_si128(_mm_or_si128(eq0, eq1), _mm_or_si128(eq2, eq3));
+    if (_mm_movemask_epi8(any) == 0) continue;
+    FindSlotsScalar(data, size, base, offset, offset + 64, target, slots);
+  }
+  start = std::max(offset, aligned);
+#endif
+
+  FindSlotsScalar(data, size, base, start, size, target, slots);
+}
+
+std::vector<PointerSlot> ScanForPointer(const std::vector<MemoryRange>& ranges,
+                                        const MemReader& reader,
+                                        const PointerTarget& target,
+                                        unsigned thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  struct Block {
+    uint64_t address;
+    std::vector<uint8_t> data;
+  };
+  std::mutex mutex;
+  std::condition_variable block_ready, buffer_free;
+  std::deque<Block> ready_blocks;
+  // Two buffers per worker let the next blocks be read while others are
+  // scanned, and bound the memory used.
+  std::vector<std::vector<uint8_t>> free_buffers(2 * thread_count);
+  bool reading_done = false;
+  std::vector<PointerSlot> results;
+
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < thread_count; ++i) {
+    workers.emplace_back([&]() {
+      std::vector<PointerSlot> slots;
+      while (true) {
+        Block block;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          block_ready.wait(lock, [&]() { return !ready_blocks.empty() || reading_done; });
+          if (ready_blocks.empty()) break;
+          block = std::move(ready_blocks.front());
+          ready_blocks.pop_front();
+        }
+        slots.clear();
+        ScopedTrace trace("ScanBlock");
+        FindPointerSlots(block.data.data(), block.data.size(), block.address,
+                         target, &slots);
+        std::lock_guard<std::mutex> lock(mutex);
+        results.insert(results.end(), slots.begin(), slots.end());
+        free_buffers.push_back(std::move(block.data));
+        buffer_free.notify_one();
+      }
+    });
+  }
+
+  for (const MemoryRange& range : ranges) {
+    for (uint64_t address = range.start; address < range.end;
+         address += kScanBlockSize) {
+      std::vector<uint8_t> buffer;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        buffer_free.wait(lock, [&]() { return !free_buffers.empty(); });
+        buffer = std::move(free_buffers.back());
+        free_buffers.pop_back();
+      }
+      buffer.resize(static_cast<size_t>(
+          std::min<uint64_t>(kScanBlockSize, range.end - address)));
+      bool read;
+      {
+        ScopedTrace trace("ReadBlock");
+        read = reader(address, buffer.size(), buffer.data());
+      }
+      if (read) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready_blocks.push_back({address, std::move(buffer)});
+        block_ready.notify_one();
+        continue;
+      }
+
+      uint64_t block_end = address + buffer.size();
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        free_buffers.push_back(std::move(buffer));
+      }
+      ScopedTrace trace("ReadPages");
+      for (uint64_t page = address; page < block_end;) {
+        uint64_t page_end = std::min<uint64_t>(block_end, (page / kPageSize + 1) * kPageSize);
+        std::vector<uint8_t> data(static_cast<size_t>(page_end - page));
+        if (reader(page, data.size(), data.data())) {
+          std::lock_guard<std::mutex> lock(mutex);
+          ready_blocks.push_back({page, std::move(data)});
+          block_ready.notify_one();
+        }
+        page = page_end;
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    reading_done = true;
+  }
+  block_ready.notify_all();
+  for (std::thread& worker : workers) worker.join();
+
+  std::sort(results.begin(), results.end(),
+            [](const PointerSlot& a, const PointerSlot& b) {
+              return a.address < b.address;
+            });
+  return results;
+}
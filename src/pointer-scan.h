@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "mem-reader.h"
+
+// What a conservative pointer scan looks for. A slot matches if it holds the
+// full tagged pointer (8 byte aligned), or, if compressed is set, the lower
+// half of it (4 byte aligned) as stored with pointer compression.
+struct PointerTarget {
+  uint64_t tagged_ptr;
+  bool compressed;
+};
+
+struct PointerSlot {
+  uint64_t address;
+  bool compressed;  // Matched as a 4-byte compressed value.
+};
+
+struct MemoryRange {
+  uint64_t start;
+  uint64_t end;
+};
+
+// Appends the slots in data, which was read from address base, that match
+// target. Compares 64 bytes per step with SSE2 where available.
+void FindPointerSlots(const uint8_t* data, size_t size, uint64_t base,
+                      const PointerTarget& target, std::vector<PointerSlot>* slots);
+
+// Scans every range for target and returns the matching slots in address
+// order. Memory is read only on the calling thread, as debugger memory APIs
+// generally aren't thread safe, while thread_count workers (0 for one per
+// core) compare the blocks already read. A block that can't be read is read
+// again a page at a time, and only the unreadable pages are skipped.
+std::vector<PointerSlot> ScanForPointer(const std::vector<MemoryRange>& ranges,
+                                        const MemReader& reader,
+                                        const PointerTarget& target,
+                                        unsigned thread_count = 0);
@@ -0,0 +1,188 @@
+#include "stats-model.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "stats.h"
+#include "trace.h"
+
+namespace {
+
+std::wstring WidenName(const char* name) {
+  return std::wstring(name, name + strlen(name));
+}
+
+// One entry per non-empty bucket: {below_ns, count}. below_ns is 0 for the
+// last bucket, which has no upper bound.
+HRESULT CreateHistogram(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                        const LatencyStats& latency, IModelObject** pp_result) {
+  ModelObjectVector buckets;
+  for (size_t i = 0; i < kLatencyBuckets; ++i) {
+    if (latency.buckets[i] == 0) continue;
+    winrt::com_ptr<IModelObject> sp_bucket;
+    HRESULT hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(),
+                                                              sp_bucket.put());
+    if (FAILED(hr)) return hr;
+    uint64_t below_ns = i + 1 < kLatencyBuckets ? uint64_t{1} << i : 0;
+    hr = SetULong64Key(sp_bucket.get(), L"below_ns", below_ns);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_bucket.get(), L"count", latency.buckets[i]);
+    if (FAILED(hr)) return hr;
+    buckets.push_back(sp_bucket);
+  }
+  return CreateModelObjectList(sp_ctx, std::move(buckets), pp_result);
+}
+
+HRESULT CreateLatency(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                      const LatencyStats& latency, IModelObject** pp_result) {
+  winrt::com_ptr<IModelObject> sp_result, sp_mean, sp_histogram;
+  HRESULT hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(),
+                                                            sp_result.put());
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"count", latency.count);
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"total_ns", latency.total_ns);
+  if (FAILED(hr)) return hr;
+  hr = CreateNumber(latency.count == 0 ? 0.0
+                        : static_cast<double>(latency.total_ns) / latency.count,
+                    sp_mean.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"mean_ns", sp_mean.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = CreateHistogram(sp_ctx, latency, sp_histogram.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"histogram", sp_histogram.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
+
+}  // namespace
+
+HRESULT __stdcall V8DbgStatsAlias::Call(IModelObject* p_context_object,
+                                        ULONG64 arg_count,
+                                        IModelObject** pp_arguments,
+                                        IModelObject** pp_result,
+                                        IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  winrt::com_ptr<IModelObject> sp_result, sp_latencies;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_latencies.put());
+  if (FAILED(hr)) return hr;
+
+  StatsSnapshot snapshot = GetStatsSnapshot();
+  for (size_t i = 0; i < kCounterCount; ++i) {
+    std::wstring name = WidenName(GetCounterName(static_cast<Counter>(i)));
+    hr = SetULong64Key(sp_result.get(), name.c_str(), snapshot.counters[i]);
+    if (FAILED(hr)) return hr;
+  }
+  for (size_t i = 0; i < kTimerCount; ++i) {
+    winrt::com_ptr<IModelObject> sp_latency;
+    hr = CreateLatency(sp_ctx, snapshot.timers[i], sp_latency.put());
+    if (FAILED(hr)) return hr;
+    std::wstring name = WidenName(GetTimerName(static_cast<Timer>(i)));
+    hr = sp_latencies->SetKey(name.c_str(), sp_latency.get(), nullptr);
+    if (FAILED(hr)) return hr;
+  }
+  hr = sp_result->SetKey(L"latency", sp_latencies.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  hr = SetMethodKey(sp_result.get(), L"reset", winrt::make<ResetStatsMethod>());
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
+
+HRESULT __stdcall ResetStatsMethod::Call(IModelObject* p_context_object,
+                                         ULONG64 arg_count,
+                                         IModelObject** pp_arguments,
+                                         IModelObject** pp_result,
+                                         IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count != 0) return E_INVALIDARG;
+  ResetStats();
+  return CreateBool(true, pp_result);
+}
+
+HRESULT __stdcall V8DbgTraceAlias::Call(IModelObject* p_context_object,
+                                        ULONG64 arg_count,
+                                        IModelObject** pp_arguments,
+                                        IModelObject** pp_result,
+                                        IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count != 0) return E_INVALIDARG;
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  winrt::com_ptr<IModelObject> sp_result, sp_tracing;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+
+  hr = CreateBool(IsTracing(), sp_tracing.put());
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"tracing", sp_tracing.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = SetULong64Key(sp_result.get(), L"events", GetTraceEventCount());
+  if (FAILED(hr)) return hr;
+  hr = SetMethodKey(sp_result.get(), L"start", winrt::make<StartTraceMethod>());
+  if (FAILED(hr)) return hr;
+  hr = SetMethodKey(sp_result.get(), L"stop", winrt::make<StopTraceMethod>());
+  if (FAILED(hr)) return hr;
+  hr = SetMethodKey(sp_result.get(), L"save", winrt::make<SaveTraceMethod>());
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
+
+HRESULT __stdcall StartTraceMethod::Call(IModelObject* p_context_object,
+                                         ULONG64 arg_count,
+                                         IModelObject** pp_arguments,
+                                         IModelObject** pp_result,
+                                         IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count != 0) return E_INVALIDARG;
+  StartTracing();
+  return CreateBool(true, pp_result);
+}
+
+HRESULT __stdcall StopTraceMethod::Call(IModelObject* p_context_object,
+                                        ULONG64 arg_count,
+                                        IModelObject** pp_arguments,
+                                        IModelObject** pp_result,
+                                        IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count != 0) return E_INVALIDARG;
+  StopTracing();
+  return CreateULong64(GetTraceEventCount(), pp_result);
+}
+
+HRESULT __stdcall SaveTraceMethod::Call(IModelObject* p_context_object,
+                                        ULONG64 arg_count,
+                                        IModelObject** pp_arguments,
+                                        IModelObject** pp_result,
+                                        IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  if (arg_count != 1) return E_INVALIDARG;
+
+  VARIANT vt_path;
+  HRESULT hr = pp_arguments[0]->GetIntrinsicValue(&vt_path);
+  if (FAILED(hr)) return hr;
+  if (vt_path.vt != VT_BSTR) {
+    ::VariantClear(&vt_path);
+    return E_INVALIDARG;
+  }
+  FILE* file = _wfopen(vt_path.bstrVal, L"wb");
+  ::VariantClear(&vt_path);
+  if (file == nullptr) return E_ACCESSDENIED;
+  std::string json = GetTraceJson();
+  bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+  if (fclose(file) != 0) written = false;
+  if (!written) return E_FAIL;
+  return CreateULong64(GetTraceEventCount(), pp_result);
+}
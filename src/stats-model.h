@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../utilities.h"
+
+// @$v8dbgstats(): the counters and latencies from stats.h, summed over all
+// threads. The result's reset() method clears them.
+struct V8DbgStatsAlias : winrt::implements<V8DbgStatsAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
+
+struct ResetStatsMethod : winrt::implements<ResetStatsMethod, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
+
+// @$v8dbgtrace(): the state of the span tracer from trace.h, with start(),
+// stop() and save(path) methods. save writes Chrome trace JSON.
+struct V8DbgTraceAlias : winrt::implements<V8DbgTraceAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
+
+struct StartTraceMethod : winrt::implements<StartTraceMethod, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
+
+struct StopTraceMethod : winrt::implements<StopTraceMethod, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
+
+struct SaveTraceMethod : winrt::implements<SaveTraceMethod, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
@@ -0,0 +1,153 @@
+#include "stats.h"
+
+#include <atomic>
+
+namespace {
+
+// Threads beyond this many share one slot, which is still correct but
+// contended. Slots are static, so nothing is allocated (or reported as a
+// leak when the extension unloads).
+constexpr size_t kMaxThreadSlots = 32;
+
+struct AtomicLatencyStats {
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> total_ns;
+  std::atomic<uint64_t> buckets[kLatencyBuckets];
+};
+
+struct ThreadStats {
+  void AddTo(StatsSnapshot* snapshot) const {
+    for (size_t i = 0; i < kCounterCount; ++i) {
+      snapshot->counters[i] += counters[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kTimerCount; ++i) {
+      LatencyStats& latency = snapshot->timers[i];
+      latency.count += timers[i].count.load(std::memory_order_relaxed);
+      latency.total_ns += timers[i].total_ns.load(std::memory_order_relaxed);
+      for (size_t j = 0; j < kLatencyBuckets; ++j) {
+        latency.buckets[j] += timers[i].buckets[j].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void Add(const StatsSnapshot& snapshot) {
+    for (size_t i = 0; i < kCounterCount; ++i) {
+      counters[i].fetch_add(snapshot.counters[i], std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kTimerCount; ++i) {
+      const LatencyStats& latency = snapshot.timers[i];
+      timers[i].count.fetch_add(latency.count, std::memory_order_relaxed);
+      timers[i].total_ns.fetch_add(latency.total_ns, std::memory_order_relaxed);
+      for (size_t j = 0; j < kLatencyBuckets; ++j) {
+        timers[i].buckets[j].fetch_add(latency.buckets[j], std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void Clear() {
+    for (auto& counter : counters) counter.store(0, std::memory_order_relaxed);
+    for (auto& timer : timers) {
+      timer.count.store(0, std::memory_order_relaxed);
+      timer.total_ns.store(0, std::memory_order_relaxed);
+      for (auto& bucket : timer.buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<uint64_t> counters[kCounterCount];
+  AtomicLatencyStats timers[kTimerCount];
+};
+
+ThreadStats thread_slots[kMaxThreadSlots];
+std::atomic<bool> slot_in_use[kMaxThreadSlots];
+ThreadStats shared_slot;  // For threads that didn't get their own.
+ThreadStats exited_threads;  // Folded in from threads that have exited.
+
+// Claims a slot on a thread's first update, and folds its totals into
+// exited_threads when the thread exits so the slot can be reused.
+class ThreadSlot {
+ public:
+  ~ThreadSlot() {
+    if (stats_ == nullptr || stats_ == &shared_slot) return;
+    StatsSnapshot totals{};
+    stats_->AddTo(&totals);
+    exited_threads.Add(totals);
+    stats_->Clear();
+    slot_in_use[stats_ - thread_slots].store(false, std::memory_order_release);
+  }
+
+  ThreadStats* Get() {
+    if (stats_ != nullptr) return stats_;
+    stats_ = &shared_slot;
+    for (size_t i = 0; i < kMaxThreadSlots; ++i) {
+      bool expected = false;
+      if (slot_in_use[i].compare_exchange_strong(expected, true,
+                                                 std::memory_order_acquire)) {
+        stats_ = &thread_slots[i];
+        break;
+      }
+    }
+    return stats_;
+  }
+
+ private:
+  ThreadStats* stats_ = nullptr;
+};
+
+thread_local ThreadSlot thread_slot;
+
+}  // namespace
+
+const char* GetCounterName(Counter counter) {
+  switch (counter) {
+    case Counter::kMemoryReads: return "memory_reads";
+    case Counter::kBytesRead: return "bytes_read";
+    case Counter::kObjectDecodes: return "object_decodes";
+    case Counter::kTypeLookups: return "type_lookups";
+    case Counter::kTypeCacheMisses: return "type_cache_misses";
+    case Counter::kTypeLookupFailures: return "type_lookup_failures";
+    case Counter::kModuleDiscoveries: return "module_discoveries";
+    case Counter::kChunkListBuilds: return "chunk_list_builds";
+    case Counter::kHeapObjectsWalked: return "heap_objects_walked";
+    case Counter::kSizeDecodes: return "size_decodes";
+    default: return "unknown";
+  }
+}
+
+const char* GetTimerName(Timer timer) {
+  switch (timer) {
+    case Timer::kMemoryRead: return "memory_read";
+    case Timer::kObjectDecode: return "object_decode";
+    case Timer::kTypeLookup: return "type_lookup";
+    case Timer::kModuleDiscovery: return "module_discovery";
+    case Timer::kChunkList: return "chunk_list";
+    default: return "unknown";
+  }
+}
+
+void IncrementCounter(Counter counter, uint64_t amount) {
+  thread_slot.Get()->counters[static_cast<size_t>(counter)].fetch_add(
+      amount, std::memory_order_relaxed);
+}
+
+void RecordLatency(Timer timer, uint64_t nanoseconds) {
+  size_t bucket = 0;
+  while (bucket + 1 < kLatencyBuckets && (nanoseconds >> bucket) != 0) ++bucket;
+  AtomicLatencyStats& latency = thread_slot.Get()->timers[static_cast<size_t>(timer)];
+  latency.count.fetch_add(1, std::memory_order_relaxed);
+  latency.total_ns.fetch_add(nanoseconds, std::memory_order_relaxed);
+  latency.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+StatsSnapshot GetStatsSnapshot() {
+  StatsSnapshot snapshot{};
+  for (const ThreadStats& stats : thread_slots) stats.AddTo(&snapshot);
+  shared_slot.AddTo(&snapshot);
+  exited_threads.AddTo(&snapshot);
+  return snapshot;
+}
+
+void ResetStats() {
+  for (ThreadStats& stats : thread_slots) stats.Clear();
+  shared_slot.Clear();
+  exited_threads.Clear();
+}
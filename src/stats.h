@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Counters and latency histograms for the extension's own work, to find out
+// why a command is slow. Each thread updates its own slot, so recording is an
+// uncontended atomic add; reading sums over all the slots.
+
+enum class Counter {
+  kMemoryReads,
+  kBytesRead,
+  kObjectDecodes,
+  kTypeLookups,
+  kTypeCacheMisses,
+  kTypeLookupFailures,
+  kModuleDiscoveries,
+  kChunkListBuilds,
+  kHeapObjectsWalked,
+  kSizeDecodes,
+  kCount,
+};
+
+enum class Timer {
+  kMemoryRead,
+  kObjectDecode,
+  kTypeLookup,
+  kModuleDiscovery,
+  kChunkList,
+  kCount,
+};
+
+constexpr size_t kCounterCount = static_cast<size_t>(Counter::kCount);
+constexpr size_t kTimerCount = static_cast<size_t>(Timer::kCount);
+
+// Bucket i counts latencies below 2^i ns which didn't fit in bucket i - 1.
+// The last bucket also takes everything longer.
+constexpr size_t kLatencyBuckets = 32;
+
+const char* GetCounterName(Counter counter);
+const char* GetTimerName(Timer timer);
+
+void IncrementCounter(Counter counter, uint64_t amount = 1);
+void RecordLatency(Timer timer, uint64_t nanoseconds);
+
+// Records the time from construction to destruction.
+class ScopedLatency {
+ public:
+  explicit ScopedLatency(Timer timer)
+      : timer_(timer), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedLatency() {
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    RecordLatency(timer_, static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+  }
+
+ private:
+  ScopedLatency(const ScopedLatency&) = delete;
+  ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+  Timer timer_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+struct LatencyStats {
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t buckets[kLatencyBuckets];
+};
+
+struct StatsSnapshot {
+  uint64_t counters[kCounterCount];
+  LatencyStats timers[kTimerCount];
+};
+
+// Totals over all threads. Updates made while this runs may or may not be
+// included.
+StatsSnapshot GetStatsSnapshot();
+void ResetStats();
@@ -0,0 +1,127 @@
+#include "string-search.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define V8DBG_USE_SSE2 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+template <typename Char>
+size_t FindScalar(const Char* text, size_t length, const Char* needle,
+                  size_t needle_length, size_t start) {
+  for (size_t i = start; i + needle_length <= length; ++i) {
+    if (text[i] == needle[0] &&
+        std::equal(needle + 1, needle + needle_length, text + i + 1)) {
+      return i;
+    }
+  }
+  return SubstringMatcher::npos;
+}
+
+#if defined(V8DBG_USE_SSE2)
+
+inline unsigned CountTrailingZeros(unsigned value) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return index;
+#else
+  return __builtin_ctz(value);
+#endif
+}
+
+// Each bit of mask is a byte offset in the block at text where the first and
+// last code units match; check the ones in between.
+template <typename Char>
+size_t CheckCandidates(unsigned mask, const Char* text, const Char* needle,
+                       size_t needle_length) {
+  while (mask != 0) {
+    unsigned offset = CountTrailingZeros(mask) / sizeof(Char);
+    if (needle_length <= 2 ||
+        memcmp(text + offset + 1, needle + 1, (needle_length - 2) * sizeof(Char)) == 0) {
+      return offset;
+    }
+    // Clear all the bits for this code unit.
+    mask &= ~((sizeof(Char) == 1 ? 1u : 3u) << (offset * sizeof(Char)));
+  }
+  return SubstringMatcher::npos;
+}
+
+size_t FindOneByte(const uint8_t* text, size_t length, const uint8_t* needle,
+                   size_t needle_length) {
+  const __m128i first = _mm_set1_epi8(static_cast<char>(needle[0]));
+  const __m128i last = _mm_set1_epi8(static_cast<char>(needle[needle_length - 1]));
+  size_t i = 0;
+  for (; i + needle_length - 1 + 16 <= length; i += 16) {
+    __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+    __m128i block_last = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(text + i + needle_length - 1));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last))));
+    size_t offset = CheckCandidates(mask, text + i, needle, needle_length);
+    if (offset != SubstringMatcher::npos) return i + offset;
+  }
+  return FindScalar(text, length, needle, needle_length, i);
+}
+
+size_t FindTwoByte(const char16_t* text, size_t length, const char16_t* needle,
+                   size_t needle_length) {
+  const __m128i first = _mm_set1_epi16(static_cast<short>(needle[0]));
+  const __m128i last = _mm_set1_epi16(static_cast<short>(needle[needle_length - 1]));
+  size_t i = 0;
+  for (; i + needle_length - 1 + 8 <= length; i += 8) {
+    __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+    __m128i block_last = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(text + i + needle_length - 1));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi16(block_first, first), _mm_cmpeq_epi16(block_last, last))));
+    size_t offset = CheckCandidates(mask, text + i, needle, needle_length);
+    if (offset != SubstringMatcher::npos) return i + offset;
+  }
+  return FindScalar(text, length, needle, needle_length, i);
+}
+
+#else
+
+size_t FindOneByte(const uint8_t* text, size_t length, const uint8_t* needle,
+                   size_t needle_length) {
+  return FindScalar(text, length, needle, needle_length, 0);
+}
+
+size_t FindTwoByte(const char16_t* text, size_t length, const char16_t* needle,
+                   size_t needle_length) {
+  return FindScalar(text, length, needle, needle_length, 0);
+}
+
+#endif
+
+}  // namespace
+
+SubstringMatcher::SubstringMatcher(std::u16string needle)
+    : needle_(std::move(needle)), is_one_byte_(true) {
+  for (char16_t c : needle_) {
+    if (c > 0xFF) is_one_byte_ = false;
+    one_byte_needle_.push_back(static_cast<char>(c));
+  }
+}
+
+size_t SubstringMatcher::Find(const uint8_t* text, size_t length) const {
+  if (needle_.empty()) return 0;
+  if (!is_one_byte_ || length < needle_.size()) return npos;
+  return FindOneByte(text, length,
+                     reinterpret_cast<const uint8_t*>(one_byte_needle_.data()),
+                     one_byte_needle_.size());
+}
+
+size_t SubstringMatcher::Find(const char16_t* text, size_t length) const {
+  if (needle_.empty()) return 0;
+  if (length < needle_.size()) return npos;
+  return FindTwoByte(text, length, needle_.data(), needle_.size());
+}
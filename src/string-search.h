@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Finds a UTF-16 needle in text stored the way V8 stores string payloads:
+// either one byte (Latin-1) or two bytes per code unit. Candidate positions
+// are found 16 bytes at a time by comparing against the needle's first and
+// last code units, so only those are compared in full.
+//
+// This only depends on the standard library, so it can also scan memory
+// images outside the debugger.
+class SubstringMatcher {
+ public:
+  static constexpr size_t npos = SIZE_MAX;
+
+  explicit SubstringMatcher(std::u16string needle);
+
+  // Index of the first occurrence in text[0, length), or npos.
+  size_t Find(const uint8_t* text, size_t length) const;
+  size_t Find(const char16_t* text, size_t length) const;
+
+  size_t length() const { return needle_.size(); }
+
+ private:
+  std::u16string needle_;
+  std::string one_byte_needle_;
+  bool is_one_byte_;  // Whether one-byte text can contain the needle at all.
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Keeps the count greatest of the values pushed to it, as ordered by less,
+// in O(count) memory however many values are pushed.
+template <typename T, typename Less = std::less<T>>
+class BoundedTopN {
+ public:
+  explicit BoundedTopN(size_t count, Less less = Less())
+      : count_(count), less_(less) {
+    values_.reserve(count);
+  }
+
+  // A selection of count 0 is full while empty, as nothing can be pushed.
+  bool full() const { return values_.size() >= count_; }
+  bool empty() const { return values_.empty(); }
+
+  // The least value kept, which the next value pushed has to beat once the
+  // selection is full. Only valid if !empty().
+  const T& least() const { return values_.front(); }
+
+  void Push(T value) {
+    if (!full()) {
+      values_.push_back(std::move(value));
+      std::push_heap(values_.begin(), values_.end(), Greater{less_});
+    } else if (count_ != 0 && less_(values_.front(), value)) {
+      std::pop_heap(values_.begin(), values_.end(), Greater{less_});
+      values_.back() = std::move(value);
+      std::push_heap(values_.begin(), values_.end(), Greater{less_});
+    }
+  }
+
+  // Returns the values kept, greatest first, and empties the selection.
+  std::vector<T> Take() {
+    std::sort_heap(values_.begin(), values_.end(), Greater{less_});
+    return std::move(values_);
+  }
+
+ private:
+  // Orders values_ as a min-heap, so that the least value is at the front.
+  struct Greater {
+    bool operator()(const T& a, const T& b) const { return less(b, a); }
+    Less less;
+  };
+
+  size_t count_;
+  Less less_;
+  std::vector<T> values_;
+};
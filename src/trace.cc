@@ -0,0 +1,111 @@
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+// Each slot is guarded by its own sequence number, so writers never wait on
+// each other or on a reader: a writer claims the next index, marks the slot
+// busy, fills it in and then publishes the index it wrote. A reader keeps the
+// slot only if the same index is published before and after copying it.
+struct TraceSlot {
+  std::atomic<uint64_t> sequence;  // Index + 1 once written; 0 while busy.
+  std::atomic<const char*> name;
+  std::atomic<uint64_t> start_ns;
+  std::atomic<uint64_t> end_ns;
+  std::atomic<uint32_t> thread;
+};
+
+TraceSlot trace_slots[kTraceCapacity];
+std::atomic<uint64_t> next_index;
+std::atomic<bool> tracing;
+std::atomic<uint64_t> trace_start_ns;
+std::atomic<uint32_t> next_thread;
+
+uint32_t CurrentThread() {
+  // Small numbers read better than OS thread ids in the trace viewer.
+  thread_local uint32_t thread = next_thread.fetch_add(1, std::memory_order_relaxed) + 1;
+  return thread;
+}
+
+void AppendEscaped(std::string* out, const char* text) {
+  for (; *text != '\0'; ++text) {
+    if (*text == '"' || *text == '\\') out->push_back('\\');
+    out->push_back(*text);
+  }
+}
+
+}  // namespace
+
+void StartTracing() {
+  tracing.store(false, std::memory_order_relaxed);
+  for (TraceSlot& slot : trace_slots) slot.sequence.store(0, std::memory_order_relaxed);
+  next_index.store(0, std::memory_order_relaxed);
+  trace_start_ns.store(GetTraceTimeNs(), std::memory_order_relaxed);
+  tracing.store(true, std::memory_order_release);
+}
+
+void StopTracing() { tracing.store(false, std::memory_order_release); }
+
+bool IsTracing() { return tracing.load(std::memory_order_relaxed); }
+
+size_t GetTraceEventCount() {
+  uint64_t count = next_index.load(std::memory_order_acquire);
+  return count < kTraceCapacity ? static_cast<size_t>(count) : kTraceCapacity;
+}
+
+uint64_t GetTraceTimeNs() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void ScopedTrace::Record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+  uint64_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+  TraceSlot& slot = trace_slots[index % kTraceCapacity];
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.start_ns.store(start_ns, std::memory_order_relaxed);
+  slot.end_ns.store(end_ns, std::memory_order_relaxed);
+  slot.thread.store(CurrentThread(), std::memory_order_relaxed);
+  slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+std::string GetTraceJson() {
+  uint64_t end = next_index.load(std::memory_order_acquire);
+  uint64_t begin = end > kTraceCapacity ? end - kTraceCapacity : 0;
+  uint64_t origin = trace_start_ns.load(std::memory_order_relaxed);
+
+  std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  for (uint64_t index = begin; index < end; ++index) {
+    TraceSlot& slot = trace_slots[index % kTraceCapacity];
+    if (slot.sequence.load(std::memory_order_acquire) != index + 1) continue;
+    const char* name = slot.name.load(std::memory_order_relaxed);
+    uint64_t start_ns = slot.start_ns.load(std::memory_order_relaxed);
+    uint64_t end_ns = slot.end_ns.load(std::memory_order_relaxed);
+    uint32_t thread = slot.thread.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Overwritten while being copied.
+    if (slot.sequence.load(std::memory_order_relaxed) != index + 1) continue;
+
+    // Complete ("X") events hold a span's begin and end in one record, with
+    // times in microseconds.
+    // Spans that began before tracing was restarted are clamped to its start.
+    if (end_ns < origin) continue;
+    if (start_ns < origin) start_ns = origin;
+    char fields[160];
+    snprintf(fields, sizeof(fields),
+             "\",\"cat\":\"v8dbg\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+             "\"pid\":1,\"tid\":%u}",
+             (start_ns - origin) / 1000.0, (end_ns - start_ns) / 1000.0, thread);
+    json += first ? "\n{\"name\":\"" : ",\n{\"name\":\"";
+    AppendEscaped(&json, name);
+    json += fields;
+    first = false;
+  }
+  json += "\n]}\n";
+  return json;
+}
@@ -0,0 +1,115 @@
+#include "transcode.h"
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define V8DBG_USE_SSE2 1
+#endif
+
+namespace {
+
+constexpr bool IsContinuation(uint8_t byte) { return (byte & 0xC0) == 0x80; }
+
+// Decodes the multi-byte sequence at data[0, length), writing one or two
+// units. Returns the number of bytes consumed, or 0 if it isn't a valid
+// sequence: overlong forms, surrogates and values above U+10FFFF are
+// rejected.
+size_t DecodeSequence(const uint8_t* data, size_t length, char16_t* out,
+                      size_t* units) {
+  uint8_t lead = data[0];
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    if (length < 2 || !IsContinuation(data[1])) return 0;
+    out[0] = static_cast<char16_t>(((lead & 0x1F) << 6) | (data[1] & 0x3F));
+    *units = 1;
+    return 2;
+  }
+  if (lead >= 0xE0 && lead <= 0xEF) {
+    if (length < 3 || !IsContinuation(data[1]) || !IsContinuation(data[2])) {
+      return 0;
+    }
+    uint32_t code_point = ((lead & 0x0F) << 12) | ((data[1] & 0x3F) << 6) |
+                          (data[2] & 0x3F);
+    if (code_point < 0x800 || (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+      return 0;
+    }
+    out[0] = static_cast<char16_t>(code_point);
+    *units = 1;
+    return 3;
+  }
+  if (lead >= 0xF0 && lead <= 0xF4) {
+    if (length < 4 || !IsContinuation(data[1]) || !IsContinuation(data[2]) ||
+        !IsContinuation(data[3])) {
+      return 0;
+    }
+    uint32_t code_point = ((lead & 0x07) << 18) | ((data[1] & 0x3F) << 12) |
+                          ((data[2] & 0x3F) << 6) | (data[3] & 0x3F);
+    if (code_point < 0x10000 || code_point > 0x10FFFF) return 0;
+    code_point -= 0x10000;
+    out[0] = static_cast<char16_t>(0xD800 + (code_point >> 10));
+    out[1] = static_cast<char16_t>(0xDC00 + (code_point & 0x3FF));
+    *units = 2;
+    return 4;
+  }
+  return 0;
+}
+
+#if defined(V8DBG_USE_SSE2)
+// Widens 16 bytes into 16 units.
+inline void Widen16(const uint8_t* data, char16_t* out) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(bytes, zero));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(bytes, zero));
+}
+
+inline bool IsAscii16(const uint8_t* data) {
+  return _mm_movemask_epi8(
+             _mm_loadu_si128(reinterpret_cast<const __m128i*>(data))) == 0;
+}
+#endif
+
+}  // namespace
+
+void WidenLatin1(const char* data, size_t length, char16_t* out) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  size_t i = 0;
+#if defined(V8DBG_USE_SSE2)
+  for (; i + 16 <= length; i += 16) Widen16(bytes + i, out + i);
+#endif
+  for (; i < length; ++i) out[i] = bytes[i];
+}
+
+size_t Utf8ToUtf16(const char* data, size_t length, char16_t* out) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  size_t in = 0;
+  size_t written = 0;
+  while (in < length) {
+#if defined(V8DBG_USE_SSE2)
+    // Most text from v8_debug_helper is ASCII: field names, type names and
+    // the like. Take it 16 bytes at a time until a non-ASCII byte shows up.
+    while (in + 16 <= length && IsAscii16(bytes + in)) {
+      Widen16(bytes + in, out + written);
+      in += 16;
+      written += 16;
+    }
+#endif
+    if (in >= length) break;
+    uint8_t byte = bytes[in];
+    if (byte < 0x80) {
+      out[written++] = byte;
+      ++in;
+      continue;
+    }
+    size_t units;
+    size_t consumed = DecodeSequence(bytes + in, length - in, out + written, &units);
+    if (consumed == 0) {
+      out[written++] = byte;  // Not UTF-8, so take it as Latin-1.
+      ++in;
+    } else {
+      in += consumed;
+      written += units;
+    }
+  }
+  return written;
+}
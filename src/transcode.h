@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Conversions to UTF-16 for strings coming from v8_debug_helper (UTF-8) and
+// from the target's one-byte strings (Latin-1). Runs of ASCII are converted
+// 16 bytes at a time, and output is written straight into the destination.
+
+// Widens length Latin-1 characters into out, which must hold length units.
+void WidenLatin1(const char* data, size_t length, char16_t* out);
+
+// Decodes length bytes of UTF-8 into out, which must hold length units (UTF-16
+// never takes more units than UTF-8 takes bytes). Returns the number of units
+// written. Bytes that don't start a valid sequence are taken as Latin-1, so
+// text in either encoding comes out readable.
+size_t Utf8ToUtf16(const char* data, size_t length, char16_t* out);
+
+// Replaces the contents of out (any UTF-16 string type, such as a
+// std::pmr::u16string) with utf8 decoded.
+template <typename String>
+void AssignUtf8(std::string_view utf8, String* out) {
+  out->resize(utf8.size());
+  out->resize(Utf8ToUtf16(utf8.data(), utf8.size(), out->data()));
+}
+
+inline std::u16string Utf8ToU16String(std::string_view utf8) {
+  std::u16string result;
+  AssignUtf8(utf8, &result);
+  return result;
+}
@@ -0,0 +1,114 @@
+#include "type-cache.h"
+#include "extension.h"
+#include "stats.h"
+
+ModuleKey GetModuleKey(winrt::com_ptr<IDebugHostModule>& sp_module) {
+  ModuleKey key;
+  Location base_location;
+  if (FAILED(sp_module->GetBaseLocation(&base_location))) return key;
+  key.base = base_location.GetOffset();
+
+  winrt::com_ptr<IDebugSystemObjects> sp_sys_objects;
+  if (sp_debug_control.try_as(sp_sys_objects)) {
+    sp_sys_objects->GetCurrentProcessSystemId(&key.process_id);
+  }
+
+  // The same base can be reused by a different image after an unload, so
+  // include the image's timestamp.
+  winrt::com_ptr<IDebugSymbols3> sp_symbols;
+  DEBUG_MODULE_PARAMETERS params;
+  if (sp_debug_control.try_as(sp_symbols) &&
+      SUCCEEDED(sp_symbols->GetModuleParameters(1, &key.base, 0, &params))) {
+    key.time_date_stamp = params.TimeDateStamp;
+  }
+  return key;
+}
+
+winrt::com_ptr<IDebugHostType> TypeCache::GetType(
+    winrt::com_ptr<IDebugHostModule>& sp_module, const ModuleKey& key,
+    const char16_t* type_name, Outcome* p_outcome) {
+  IncrementCounter(Counter::kTypeLookups);
+  TypeMap& types = GetTypesForModule(key);
+  auto it = types.find(type_name);
+  if (it != types.end()) {
+    *p_outcome = Outcome::kHit;
+    return it->second;  // Null if the type wasn't found before.
+  }
+
+  winrt::com_ptr<IDebugHostType> sp_type;
+  HRESULT hr = sp_module->FindTypeByName(reinterpret_cast<PCWSTR>(type_name),
+                                         sp_type.put());
+  if (FAILED(hr)) sp_type = nullptr;
+  *p_outcome = sp_type != nullptr ? Outcome::kMiss : Outcome::kFailed;
+  IncrementCounter(sp_type != nullptr ? Counter::kTypeCacheMisses
+                                      : Counter::kTypeLookupFailures);
+  types.emplace(type_name, sp_type);
+  return sp_type;
+}
+
+void TypeCache::Clear() {
+  modules_.clear();
+}
+
+TypeCache::TypeMap& TypeCache::GetTypesForModule(const ModuleKey& key) {
+  for (auto it = modules_.begin(); it != modules_.end(); ++it) {
+    if (it->first == key) {
+      modules_.splice(modules_.begin(), modules_, it);
+      return modules_.front().second;
+    }
+  }
+  modules_.emplace_front(key, TypeMap{});
+  if (modules_.size() > kMaxModules) modules_.pop_back();
+  return modules_.front().second;
+}
+
+HRESULT __stdcall TypeCacheStatsAlias::Call(IModelObject* p_context_object,
+                                            ULONG64 arg_count,
+                                            IModelObject** pp_arguments,
+                                            IModelObject** pp_result,
+                                            IKeyStore** pp_metadata) noexcept {
+  *pp_result = nullptr;
+  const TypeCache& cache = Extension::current_extension_->type_cache_;
+
+  winrt::com_ptr<IDebugHostContext> sp_ctx;
+  HRESULT hr = sp_debug_host->GetCurrentContext(sp_ctx.put());
+  if (FAILED(hr)) return hr;
+  winrt::com_ptr<IModelObject> sp_result, sp_hits, sp_misses, sp_failed,
+      sp_hit_rate, sp_modules;
+  hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_result.put());
+  if (FAILED(hr)) return hr;
+
+  // The same counters as @$v8dbgstats(), so a reset there resets these too.
+  StatsSnapshot stats = GetStatsSnapshot();
+  auto counter = [&stats](Counter c) { return stats.counters[static_cast<size_t>(c)]; };
+  uint64_t lookups = counter(Counter::kTypeLookups);
+  uint64_t misses = counter(Counter::kTypeCacheMisses);
+  uint64_t failed = counter(Counter::kTypeLookupFailures);
+  // Counters read while another thread records may not add up exactly.
+  uint64_t hits = lookups >= misses + failed ? lookups - misses - failed : 0;
+  hr = CreateULong64(hits, sp_hits.put());
+  if (FAILED(hr)) return hr;
+  hr = CreateULong64(misses, sp_misses.put());
+  if (FAILED(hr)) return hr;
+  hr = CreateULong64(failed, sp_failed.put());
+  if (FAILED(hr)) return hr;
+  hr = CreateNumber(lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups,
+                    sp_hit_rate.put());
+  if (FAILED(hr)) return hr;
+  hr = CreateUInt32(static_cast<uint32_t>(cache.module_count()), sp_modules.put());
+  if (FAILED(hr)) return hr;
+
+  hr = sp_result->SetKey(L"hits", sp_hits.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"misses", sp_misses.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"failed", sp_failed.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"hit_rate", sp_hit_rate.get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetKey(L"modules", sp_modules.get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
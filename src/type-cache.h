@@ -0,0 +1,65 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "../utilities.h"
+
+// Identifies a loaded image independently of the context it was found
+// through. Type handles are resolved in one process, so the process is part
+// of the key even when another process has the same image at the same base.
+struct ModuleKey {
+  ULONG process_id = 0;
+  ULONG64 base = 0;
+  ULONG time_date_stamp = 0;
+
+  bool operator==(const ModuleKey& other) const {
+    return process_id == other.process_id && base == other.base &&
+           time_date_stamp == other.time_date_stamp;
+  }
+};
+
+ModuleKey GetModuleKey(winrt::com_ptr<IDebugHostModule>& sp_module);
+
+// Resolved type handles for the most recently used V8 modules. This is keyed by
+// module identity rather than by IDebugHostContext, as contexts with the CUSTOM
+// flag never compare equal and would otherwise empty the cache on every frame
+// or thread switch.
+class TypeCache {
+ public:
+  enum class Outcome {
+    kHit,     // Answered from the cache, whether or not the type exists.
+    kMiss,    // Resolved by this call.
+    kFailed,  // Looked up by this call and not found.
+  };
+
+  // Returns the cached handle for type_name in the module, resolving it on a
+  // miss, and counts the outcome in the extension's stats. Types that aren't
+  // found are remembered too, until the cache is cleared when symbols change.
+  winrt::com_ptr<IDebugHostType> GetType(
+      winrt::com_ptr<IDebugHostModule>& sp_module, const ModuleKey& key,
+      const char16_t* type_name, Outcome* p_outcome);
+  void Clear();
+
+  size_t module_count() const { return modules_.size(); }
+
+ private:
+  using TypeMap =
+      std::unordered_map<std::u16string, winrt::com_ptr<IDebugHostType>>;
+
+  TypeMap& GetTypesForModule(const ModuleKey& key);
+
+  static constexpr size_t kMaxModules = 8;
+  // Most recently used first.
+  std::list<std::pair<ModuleKey, TypeMap>> modules_;
+};
+
+// @$typecachestats() - the type cache's share of @$v8dbgstats() counters,
+// with its hit rate.
+struct TypeCacheStatsAlias : winrt::implements<TypeCacheStatsAlias, IModelMethod> {
+  HRESULT __stdcall Call(IModelObject* p_context_object, ULONG64 arg_count,
+                         _In_reads_(arg_count) IModelObject** pp_arguments,
+                         IModelObject** pp_result,
+                         IKeyStore** pp_metadata) noexcept override;
+};
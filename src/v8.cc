@@ -1,10 +1,14 @@
 #include <Windows.h>
 #include <crtdbg.h>
-#include <sstream>
+#include <algorithm>
+#include <cstring>
 #include "extension.h"
 #include "v8.h"
 #include "../utilities.h"
 #include "debug-helper.h"
+#include "stats.h"
+#include "trace.h"
+#include "transcode.h"
 
 namespace d = v8::debug_helper;
 
@@ -41,16 +45,112 @@ T ReadBasicData(MemReader reader, uint64_t address) {
   return data;
 }
 
-std::u16string WidenString(const char* data) {
-  std::basic_ostringstream<char16_t> stream;
-  stream << data;
-  return stream.str();
+namespace {
+
+d::ObjectPropertiesResultPtr DecodeObject(const MemReader& mem_reader,
+                                          uint64_t tagged_ptr) {
+  ScopedTrace trace("DecodeObject");
+  ScopedLatency latency(Timer::kObjectDecode);
+  IncrementCounter(Counter::kObjectDecodes);
+  MemReaderScope reader_scope(mem_reader);
+  d::Roots heap_roots = {0};
+  heap_roots.any_heap_pointer = tagged_ptr;
+  return d::GetObjectProperties(tagged_ptr, reader_scope.GetReader(), heap_roots);
+}
+
+// The pointer compression cage is 4GB aligned, so any address within the heap
+// supplies the upper half. Smis are left alone.
+uint64_t DecompressTagged(uint64_t any_heap_address, uint32_t value) {
+  return (value & 1) == 0 ? value
+                          : (any_heap_address & ~uint64_t{0xFFFFFFFF}) | value;
+}
+
+bool EndsWith(const std::string& value, const char* suffix) {
+  size_t suffix_length = strlen(suffix);
+  return value.size() >= suffix_length &&
+         value.compare(value.size() - suffix_length, suffix_length, suffix) == 0;
+}
+
+StringKind ClassifyString(const std::string& type_name) {
+  if (EndsWith(type_name, "SeqOneByteString")) return StringKind::kSeqOneByte;
+  if (EndsWith(type_name, "SeqTwoByteString")) return StringKind::kSeqTwoByte;
+  if (EndsWith(type_name, "ExternalOneByteString")) return StringKind::kExternalOneByte;
+  if (EndsWith(type_name, "ExternalTwoByteString")) return StringKind::kExternalTwoByte;
+  if (EndsWith(type_name, "ConsString")) return StringKind::kCons;
+  if (EndsWith(type_name, "SlicedString")) return StringKind::kSliced;
+  if (EndsWith(type_name, "ThinString")) return StringKind::kThin;
+  return StringKind::kNotString;
+}
+
+// Size of a field type reported by v8_debug_helper. Anything that isn't a
+// known primitive is a tagged value.
+uint32_t FieldTypeSize(const std::string& type, int tagged_size) {
+  static const std::unordered_map<std::string, uint32_t> primitive_sizes{
+      {"bool", 1},     {"char", 1},      {"int8_t", 1},    {"uint8_t", 1},
+      {"int16_t", 2},  {"uint16_t", 2},  {"char16_t", 2},  {"int32_t", 4},
+      {"uint32_t", 4}, {"float", 4},     {"int64_t", 8},   {"uint64_t", 8},
+      {"double", 8},   {"intptr_t", 8},  {"uintptr_t", 8}, {"size_t", 8},
+      {"v8::internal::Address", 8},      {"v8::internal::InstanceType", 2}};
+  auto it = primitive_sizes.find(type);
+  if (it != primitive_sizes.end()) return it->second;
+  if (!type.empty() && type.back() == '*') return 8;
+  return tagged_size;
+}
+
+bool IsPrimitiveFieldType(const std::string& type) {
+  return FieldTypeSize(type, /*tagged_size=*/0) != 0;
+}
+
+// Objects are aligned to the tagged size.
+uint64_t RoundUpToTagged(uint64_t size, int tagged_size) {
+  return (size + tagged_size - 1) & ~uint64_t(tagged_size - 1);
+}
+
+// How many more decoded instances must agree with a size rule that was
+// guessed from a field other than "length".
+constexpr int kSizeRuleChecks = 2;
+
+// Where the last field of a decoded object ends. False if the length of an
+// array couldn't be determined.
+bool GetDecodedSize(const d::ObjectPropertiesResult& props, uint64_t object_start,
+                    int tagged_size, uint64_t* size) {
+  uint64_t end = 0;
+  for (size_t i = 0; i < props.num_properties; ++i) {
+    const d::ObjectProperty& prop = *props.properties[i];
+    if (prop.kind != d::PropertyKind::kSingle &&
+        prop.kind != d::PropertyKind::kArrayOfKnownSize) {
+      return false;
+    }
+    uint64_t count = prop.kind == d::PropertyKind::kSingle ? 1 : prop.num_values;
+    end = std::max(end, prop.address - object_start +
+                            count * FieldTypeSize(prop.type, tagged_size));
+  }
+  *size = RoundUpToTagged(end, tagged_size);
+  return true;
 }
 
-V8HeapObject GetHeapObject(MemReader mem_reader, uint64_t tagged_ptr, uint64_t referring_pointer) {
+}  // namespace
+
+V8HeapObject GetHeapObject(MemReader mem_reader, uint64_t tagged_ptr,
+                           uint64_t referring_pointer,
+                           std::pmr::memory_resource* resource) {
   // Read the value at the address, and see if it is a tagged pointer
 
-  V8HeapObject obj;
+  V8HeapObject obj(resource);
+  obj.tagged_ptr = tagged_ptr;
+  // A value that fits in 32 bits may be a compressed pointer, but may as well
+  // be a real pointer low in memory on a heap without compression. Only
+  // decompress it if the object it would point to says pointers are 4 bytes.
+  if (tagged_ptr <= 0xFFFFFFFF && referring_pointer != 0) {
+    uint64_t decompressed =
+        DecompressTagged(referring_pointer, static_cast<uint32_t>(tagged_ptr));
+    LayoutCache cache;
+    if (decompressed != tagged_ptr &&
+        cache.GetMap(mem_reader, decompressed) != nullptr &&
+        cache.tagged_size() == 4) {
+      obj.tagged_ptr = decompressed;
+    }
+  }
   MemReaderScope reader_scope(mem_reader);
 
   d::Roots heap_roots = {0};
@@ -58,19 +158,661 @@ V8HeapObject GetHeapObject(MemReader mem_reader, uint64_t tagged_ptr, uint64_t r
   // decompression based on the pointer to wherever we found this value, which
   // is likely (though not guaranteed) to be a heap pointer itself.
   heap_roots.any_heap_pointer = referring_pointer;
-  auto props = d::GetObjectProperties(tagged_ptr, reader_scope.GetReader(), heap_roots);
-  obj.friendly_name = WidenString(props->brief);
+  d::ObjectPropertiesResultPtr props;
+  {
+    ScopedTrace trace("DecodeObject");
+    ScopedLatency latency(Timer::kObjectDecode);
+    IncrementCounter(Counter::kObjectDecodes);
+    props = d::GetObjectProperties(tagged_ptr, reader_scope.GetReader(), heap_roots);
+  }
+  if (props->brief != nullptr) AssignUtf8(props->brief, &obj.friendly_name);
+  obj.properties.reserve(props->num_properties + 1);
   for (int property_index = 0; property_index < props->num_properties; ++property_index) {
     const auto& source_prop = *props->properties[property_index];
     //printf("%s: %s: %llx\n", source_prop.name, source_prop.type, source_prop.values[0].value);
-    Property dest_prop(WidenString(source_prop.name), WidenString(source_prop.type), source_prop.address);
+    Property& dest_prop = obj.properties.emplace_back(u"", u"", source_prop.address);
+    AssignUtf8(source_prop.name, &dest_prop.name);
+    AssignUtf8(source_prop.type, &dest_prop.type_name);
     if (source_prop.kind != d::PropertyKind::kSingle) {
       dest_prop.type = PropertyType::kArray;
       dest_prop.length = source_prop.num_values;
     }
     // TODO indexed values
-    obj.properties.push_back(dest_prop);
+  }
+
+  // The brief for a string is truncated, so offer the full value separately.
+  if (props->type != nullptr &&
+      ClassifyString(props->type) != StringKind::kNotString) {
+    Property& contents_prop = obj.properties.emplace_back(u"contents", u"", 0);
+    contents_prop.type = PropertyType::kStringContents;
   }
 
   return obj;
 }
+
+std::string GetObjectBrief(const MemReader& mem_reader, uint64_t tagged_ptr) {
+  auto props = DecodeObject(mem_reader, tagged_ptr);
+  if (props == nullptr || props->brief == nullptr) return "";
+  return props->brief;
+}
+
+const BitFieldLayout* FieldLayout::FindBitField(const char* name) const {
+  for (const BitFieldLayout& bit_field : bit_fields) {
+    if (bit_field.name == name) return &bit_field;
+  }
+  return nullptr;
+}
+
+const FieldLayout* ObjectLayout::FindField(const char* name) const {
+  for (const FieldLayout& field : fields) {
+    if (field.name == name) return &field;
+  }
+  return nullptr;
+}
+
+bool LayoutCache::Initialize(const MemReader& reader, uint64_t tagged_ptr) {
+  // Decode one object to learn the tagged size from its map field, then decode
+  // its map to learn where the instance type and size live.
+  auto props = DecodeObject(reader, tagged_ptr);
+  if (props == nullptr || props->type_check_result != d::TypeCheckResult::kUsedMap) {
+    return false;
+  }
+  const d::ObjectProperty* map_prop = nullptr;
+  for (size_t i = 0; i < props->num_properties; ++i) {
+    if (strcmp(props->properties[i]->name, "map") == 0) {
+      map_prop = props->properties[i];
+      break;
+    }
+  }
+  if (map_prop == nullptr) return false;
+  tagged_size_ =
+      strcmp(map_prop->type, "v8::internal::TaggedValue") == 0 ? 4 : 8;
+
+  // Every map's map is the meta map, which is its own map.
+  uint64_t map_ptr;
+  if (!ReadTagged(reader, map_prop->address, &map_ptr) ||
+      !ReadTagged(reader, map_ptr & ~kHeapObjectTagMask, &meta_map_)) {
+    tagged_size_ = 0;
+    return false;
+  }
+  auto map_props = DecodeObject(reader, map_ptr);
+  if (map_props == nullptr) {
+    tagged_size_ = 0;
+    return false;
+  }
+  for (size_t i = 0; i < map_props->num_properties; ++i) {
+    const d::ObjectProperty& prop = *map_props->properties[i];
+    uint32_t offset =
+        static_cast<uint32_t>(prop.address - (map_ptr & ~kHeapObjectTagMask));
+    if (strcmp(prop.name, "instance_type") == 0) {
+      instance_type_offset_ = offset;
+    } else if (strcmp(prop.name, "instance_size_in_words") == 0) {
+      instance_size_offset_ = offset;
+    }
+  }
+  if (instance_type_offset_ == 0) tagged_size_ = 0;
+  return tagged_size_ != 0;
+}
+
+bool LayoutCache::ReadTagged(const MemReader& reader, uint64_t address,
+                             uint64_t* value) {
+  if (tagged_size_ == 8) {
+    return reader(address, 8, reinterpret_cast<uint8_t*>(value));
+  }
+  uint32_t compressed;
+  if (!reader(address, 4, reinterpret_cast<uint8_t*>(&compressed))) {
+    return false;
+  }
+  *value = DecompressTagged(address, compressed);
+  return true;
+}
+
+bool LayoutCache::ReadTaggedArray(const MemReader& reader, uint64_t address,
+                                  size_t count, std::vector<uint64_t>* values) {
+  values->resize(count);
+  if (count == 0) return true;
+  if (tagged_size_ == 8) {
+    return reader(address, count * 8, reinterpret_cast<uint8_t*>(values->data()));
+  }
+  // Read the compressed values into the back half of the buffer, then
+  // decompress them front to back, which never overwrites one not yet read.
+  uint8_t* compressed = reinterpret_cast<uint8_t*>(values->data()) + count * 4;
+  if (!reader(address, count * 4, compressed)) return false;
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t value;
+    memcpy(&value, compressed + i * 4, 4);
+    (*values)[i] = DecompressTagged(address, value);
+  }
+  return true;
+}
+
+bool LayoutCache::ReadInteger(const MemReader& reader, uint64_t tagged_ptr,
+                              const FieldLayout& field, int64_t* value) {
+  uint64_t address = (tagged_ptr & ~kHeapObjectTagMask) + field.offset;
+  if (IsPrimitiveFieldType(field.type)) {
+    uint64_t raw = 0;
+    if (field.size > sizeof(raw) ||
+        !reader(address, field.size, reinterpret_cast<uint8_t*>(&raw))) {
+      return false;
+    }
+    bool is_signed = field.type[0] != 'u' && field.type != "char16_t";
+    int shift = 64 - 8 * field.size;
+    *value = is_signed ? static_cast<int64_t>(raw << shift) >> shift
+                       : static_cast<int64_t>(raw);
+    return true;
+  }
+
+  // A Smi: 31 bits in the low half with pointer compression, else 32 bits in
+  // the upper half.
+  uint64_t raw = 0;
+  if (!reader(address, tagged_size_, reinterpret_cast<uint8_t*>(&raw))) {
+    return false;
+  }
+  *value = tagged_size_ == 4 ? static_cast<int32_t>(raw) >> 1
+                             : static_cast<int64_t>(raw) >> 32;
+  return true;
+}
+
+bool LayoutCache::ReadBitField(const MemReader& reader, uint64_t tagged_ptr,
+                               const FieldLayout& field,
+                               const BitFieldLayout& bit_field, uint64_t* value) {
+  uint64_t raw = 0;
+  size_t size = (bit_field.shift + bit_field.bits + 7) / 8;
+  if (size > sizeof(raw) ||
+      !reader((tagged_ptr & ~kHeapObjectTagMask) + field.offset + bit_field.offset,
+              size, reinterpret_cast<uint8_t*>(&raw))) {
+    return false;
+  }
+  uint64_t mask = bit_field.bits >= 64 ? ~uint64_t{0} : (uint64_t{1} << bit_field.bits) - 1;
+  *value = (raw >> bit_field.shift) & mask;
+  return true;
+}
+
+MapInfo* LayoutCache::GetMapInfo(const MemReader& reader, uint64_t map_ptr) {
+  auto it = maps_.find(map_ptr);
+  if (it != maps_.end()) return &it->second;
+
+  // Only cache real maps, so that reading garbage doesn't fill the cache.
+  uint64_t map_start = map_ptr & ~kHeapObjectTagMask;
+  uint64_t map_map;
+  if ((map_ptr & kHeapObjectTagMask) != kHeapObjectTag ||
+      !ReadTagged(reader, map_start, &map_map) || map_map != meta_map_) {
+    return nullptr;
+  }
+
+  MapInfo info{};
+  info.address = map_ptr;
+  if (!reader(map_start + instance_type_offset_, sizeof(info.instance_type),
+              reinterpret_cast<uint8_t*>(&info.instance_type))) {
+    return nullptr;
+  }
+  uint8_t instance_size_in_words = 0;
+  if (instance_size_offset_ != 0 &&
+      !reader(map_start + instance_size_offset_, 1, &instance_size_in_words)) {
+    return nullptr;
+  }
+  info.instance_size = instance_size_in_words * tagged_size_;
+  return &maps_.emplace(map_ptr, info).first->second;
+}
+
+MapInfo* LayoutCache::GetMap(const MemReader& reader, uint64_t tagged_ptr) {
+  if ((tagged_ptr & 1) == 0) return nullptr;  // A Smi.
+  if (tagged_size_ == 0 && !Initialize(reader, tagged_ptr)) return nullptr;
+
+  uint64_t map_ptr;
+  if (!ReadTagged(reader, tagged_ptr & ~kHeapObjectTagMask, &map_ptr)) {
+    return nullptr;
+  }
+  return GetMapInfo(reader, map_ptr);
+}
+
+const ObjectLayout* LayoutCache::GetLayout(const MemReader& reader,
+                                           uint64_t tagged_ptr) {
+  MapInfo* map_info = GetMap(reader, tagged_ptr);
+  if (map_info == nullptr) return nullptr;
+  if (map_info->layout != nullptr) return map_info->layout;
+
+  auto existing = layouts_.find(map_info->instance_type);
+  if (existing != layouts_.end()) {
+    map_info->layout = &existing->second;
+    return map_info->layout;
+  }
+
+  auto props = DecodeObject(reader, tagged_ptr);
+  if (props == nullptr || props->type_check_result != d::TypeCheckResult::kUsedMap) {
+    return nullptr;
+  }
+  ObjectLayout layout;
+  layout.type_name = props->type != nullptr ? props->type : "";
+  layout.string_kind = ClassifyString(layout.type_name);
+  uint64_t object_start = tagged_ptr & ~kHeapObjectTagMask;
+  for (size_t i = 0; i < props->num_properties; ++i) {
+    const d::ObjectProperty& prop = *props->properties[i];
+    FieldLayout field;
+    field.name = prop.name;
+    field.type = prop.type;
+    field.offset = static_cast<uint32_t>(prop.address - object_start);
+    field.size = FieldTypeSize(field.type, tagged_size_);
+    field.is_array = prop.kind != d::PropertyKind::kSingle;
+    for (size_t j = 0; j < prop.num_struct_fields; ++j) {
+      const d::StructProperty& struct_field = *prop.struct_fields[j];
+      if (struct_field.num_bits == 0) continue;
+      field.bit_fields.push_back({struct_field.name, struct_field.type,
+                                  static_cast<uint32_t>(struct_field.offset),
+                                  struct_field.shift_bits, struct_field.num_bits});
+    }
+    layout.fields.push_back(std::move(field));
+  }
+  uint64_t decoded_size;
+  if (GetDecodedSize(*props, object_start, tagged_size_, &decoded_size)) {
+    LearnSizeRule(reader, tagged_ptr, decoded_size, &layout);
+  }
+  map_info->layout =
+      &layouts_.emplace(map_info->instance_type, std::move(layout)).first->second;
+  return map_info->layout;
+}
+
+void LayoutCache::LearnSizeRule(const MemReader& reader, uint64_t tagged_ptr,
+                                uint64_t decoded_size, ObjectLayout* layout) {
+  // The decoded FreeSpace only covers its header, so trust its size field.
+  const FieldLayout* size = layout->FindField("size");
+  if (size != nullptr && EndsWith(layout->type_name, "FreeSpace")) {
+    layout->size_rule = SizeRule::kSizeField;
+    layout->size_field = size - layout->fields.data();
+    return;
+  }
+
+  // Most variable sized objects end in an array of "length" elements. Only
+  // use that if it agrees with the decoded size of this instance.
+  const FieldLayout* length = layout->FindField("length");
+  const FieldLayout* last = nullptr;
+  uint32_t header_end = 0;
+  for (const FieldLayout& field : layout->fields) {
+    if (last == nullptr || field.offset > last->offset) last = &field;
+    if (!field.is_array) header_end = std::max(header_end, field.offset + field.size);
+  }
+  auto try_rule = [&](const FieldLayout& count, uint32_t array_offset,
+                      uint32_t element_size) {
+    int64_t value;
+    if (!ReadInteger(reader, tagged_ptr, count, &value) || value < 0 ||
+        RoundUpToTagged(array_offset + value * element_size, tagged_size_) !=
+            decoded_size) {
+      return false;
+    }
+    layout->size_rule = SizeRule::kLength;
+    layout->size_field = &count - layout->fields.data();
+    layout->array_offset = array_offset;
+    layout->element_size = element_size;
+    return true;
+  };
+  bool ends_in_array = last != nullptr && last->is_array && last->size != 0;
+  if (length != nullptr && ends_in_array &&
+      try_rule(*length, last->offset, last->size)) {
+    return;
+  }
+
+  // Others, like Code and the bytecode and scope info arrays of some
+  // versions, count their trailing array or body with some other integer
+  // field. One instance can agree with a field by chance, so such a rule is
+  // checked against a few more decoded instances before it is used alone.
+  for (const FieldLayout& field : layout->fields) {
+    bool is_integer = !field.is_array && (IsPrimitiveFieldType(field.type) ||
+                                          EndsWith(field.type, "Smi"));
+    if (!is_integer || &field == length) continue;
+    if ((ends_in_array && try_rule(field, last->offset, last->size)) ||
+        try_rule(field, header_end, 1)) {
+      layout->unchecked_sizes = kSizeRuleChecks;
+      return;
+    }
+  }
+}
+
+bool LayoutCache::ApplySizeRule(const MemReader& reader, uint64_t tagged_ptr,
+                                const ObjectLayout& layout, uint64_t* size) {
+  int64_t value;
+  switch (layout.size_rule) {
+    case SizeRule::kSizeField:
+      if (!ReadInteger(reader, tagged_ptr, layout.fields[layout.size_field],
+                       &value) ||
+          value < 0) {
+        return false;
+      }
+      *size = static_cast<uint64_t>(value);
+      return true;
+    case SizeRule::kLength:
+      if (!ReadInteger(reader, tagged_ptr, layout.fields[layout.size_field],
+                       &value) ||
+          value < 0) {
+        return false;
+      }
+      *size = RoundUpToTagged(layout.array_offset + value * layout.element_size,
+                              tagged_size_);
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool LayoutCache::GetObjectSize(const MemReader& reader, uint64_t tagged_ptr,
+                                MapInfo& map, uint64_t* size) {
+  if (map.instance_size != 0) {
+    *size = map.instance_size;
+    return true;
+  }
+
+  const ObjectLayout* layout = GetLayout(reader, tagged_ptr);
+  if (layout == nullptr) return false;
+  if (layout->size_rule != SizeRule::kDecode && layout->unchecked_sizes == 0) {
+    return ApplySizeRule(reader, tagged_ptr, *layout, size) &&
+           *size >= static_cast<uint64_t>(tagged_size_);
+  }
+
+  // No rule yet, or one still being checked: decode the whole object.
+  IncrementCounter(Counter::kSizeDecodes);
+  auto props = DecodeObject(reader, tagged_ptr);
+  if (props == nullptr ||
+      props->type_check_result != d::TypeCheckResult::kUsedMap ||
+      !GetDecodedSize(*props, tagged_ptr & ~kHeapObjectTagMask, tagged_size_,
+                      size)) {
+    return false;
+  }
+  if (layout->size_rule != SizeRule::kDecode) {
+    // The layout is owned here; map_info only hands out a const view of it.
+    ObjectLayout& learned = layouts_.find(map.instance_type)->second;
+    uint64_t rule_size;
+    if (ApplySizeRule(reader, tagged_ptr, learned, &rule_size) &&
+        rule_size == *size) {
+      --learned.unchecked_sizes;
+    } else {
+      learned.size_rule = SizeRule::kDecode;
+      learned.unchecked_sizes = 0;
+    }
+  }
+  return *size >= static_cast<uint64_t>(tagged_size_);
+}
+
+bool MemoryWindow::Read(uint64_t address, size_t size, uint8_t* buffer) {
+  if (address < start_ || address + size > end_ || size > kWindowSize) {
+    return reader_(address, size, buffer);
+  }
+  if (address < window_start_ || address + size > window_start_ + window_.size()) {
+    window_.resize(static_cast<size_t>(std::min<uint64_t>(kWindowSize, end_ - address)));
+    if (!reader_(address, window_.size(), window_.data())) {
+      // Part of the range is unreadable; fall back to exact reads there.
+      window_.clear();
+      return reader_(address, size, buffer);
+    }
+    window_start_ = address;
+  }
+  memcpy(buffer, window_.data() + (address - window_start_), size);
+  return true;
+}
+
+HeapObjectWalker::HeapObjectWalker(const MemReader& reader, LayoutCache& cache,
+                                   uint64_t start, uint64_t end,
+                                   uint64_t gap_start, uint64_t gap_end)
+    : window_(reader, start, end),
+      reader_([this](uint64_t address, size_t size, uint8_t* buffer) {
+        return window_.Read(address, size, buffer);
+      }),
+      cache_(cache),
+      next_(start),
+      end_(end),
+      gap_start_(gap_start),
+      gap_end_(gap_end) {}
+
+bool HeapObjectWalker::Next(HeapObjectInfo* object) {
+  if (next_ == gap_start_ && gap_end_ > gap_start_) next_ = gap_end_;
+  if (next_ >= end_) return false;
+  uint64_t tagged_ptr = next_ | kHeapObjectTag;
+  MapInfo* map = cache_.GetMap(reader_, tagged_ptr);
+  uint64_t size;
+  if (map == nullptr || !cache_.GetObjectSize(reader_, tagged_ptr, *map, &size) ||
+      size > end_ - next_) {
+    next_ = end_;
+    return false;
+  }
+  object->tagged_ptr = tagged_ptr;
+  object->map = map;
+  object->size = size;
+  next_ += size;
+  IncrementCounter(Counter::kHeapObjectsWalked);
+  return true;
+}
+
+namespace {
+
+// Code units read from the target per call when copying string payloads.
+constexpr size_t kStringReadChunk = 32 * 1024;
+
+// A range of code units still to be emitted from the string at tagged_ptr.
+struct StringSegment {
+  uint64_t tagged_ptr;
+  uint64_t start;
+  uint64_t length;
+};
+
+class StringReader {
+ public:
+  StringReader(const MemReader& reader, LayoutCache& cache,
+               const StringChunkSink& sink)
+      : reader_(reader), cache_(cache), sink_(sink) {}
+
+  bool GetLength(uint64_t tagged_ptr, const ObjectLayout** layout,
+                 uint64_t* length) {
+    *layout = cache_.GetLayout(reader_, tagged_ptr);
+    if (*layout == nullptr || (*layout)->string_kind == StringKind::kNotString) {
+      return false;
+    }
+    const FieldLayout* length_field = (*layout)->FindField("length");
+    int64_t value;
+    if (length_field == nullptr ||
+        !cache_.ReadInteger(reader_, tagged_ptr, *length_field, &value) ||
+        value < 0) {
+      return false;
+    }
+    *length = static_cast<uint64_t>(value);
+    return true;
+  }
+
+  bool ReadTaggedField(uint64_t tagged_ptr, const ObjectLayout& layout,
+                       const char* name, uint64_t* value) {
+    const FieldLayout* field = layout.FindField(name);
+    return field != nullptr &&
+           cache_.ReadTagged(
+               reader_, (tagged_ptr & ~kHeapObjectTagMask) + field->offset, value);
+  }
+
+  // Copies code units [start, start + length) of a flat payload to the sink.
+  StringReadResult EmitPayload(uint64_t payload, bool one_byte, uint64_t start,
+                               uint64_t length) {
+    size_t char_size = one_byte ? 1 : 2;
+    uint64_t address = payload + start * char_size;
+    while (length > 0) {
+      size_t count = static_cast<size_t>(std::min<uint64_t>(length, kStringReadChunk));
+      if (one_byte) {
+        if (!reader_(address, count, raw_.data())) return StringReadResult::kFailed;
+        WidenLatin1(reinterpret_cast<const char*>(raw_.data()), count, wide_.data());
+      } else if (!reader_(address, count * 2,
+                          reinterpret_cast<uint8_t*>(wide_.data()))) {
+        return StringReadResult::kFailed;
+      }
+      if (!sink_(wide_.data(), count)) return StringReadResult::kTruncated;
+      address += count * char_size;
+      length -= count;
+    }
+    return StringReadResult::kComplete;
+  }
+
+  StringReadResult EmitSegment(const StringSegment& segment,
+                               const ObjectLayout& layout,
+                               std::vector<StringSegment>& stack) {
+    uint64_t object = segment.tagged_ptr & ~kHeapObjectTagMask;
+    uint64_t end = segment.start + segment.length;
+    switch (layout.string_kind) {
+      case StringKind::kCons: {
+        uint64_t first, second, first_length;
+        const ObjectLayout* first_layout;
+        if (!ReadTaggedField(segment.tagged_ptr, layout, "first", &first) ||
+            !ReadTaggedField(segment.tagged_ptr, layout, "second", &second) ||
+            !GetLength(first, &first_layout, &first_length)) {
+          return StringReadResult::kFailed;
+        }
+        // Push the second half first so the first half is emitted first.
+        if (end > first_length) {
+          uint64_t second_start = std::max(segment.start, first_length);
+          stack.push_back({second, second_start - first_length, end - second_start});
+        }
+        if (segment.start < first_length) {
+          stack.push_back({first, segment.start,
+                           std::min(end, first_length) - segment.start});
+        }
+        return StringReadResult::kComplete;
+      }
+      case StringKind::kSliced: {
+        uint64_t parent;
+        int64_t offset;
+        const FieldLayout* offset_field = layout.FindField("offset");
+        if (!ReadTaggedField(segment.tagged_ptr, layout, "parent", &parent) ||
+            offset_field == nullptr ||
+            !cache_.ReadInteger(reader_, segment.tagged_ptr, *offset_field, &offset)) {
+          return StringReadResult::kFailed;
+        }
+        stack.push_back({parent, segment.start + offset, segment.length});
+        return StringReadResult::kComplete;
+      }
+      case StringKind::kThin: {
+        uint64_t actual;
+        if (!ReadTaggedField(segment.tagged_ptr, layout, "actual", &actual)) {
+          return StringReadResult::kFailed;
+        }
+        stack.push_back({actual, segment.start, segment.length});
+        return StringReadResult::kComplete;
+      }
+      case StringKind::kSeqOneByte:
+      case StringKind::kSeqTwoByte: {
+        const FieldLayout* chars = layout.FindField("chars");
+        if (chars == nullptr) return StringReadResult::kFailed;
+        return EmitPayload(object + chars->offset,
+                           layout.string_kind == StringKind::kSeqOneByte,
+                           segment.start, segment.length);
+      }
+      case StringKind::kExternalOneByte:
+      case StringKind::kExternalTwoByte: {
+        // Uncached external strings have no resource_data; reaching their
+        // contents would mean calling into the embedder's resource.
+        const FieldLayout* data = layout.FindField("resource_data");
+        uint64_t payload = 0;
+        if (data == nullptr ||
+            !reader_(object + data->offset, sizeof(payload),
+                     reinterpret_cast<uint8_t*>(&payload)) ||
+            payload == 0) {
+          return StringReadResult::kFailed;
+        }
+        return EmitPayload(payload,
+                           layout.string_kind == StringKind::kExternalOneByte,
+                           segment.start, segment.length);
+      }
+      default:
+        return StringReadResult::kFailed;
+    }
+  }
+
+ private:
+  const MemReader& reader_;
+  LayoutCache& cache_;
+  const StringChunkSink& sink_;
+  std::vector<uint8_t> raw_ = std::vector<uint8_t>(kStringReadChunk);
+  std::vector<char16_t> wide_ = std::vector<char16_t>(kStringReadChunk);
+};
+
+}  // namespace
+
+StringReadResult ReadV8String(const MemReader& reader, LayoutCache& cache,
+                              uint64_t tagged_ptr, size_t max_length,
+                              const StringChunkSink& sink) {
+  StringReader string_reader(reader, cache, sink);
+  const ObjectLayout* layout;
+  uint64_t length;
+  if (!string_reader.GetLength(tagged_ptr, &layout, &length)) {
+    return StringReadResult::kFailed;
+  }
+
+  uint64_t wanted = std::min<uint64_t>(length, max_length);
+  std::vector<StringSegment> stack{{tagged_ptr, 0, wanted}};
+  while (!stack.empty()) {
+    StringSegment segment = stack.back();
+    stack.pop_back();
+    if (segment.length == 0) continue;
+    layout = cache.GetLayout(reader, segment.tagged_ptr);
+    if (layout == nullptr) return StringReadResult::kFailed;
+    StringReadResult result = string_reader.EmitSegment(segment, *layout, stack);
+    if (result != StringReadResult::kComplete) return result;
+  }
+  return wanted < length ? StringReadResult::kTruncated
+                         : StringReadResult::kComplete;
+}
+
+bool StringPayloadSearch::Matches(const MemReader& reader, LayoutCache& cache,
+                                  uint64_t tagged_ptr) {
+  const ObjectLayout* layout = cache.GetLayout(reader, tagged_ptr);
+  if (layout == nullptr) return false;
+
+  uint64_t object = tagged_ptr & ~kHeapObjectTagMask;
+  uint64_t payload = 0;
+  bool one_byte;
+  switch (layout->string_kind) {
+    case StringKind::kSeqOneByte:
+    case StringKind::kSeqTwoByte: {
+      const FieldLayout* chars = layout->FindField("chars");
+      if (chars == nullptr) return false;
+      payload = object + chars->offset;
+      one_byte = layout->string_kind == StringKind::kSeqOneByte;
+      break;
+    }
+    case StringKind::kExternalOneByte:
+    case StringKind::kExternalTwoByte: {
+      const FieldLayout* data = layout->FindField("resource_data");
+      if (data == nullptr ||
+          !reader(object + data->offset, sizeof(payload),
+                  reinterpret_cast<uint8_t*>(&payload)) ||
+          payload == 0) {
+        return false;
+      }
+      one_byte = layout->string_kind == StringKind::kExternalOneByte;
+      break;
+    }
+    default:
+      return false;
+  }
+
+  const FieldLayout* length_field = layout->FindField("length");
+  int64_t length;
+  if (length_field == nullptr ||
+      !cache.ReadInteger(reader, tagged_ptr, *length_field, &length) ||
+      length < 0) {
+    return false;
+  }
+
+  // Long payloads are read in pieces which overlap by one code unit less
+  // than the needle, so that a match straddling two pieces is still found.
+  size_t char_size = one_byte ? 1 : 2;
+  uint64_t piece = std::max<uint64_t>(kStringReadChunk, 2 * matcher_.length());
+  uint64_t overlap = matcher_.length() > 0 ? matcher_.length() - 1 : 0;
+  uint64_t start = 0;
+  while (start < static_cast<uint64_t>(length)) {
+    uint64_t count = std::min<uint64_t>(length - start, piece);
+    buffer_.resize(static_cast<size_t>(count * char_size));
+    if (!reader(payload + start * char_size, buffer_.size(), buffer_.data())) {
+      return false;
+    }
+    size_t found =
+        one_byte ? matcher_.Find(buffer_.data(), static_cast<size_t>(count))
+                 : matcher_.Find(reinterpret_cast<const char16_t*>(buffer_.data()),
+                                 static_cast<size_t>(count));
+    if (found != SubstringMatcher::npos) return true;
+    if (start + count == static_cast<uint64_t>(length)) break;
+    start += count - overlap;
+  }
+  return false;
+}
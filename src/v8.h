@@ -3,31 +3,266 @@
 #include <cstdint>
 #include <functional>
 #include <map>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
-
-using MemReader =
-  std::function<bool(uint64_t address, size_t size, uint8_t* buffer)>;
+#include "mem-reader.h"
+#include "string-search.h"
 
 enum class PropertyType {
   kPointer,
   kArray,
+  kStringContents,  // Synthesized for strings; see ReadV8String.
 };
 
+// Decoded objects take an allocator so that they can be placed in the arena
+// for the current stop (see arena.h); by default they use the normal heap.
 struct Property {
-  Property(std::u16string property_name, std::u16string type_name, uint64_t address)
-      : name(property_name), type_name(type_name), type(PropertyType::kPointer), addr_value(address) {}
+  using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+  Property(std::u16string_view property_name, std::u16string_view type_name,
+           uint64_t address, const allocator_type& allocator = {})
+      : name(property_name, allocator), type(PropertyType::kPointer),
+        type_name(type_name, allocator), addr_value(address) {}
+  Property(const Property& other, const allocator_type& allocator = {})
+      : name(other.name, allocator), type(other.type),
+        type_name(other.type_name, allocator), addr_value(other.addr_value),
+        length(other.length) {}
+  Property(Property&& other) = default;
+  Property(Property&& other, const allocator_type& allocator)
+      : name(std::move(other.name), allocator), type(other.type),
+        type_name(std::move(other.type_name), allocator),
+        addr_value(other.addr_value), length(other.length) {}
+  Property& operator=(const Property& other) = default;
+  Property& operator=(Property&& other) = default;
 
-  std::u16string name;
+  std::pmr::u16string name;
   PropertyType type;
-  std::u16string type_name;
+  std::pmr::u16string type_name;
   uint64_t addr_value;
   size_t length = 0; // Only relevant for PropertyType::kArray
 };
 
 struct V8HeapObject {
-  std::u16string friendly_name;  // String to print in single-line description.
-  std::vector<Property> properties;
+  explicit V8HeapObject(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : friendly_name(resource), properties(resource) {}
+
+  std::pmr::u16string friendly_name;  // String to print in single-line description.
+  std::pmr::vector<Property> properties;
+  uint64_t tagged_ptr = 0;
+};
+
+// Decodes the object at address, allocating the result from resource.
+V8HeapObject GetHeapObject(
+    MemReader mem_reader, uint64_t address, uint64_t referring_pointer,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+// The one-line description v8_debug_helper gives the object at tagged_ptr,
+// which names well-known roots such as "megamorphic_symbol".
+std::string GetObjectBrief(const MemReader& mem_reader, uint64_t tagged_ptr);
+
+constexpr uint64_t kHeapObjectTag = 1;
+constexpr uint64_t kWeakHeapObjectTag = 3;
+constexpr uint64_t kHeapObjectTagMask = 3;
+
+enum class StringKind {
+  kNotString,
+  kSeqOneByte,
+  kSeqTwoByte,
+  kExternalOneByte,
+  kExternalTwoByte,
+  kCons,
+  kSliced,
+  kThin,
+};
+
+// A bit field within a FieldLayout, such as the kind in a Code's flags.
+struct BitFieldLayout {
+  std::string name;
+  std::string type;
+  uint32_t offset;  // Of the containing value, relative to the field.
+  uint8_t shift;
+  uint8_t bits;
+};
+
+// One field of a heap object as reported by v8_debug_helper, relative to the
+// start of the object.
+struct FieldLayout {
+  const BitFieldLayout* FindBitField(const char* name) const;
+
+  std::string name;
+  std::string type;
+  uint32_t offset;
+  uint32_t size;  // Size of a single value, or 0 if not a known type.
+  bool is_array;
+  std::vector<BitFieldLayout> bit_fields;
 };
 
-V8HeapObject GetHeapObject(MemReader mem_reader, uint64_t address, uint64_t referring_pointer);
+// How to find the size of an object whose map doesn't give a fixed size.
+enum class SizeRule {
+  kDecode,     // Decode each object to see where its last field ends.
+  kLength,     // Ends after a count field's worth of array elements.
+  kSizeField,  // Holds its own size in bytes, like FreeSpace.
+};
+
+// The field layout shared by all objects of an instance type. It is learned by
+// decoding one instance with v8_debug_helper, after which other objects of the
+// same type can be read with a few raw memory reads.
+struct ObjectLayout {
+  const FieldLayout* FindField(const char* name) const;
+
+  std::string type_name;  // Runtime type, e.g. "v8::internal::ConsString".
+  std::vector<FieldLayout> fields;
+  StringKind string_kind = StringKind::kNotString;
+
+  SizeRule size_rule = SizeRule::kDecode;
+  size_t size_field = 0;  // Index of the count or size field in fields.
+  uint32_t array_offset = 0;  // Used with SizeRule::kLength.
+  uint32_t element_size = 0;
+  int unchecked_sizes = 0;  // Instances to decode before trusting the rule.
+};
+
+struct MapInfo {
+  uint64_t address;  // Tagged.
+  uint16_t instance_type;
+  uint32_t instance_size;  // In bytes, or 0 if instances vary in size.
+  const ObjectLayout* layout;  // Null until an instance has been decoded.
+};
+
+class LayoutCache {
+ public:
+  // Returns the layout of the object at tagged_ptr, decoding it the first time
+  // an object of its instance type is seen. Null if it can't be decoded.
+  const ObjectLayout* GetLayout(const MemReader& reader, uint64_t tagged_ptr);
+
+  // Reads a tagged value from a field at address, decompressing if needed.
+  bool ReadTagged(const MemReader& reader, uint64_t address, uint64_t* value);
+
+  // Reads count consecutive tagged values starting at address in one read.
+  bool ReadTaggedArray(const MemReader& reader, uint64_t address, size_t count,
+                       std::vector<uint64_t>* values);
+
+  // Reads an integer field (raw or Smi) of the object at tagged_ptr.
+  bool ReadInteger(const MemReader& reader, uint64_t tagged_ptr,
+                   const FieldLayout& field, int64_t* value);
+
+  // Reads one bit field of field in the object at tagged_ptr.
+  bool ReadBitField(const MemReader& reader, uint64_t tagged_ptr,
+                    const FieldLayout& field, const BitFieldLayout& bit_field,
+                    uint64_t* value);
+
+  // Returns the map of the object at tagged_ptr, or null if the object
+  // doesn't start with a pointer to a valid map.
+  MapInfo* GetMap(const MemReader& reader, uint64_t tagged_ptr);
+
+  // Finds the size in bytes of the object at tagged_ptr, whose map is map.
+  bool GetObjectSize(const MemReader& reader, uint64_t tagged_ptr,
+                     MapInfo& map, uint64_t* size);
+
+  // Zero until the first object has been decoded.
+  int tagged_size() const { return tagged_size_; }
+
+ private:
+  bool Initialize(const MemReader& reader, uint64_t tagged_ptr);
+  MapInfo* GetMapInfo(const MemReader& reader, uint64_t map_ptr);
+  void LearnSizeRule(const MemReader& reader, uint64_t tagged_ptr,
+                     uint64_t decoded_size, ObjectLayout* layout);
+  bool ApplySizeRule(const MemReader& reader, uint64_t tagged_ptr,
+                     const ObjectLayout& layout, uint64_t* size);
+
+  int tagged_size_ = 0;
+  uint64_t meta_map_ = 0;
+  uint32_t instance_type_offset_ = 0;
+  uint32_t instance_size_offset_ = 0;  // 0 if maps don't record a size.
+  std::unordered_map<uint64_t, MapInfo> maps_;
+  std::unordered_map<uint16_t, ObjectLayout> layouts_;
+};
+
+// Receives consecutive pieces of a string. Return false to stop reading.
+using StringChunkSink =
+    std::function<bool(const char16_t* data, size_t length)>;
+
+enum class StringReadResult {
+  kComplete,
+  kTruncated,  // Hit max_length, or the sink asked to stop.
+  kFailed,
+};
+
+// Streams the contents of the V8 string at tagged_ptr to sink, at most
+// max_length code units. Cons, sliced and thin strings are walked with an
+// explicit stack, so arbitrarily deep cons trees are safe to read.
+StringReadResult ReadV8String(const MemReader& reader, LayoutCache& cache,
+                              uint64_t tagged_ptr, size_t max_length,
+                              const StringChunkSink& sink);
+
+// Buffers reads within [start, end), so that stepping through many small
+// objects doesn't cost a round trip to the debugger for each field. Reads
+// outside the range go straight to the underlying reader.
+class MemoryWindow {
+ public:
+  MemoryWindow(MemReader reader, uint64_t start, uint64_t end)
+      : reader_(std::move(reader)), start_(start), end_(end) {}
+
+  bool Read(uint64_t address, size_t size, uint8_t* buffer);
+
+ private:
+  static constexpr size_t kWindowSize = 64 * 1024;
+
+  MemReader reader_;
+  uint64_t start_;
+  uint64_t end_;
+  uint64_t window_start_ = 0;
+  std::vector<uint8_t> window_;
+};
+
+struct HeapObjectInfo {
+  uint64_t tagged_ptr;
+  MapInfo* map;
+  uint64_t size;
+};
+
+// Steps through the objects laid out back to back in [start, end), such as
+// the area of a MemoryChunk. Only each object's map and size are read.
+class HeapObjectWalker {
+ public:
+  // [gap_start, gap_end) is a linear allocation area within the range, which
+  // is stepped over: objects end at its top, and nothing has been allocated
+  // from there to its limit yet. Pass 0 for both if there is none.
+  HeapObjectWalker(const MemReader& reader, LayoutCache& cache, uint64_t start,
+                   uint64_t end, uint64_t gap_start = 0, uint64_t gap_end = 0);
+  HeapObjectWalker(const HeapObjectWalker&) = delete;
+  HeapObjectWalker& operator=(const HeapObjectWalker&) = delete;
+
+  // Moves to the next object. Returns false at the end of the range, or at
+  // the first word that doesn't start a valid object.
+  bool Next(HeapObjectInfo* object);
+
+  // Reads through the walker's buffer; use for the current object's fields.
+  const MemReader& reader() const { return reader_; }
+
+ private:
+  MemoryWindow window_;
+  MemReader reader_;
+  LayoutCache& cache_;
+  uint64_t next_;
+  uint64_t end_;
+  uint64_t gap_start_;
+  uint64_t gap_end_;
+};
+
+// Searches the payloads of sequential and external strings. Cons, sliced and
+// thin strings are skipped, as their characters are stored in other strings.
+class StringPayloadSearch {
+ public:
+  explicit StringPayloadSearch(std::u16string needle) : matcher_(std::move(needle)) {}
+
+  // Whether the string at tagged_ptr holds the needle in its own payload.
+  bool Matches(const MemReader& reader, LayoutCache& cache, uint64_t tagged_ptr);
+
+ private:
+  SubstringMatcher matcher_;
+  std::vector<uint8_t> buffer_;
+};
@@ -0,0 +1,67 @@
+#include "../src/arena.h"
+#include "../src/v8.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+bool CheckAllocations() {
+  Arena arena;
+  for (size_t alignment : {1, 2, 8, 16, 64}) {
+    void* p = arena.allocate(3, alignment);
+    if (reinterpret_cast<uintptr_t>(p) % alignment != 0) {
+      printf("***ERROR***: allocation not aligned to %zu\n", alignment);
+      return false;
+    }
+  }
+  // Bigger than a block.
+  char* big = static_cast<char*>(arena.allocate(1 << 20, 8));
+  big[0] = big[(1 << 20) - 1] = 1;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&arena] {
+      for (int j = 0; j < 10000; ++j) (void)arena.allocate(16, 8);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  if (arena.bytes_allocated() != 5 * 3 + (1 << 20) + 4 * 10000 * 16) {
+    printf("***ERROR***: arena counted %zu bytes\n", arena.bytes_allocated());
+    return false;
+  }
+  return true;
+}
+
+bool CheckHeapObjectInArena() {
+  Arena arena;
+  V8HeapObject object(&arena);
+  object.friendly_name = u"a friendly name that won't fit in a short string";
+  object.properties.emplace_back(u"properties_or_hash", u"v8::internal::Object", 8);
+  object.properties.emplace_back(u"elements", u"v8::internal::FixedArrayBase", 16);
+  size_t used = arena.bytes_allocated();
+
+  // Moving keeps the data in the arena rather than copying it to the heap.
+  V8HeapObject moved(std::move(object));
+  if (used == 0 || arena.bytes_allocated() != used ||
+      moved.properties[0].name.get_allocator().resource() != &arena ||
+      moved.properties[1].type_name != u"v8::internal::FixedArrayBase") {
+    printf("***ERROR***: decoded object not allocated from the arena\n");
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  bool ok = true;
+  if (CheckAllocations()) {
+    printf("SUCCESS: arena allocations are aligned and counted\n");
+  } else {
+    ok = false;
+  }
+  if (CheckHeapObjectInArena()) {
+    printf("SUCCESS: V8HeapObject allocates from its arena\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+#include "../src/chunk-cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kBase = 0x10000;
+
+MemReader MakeReader(const std::vector<uint8_t>& memory) {
+  return [&memory](uint64_t address, size_t size, uint8_t* buffer) {
+    if (address < kBase || address - kBase + size > memory.size()) return false;
+    memcpy(buffer, memory.data() + (address - kBase), size);
+    return true;
+  };
+}
+
+bool CheckFingerprintChunk() {
+  std::vector<uint8_t> memory(256 * 1024);
+  for (size_t i = 0; i < memory.size(); ++i) memory[i] = static_cast<uint8_t>(i * 7);
+  MemReader reader = MakeReader(memory);
+  uint64_t end = kBase + memory.size();
+  uint64_t stride = memory.size() / 16;  // Where the sampled words are.
+  ChunkCounters counters{100000, 0};
+  uint64_t first, again, changed, unsampled;
+  bool ok = FingerprintChunk(reader, kBase, end, counters, &first) &&
+            FingerprintChunk(reader, kBase, end, counters, &again);
+  memory[3 * stride + 8] ^= 1;
+  ok = ok && FingerprintChunk(reader, kBase, end, counters, &unsampled);
+  memory[3 * stride + 2] ^= 1;
+  ok = ok && FingerprintChunk(reader, kBase, end, counters, &changed);
+  if (!ok || first != again || changed == first || unsampled != first) {
+    printf("***ERROR***: fingerprint doesn't follow the sampled words\n");
+    return false;
+  }
+
+  uint64_t allocated, marked, above_mark;
+  ChunkCounters more{100008, 0}, mark{100000, kBase + 0x8000};
+  ok = FingerprintChunk(reader, kBase, end, more, &allocated) &&
+       FingerprintChunk(reader, kBase, end, mark, &marked);
+  memory[0x9000] ^= 1;
+  ok = ok && FingerprintChunk(reader, kBase, end, mark, &above_mark);
+  if (!ok || allocated == changed || marked == changed || above_mark != marked) {
+    printf("***ERROR***: fingerprint doesn't follow the chunk's counters\n");
+    return false;
+  }
+
+  // Bump allocation in a linear allocation area writes objects between the
+  // sampled words and leaves the counters alone, but moves the top.
+  uint64_t before, after;
+  ChunkCounters area{100000, kBase + 0x8000, kBase + 0x4008, kBase + 0x6000};
+  ok = FingerprintChunk(reader, kBase, end, area, &before);
+  for (size_t i = 0x4008; i < 0x4048; ++i) memory[i] ^= 0x55;
+  area.allocation_top += 0x40;
+  ok = ok && FingerprintChunk(reader, kBase, end, area, &after);
+  if (!ok || before == after) {
+    printf("***ERROR***: allocation in the linear allocation area went unseen\n");
+    return false;
+  }
+
+  uint64_t unreadable;
+  if (FingerprintChunk(reader, kBase - 8, end, counters, &unreadable)) {
+    printf("***ERROR***: fingerprint of unreadable memory succeeded\n");
+    return false;
+  }
+  return true;
+}
+
+bool CheckChunkCache() {
+  ChunkCache<int> cache;
+  cache.Store(0x1000, 0x2000, 11, 1);
+  cache.Store(0x3000, 0x4000, 22, 2);
+  const int* found = cache.Find(0x1000, 0x2000, 11);
+  if (found == nullptr || *found != 1 || cache.Find(0x1000, 0x2000, 12) != nullptr ||
+      cache.Find(0x1000, 0x1800, 11) != nullptr || cache.Find(0x5000, 0x6000, 11) != nullptr) {
+    printf("***ERROR***: cache lookup doesn't check the chunk and its fingerprint\n");
+    return false;
+  }
+  cache.Store(0x1000, 0x2000, 12, 3);
+  found = cache.Find(0x1000, 0x2000, 12);
+  if (found == nullptr || *found != 3 || cache.size() != 2) {
+    printf("***ERROR***: changed chunk wasn't replaced\n");
+    return false;
+  }
+  cache.Sweep({0x3000, 0x7000});
+  if (cache.size() != 1 || cache.Find(0x3000, 0x4000, 22) == nullptr) {
+    printf("***ERROR***: sweep didn't drop exactly the freed chunks\n");
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+  if (CheckFingerprintChunk()) {
+    printf("SUCCESS: chunk fingerprint follows counters and sampled words\n");
+  } else {
+    ok = false;
+  }
+  if (CheckChunkCache()) {
+    printf("SUCCESS: chunk cache keeps unchanged chunks\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
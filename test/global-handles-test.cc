@@ -0,0 +1,135 @@
+#include "../src/global-handles.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+
+// Four 24-byte nodes per block, laid out the way Node is on x64.
+const GlobalHandleLayout kLayout = {
+    /*block_size=*/112, /*nodes_offset=*/0,    /*nodes_per_block=*/4,
+    /*next_used_offset=*/96, /*node_size=*/24, /*object_offset=*/0,
+    /*class_id_offset=*/8,   /*flags_offset=*/11,
+    /*state_mask=*/7,
+};
+
+class FakeMemory {
+ public:
+  void AddBlock(uint64_t address, uint64_t next_used) {
+    std::vector<uint8_t>& block = blocks_[address];
+    block.assign(kLayout.block_size, 0);
+    memcpy(block.data() + kLayout.next_used_offset, &next_used, 8);
+  }
+
+  void SetNode(uint64_t block, size_t index, uint64_t object, uint16_t class_id,
+               uint8_t flags) {
+    uint8_t* node = blocks_[block].data() + index * kLayout.node_size;
+    memcpy(node + kLayout.object_offset, &object, 8);
+    memcpy(node + kLayout.class_id_offset, &class_id, 2);
+    node[kLayout.flags_offset] = flags;
+  }
+
+  MemReader GetReader() {
+    return [this](uint64_t address, size_t size, uint8_t* buffer) {
+      auto it = blocks_.find(address);
+      if (it == blocks_.end() || size > it->second.size()) return false;
+      memcpy(buffer, it->second.data(), size);
+      return true;
+    };
+  }
+
+ private:
+  std::map<uint64_t, std::vector<uint8_t>> blocks_;
+};
+
+std::vector<GlobalHandle> Walk(FakeMemory& memory, uint64_t first_block,
+                               const GlobalHandleLayout& layout = kLayout) {
+  GlobalHandleWalker walker(memory.GetReader(), layout, first_block);
+  std::vector<GlobalHandle> handles;
+  GlobalHandle handle;
+  while (walker.Next(&handle)) handles.push_back(handle);
+  return handles;
+}
+
+bool CheckWalk() {
+  FakeMemory memory;
+  memory.AddBlock(0x1000, 0x2000);
+  memory.AddBlock(0x2000, 0);
+  memory.SetNode(0x1000, 0, 0xa1, 0, 1);
+  memory.SetNode(0x1000, 2, 0xa2, 7, 0x12);  // Weak, with other flags set.
+  memory.SetNode(0x1000, 3, 0xa3, 0, 0x10);  // Free, with other flags set.
+  memory.SetNode(0x2000, 3, 0xa4, 0, 1);
+
+  std::vector<GlobalHandle> handles = Walk(memory, 0x1000);
+  if (handles.size() != 3 || handles[0].location != 0x1000 ||
+      handles[0].object != 0xa1 || handles[1].location != 0x1000 + 2 * 24 ||
+      handles[1].class_id != 7 || handles[1].state != 2 ||
+      handles[2].location != 0x2000 + 3 * 24 || handles[2].object != 0xa4) {
+    printf("***ERROR***: walked %zu handles, not the three in use\n",
+           handles.size());
+    return false;
+  }
+  return true;
+}
+
+bool CheckStateMask() {
+  if (GetGlobalHandleStateMask(4) != 7 || GetGlobalHandleStateMask(2) != 3 ||
+      GetGlobalHandleStateMask(1) != 1) {
+    printf("***ERROR***: wrong state mask for the highest state\n");
+    return false;
+  }
+
+  // Newer versions keep IsInYoungList in bit 2, above the two state bits.
+  GlobalHandleLayout layout = kLayout;
+  layout.state_mask = GetGlobalHandleStateMask(2);
+  FakeMemory memory;
+  memory.AddBlock(0x1000, 0);
+  memory.SetNode(0x1000, 0, 0xa1, 0, 0x6);  // Weak, in the young list.
+  memory.SetNode(0x1000, 1, 0xa2, 0, 0x4);  // Free, still in the young list.
+  memory.SetNode(0x1000, 2, 0xa3, 0, 0x1);
+  std::vector<GlobalHandle> handles = Walk(memory, 0x1000, layout);
+  if (handles.size() != 2 || handles[0].object != 0xa1 ||
+      handles[0].state != 2 || handles[1].object != 0xa3 ||
+      handles[1].state != 1) {
+    printf("***ERROR***: flags above the state bits were read as the state\n");
+    return false;
+  }
+  return true;
+}
+
+bool CheckBadChains() {
+  FakeMemory memory;
+  memory.AddBlock(0x1000, 0x1000);  // Links to itself.
+  memory.SetNode(0x1000, 1, 0xa1, 0, 1);
+  if (Walk(memory, 0x1000).size() != 1) {
+    printf("***ERROR***: a cycle of blocks was walked more than once\n");
+    return false;
+  }
+  memory.AddBlock(0x3000, 0x4000);  // Links to unreadable memory.
+  memory.SetNode(0x3000, 0, 0xa2, 0, 1);
+  if (Walk(memory, 0x3000).size() != 1 || !Walk(memory, 0x5000).empty()) {
+    printf("***ERROR***: an unreadable block didn't end the walk\n");
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  bool ok = true;
+  if (CheckWalk()) {
+    printf("SUCCESS: walked the global handles in use\n");
+  } else {
+    ok = false;
+  }
+  if (CheckStateMask()) {
+    printf("SUCCESS: only the state bits of the flags are read\n");
+  } else {
+    ok = false;
+  }
+  if (CheckBadChains()) {
+    printf("SUCCESS: bad block chains end the walk\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "../src/handle-scopes.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+bool CheckBlockCounts() {
+  // The current block is the last, and is 10 handles in.
+  std::vector<HandleBlock> blocks =
+      GetHandleBlocks({0x10000, 0x20000, 0x30000}, 0x30000 + 10 * 8);
+  if (blocks.size() != 3 || blocks[0].handles != kHandleBlockSlots ||
+      blocks[1].handles != kHandleBlockSlots || blocks[2].address != 0x30000 ||
+      blocks[2].handles != 10) {
+    printf("***ERROR***: wrong handle counts for the blocks\n");
+    return false;
+  }
+  // A current block that was just entered holds no handles yet.
+  blocks = GetHandleBlocks({0x10000}, 0x10000);
+  if (blocks[0].handles != 0) {
+    printf("***ERROR***: an empty current block holds %zu handles\n",
+           blocks[0].handles);
+    return false;
+  }
+  return true;
+}
+
+bool CheckReadHandles() {
+  std::vector<uint64_t> memory = {0x11, 0x21, 0x31, 0x41};
+  const uint64_t base = 0x5000;
+  MemReader reader = [&memory, base](uint64_t address, size_t size, uint8_t* buffer) {
+    if (address < base || address + size > base + memory.size() * 8) return false;
+    memcpy(buffer, reinterpret_cast<uint8_t*>(memory.data()) + (address - base), size);
+    return true;
+  };
+  std::vector<uint64_t> values;
+  if (!ReadHandles(reader, {base, 3}, &values) ||
+      values != std::vector<uint64_t>{0x11, 0x21, 0x31}) {
+    printf("***ERROR***: didn't read the handles in use\n");
+    return false;
+  }
+  if (ReadHandles(reader, {base, 5}, &values) || !values.empty()) {
+    printf("***ERROR***: read past the end of memory\n");
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  bool ok = true;
+  if (CheckBlockCounts()) {
+    printf("SUCCESS: counted the handles in each block\n");
+  } else {
+    ok = false;
+  }
+  if (CheckReadHandles()) {
+    printf("SUCCESS: read the handles in a block\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
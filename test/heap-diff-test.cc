@@ -0,0 +1,94 @@
+#include "../src/heap-diff.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kStringMap = 0x1000;
+constexpr uint64_t kArrayMap = 0x2000;
+constexpr uint64_t kNewArrayMap = 0x3000;
+
+struct TestObject {
+  uint64_t address;
+  uint64_t map;
+  uint16_t instance_type;
+  uint64_t size;
+};
+
+// Writes objects to a new temporary file, which the caller closes.
+FILE* WriteTable(const std::vector<TestObject>& objects) {
+  FILE* file = tmpfile();
+  if (file == nullptr) return nullptr;
+  ObjectTableWriter writer(file);
+  writer.SetTypeName(1, "v8::internal::String");
+  writer.SetTypeName(2, "v8::internal::FixedArray");
+  writer.BeginChunk(0x10000, "OLD_SPACE");
+  for (const TestObject& object : objects) {
+    writer.Add(object.address, object.map, object.instance_type, object.size);
+  }
+  if (!writer.Finish()) {
+    fclose(file);
+    return nullptr;
+  }
+  return file;
+}
+
+bool CheckDiff() {
+  // 0x10020 is collected and its space reused by an array, 0x10060 is
+  // allocated and the arrays gain a new map.
+  FILE* before_file = WriteTable({{0x10000, kStringMap, 1, 32},
+                                  {0x10020, kStringMap, 1, 32},
+                                  {0x10040, kArrayMap, 2, 32}});
+  FILE* after_file = WriteTable({{0x10000, kStringMap, 1, 32},
+                                 {0x10020, kArrayMap, 2, 32},
+                                 {0x10040, kArrayMap, 2, 32},
+                                 {0x10060, kNewArrayMap, 2, 64}});
+  if (before_file == nullptr || after_file == nullptr) {
+    printf("***ERROR***: couldn't write object tables\n");
+    return false;
+  }
+  ObjectTableReader before(before_file), after(after_file);
+  HeapDiff diff;
+  bool ok = before.Open() && after.Open() && DiffObjectTables(before, after, 1, &diff);
+  fclose(before_file);
+  fclose(after_file);
+  if (!ok || diff.types.size() != 2) {
+    printf("***ERROR***: diff of object tables failed\n");
+    return false;
+  }
+
+  const TypeDelta& arrays = diff.types[0];
+  const TypeDelta& strings = diff.types[1];
+  if (arrays.type != "v8::internal::FixedArray" || arrays.count_delta() != 2 ||
+      arrays.bytes_delta() != 96 || arrays.new_count != 2 || arrays.new_bytes != 96 ||
+      strings.type != "v8::internal::String" || strings.count_delta() != -1 ||
+      strings.bytes_delta() != -32 || strings.new_count != 0) {
+    printf("***ERROR***: per-type deltas are wrong\n");
+    return false;
+  }
+  if (diff.new_objects != 2 || diff.new_bytes != 96 ||
+      diff.largest_new_objects.size() != 1 ||
+      diff.largest_new_objects[0].address != 0x10060) {
+    printf("***ERROR***: new objects are wrong\n");
+    return false;
+  }
+  if (diff.new_maps.size() != 1 || diff.new_maps[0].address != kNewArrayMap ||
+      diff.new_maps[0].instance_type != 2) {
+    printf("***ERROR***: new maps are wrong\n");
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+  if (CheckDiff()) {
+    printf("SUCCESS: object tables are diffed\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
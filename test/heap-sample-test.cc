@@ -0,0 +1,106 @@
+#include "../src/heap-sample.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+bool CheckPickSample() {
+  std::vector<size_t> sample = PickSample(1000, 0.1, 42);
+  if (sample.size() != 100) {
+    printf("***ERROR***: sample has %zu chunks rather than 100\n", sample.size());
+    return false;
+  }
+  for (size_t i = 0; i < sample.size(); ++i) {
+    if (sample[i] >= 1000 || (i > 0 && sample[i] <= sample[i - 1])) {
+      printf("***ERROR***: sample isn't distinct indexes in order\n");
+      return false;
+    }
+  }
+  if (PickSample(1000, 0.1, 42) != sample || PickSample(1000, 0.1, 43) == sample) {
+    printf("***ERROR***: sample doesn't depend on only its seed\n");
+    return false;
+  }
+  if (PickSample(10, 0.001, 1).size() != 1 || PickSample(10, 2, 1).size() != 10 ||
+      !PickSample(0, 0.5, 1).empty()) {
+    printf("***ERROR***: sample size isn't clamped\n");
+    return false;
+  }
+  return true;
+}
+
+// Chunks of a few sizes, each with a noisy amount of some type in it.
+std::vector<SampledChunk> MakePopulation(std::mt19937_64& random) {
+  std::vector<SampledChunk> chunks;
+  std::normal_distribution<double> noise(0.3, 0.1);
+  for (size_t i = 0; i < 2000; ++i) {
+    double area = i % 10 == 0 ? 1024 * 1024 : 256 * 1024;
+    chunks.push_back({area, area * std::max(0.0, noise(random))});
+  }
+  return chunks;
+}
+
+bool CheckFullSampleIsExact() {
+  std::mt19937_64 random(7);
+  std::vector<SampledChunk> population = MakePopulation(random);
+  double area = 0, total = 0;
+  for (const SampledChunk& chunk : population) {
+    area += chunk.area;
+    total += chunk.value;
+  }
+  SampleEstimate estimate = EstimateTotal(population, population.size(), area);
+  if (std::abs(estimate.value - total) > total * 1e-9 || estimate.margin != 0) {
+    printf("***ERROR***: sample of every chunk isn't exact\n");
+    return false;
+  }
+  return true;
+}
+
+bool CheckIntervalCoverage() {
+  std::mt19937_64 random(11);
+  std::vector<SampledChunk> population = MakePopulation(random);
+  double area = 0, total = 0;
+  for (const SampledChunk& chunk : population) {
+    area += chunk.area;
+    total += chunk.value;
+  }
+  // About 95 of 100 intervals should hold the true total.
+  int covered = 0;
+  for (uint64_t seed = 0; seed < 100; ++seed) {
+    std::vector<SampledChunk> sample;
+    for (size_t i : PickSample(population.size(), 0.05, seed)) {
+      sample.push_back(population[i]);
+    }
+    SampleEstimate estimate = EstimateTotal(sample, population.size(), area);
+    if (std::abs(estimate.value - total) <= estimate.margin) ++covered;
+  }
+  if (covered < 85) {
+    printf("***ERROR***: only %d of 100 intervals hold the total\n", covered);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+  if (CheckPickSample()) {
+    printf("SUCCESS: chunks are sampled at random\n");
+  } else {
+    ok = false;
+  }
+  if (CheckFullSampleIsExact()) {
+    printf("SUCCESS: sample of every chunk is exact\n");
+  } else {
+    ok = false;
+  }
+  if (CheckIntervalCoverage()) {
+    printf("SUCCESS: confidence intervals hold the total\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
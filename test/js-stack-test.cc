@@ -0,0 +1,181 @@
+#include "../src/js-stack.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+bool CheckCodeRangeIndex() {
+  CodeRangeIndex index;
+  index.Add({0x3000, 0x3100, 0x3001});
+  index.Add({0x1000, 0x1800, 0x1001});
+  index.Add({0x2000, 0x2040, 0x2001});
+  index.Build();
+  const CodeRange* found = index.Find(0x17ff);
+  if (found == nullptr || found->tagged_ptr != 0x1001 ||
+      index.Find(0x2000)->tagged_ptr != 0x2001 ||
+      index.Find(0x30ff)->tagged_ptr != 0x3001) {
+    printf("***ERROR***: didn't find the code holding a pc\n");
+    return false;
+  }
+  for (uint64_t pc : {0x0fff, 0x1800, 0x2040, 0x3100}) {
+    if (index.Find(pc) != nullptr) {
+      printf("***ERROR***: found code for 0x%llx, which is outside all of it\n",
+             static_cast<unsigned long long>(pc));
+      return false;
+    }
+  }
+  return true;
+}
+
+class FakeStack {
+ public:
+  static constexpr uint64_t kBase = 0x10000;
+
+  FakeStack() : words_(256) {}
+
+  // Writes a frame at fp that was called from caller_fp, returning to pc.
+  void SetFrame(uint64_t fp, uint64_t caller_fp, uint64_t pc) {
+    words_[(fp - kBase) / 8] = caller_fp;
+    words_[(fp - kBase) / 8 + 1] = pc;
+  }
+
+  void SetWord(uint64_t address, uint64_t value) { words_[(address - kBase) / 8] = value; }
+
+  MemReader GetReader() {
+    return [this](uint64_t address, size_t size, uint8_t* buffer) {
+      if (address < kBase || address + size > kBase + words_.size() * 8) {
+        return false;
+      }
+      memcpy(buffer, reinterpret_cast<uint8_t*>(words_.data()) + (address - kBase),
+             size);
+      return true;
+    };
+  }
+
+ private:
+  std::vector<uint64_t> words_;
+};
+
+bool CheckWalkFramePointers() {
+  FakeStack stack;
+  const uint64_t base = FakeStack::kBase;
+  stack.SetFrame(base + 0x100, base + 0x180, 0xa1);
+  stack.SetFrame(base + 0x180, base + 0x200, 0xa2);
+  stack.SetFrame(base + 0x200, base + 0x300, 0xa3);
+  stack.SetFrame(base + 0x300, 0, 0xa4);
+
+  std::vector<StackFrame> frames =
+      WalkFramePointers(stack.GetReader(), base + 0x100, 0, 100, {});
+  if (frames.size() != 3 || frames[0].fp != base + 0x180 || frames[0].pc != 0xa1 ||
+      frames[2].fp != base + 0x300 || frames[2].pc != 0xa3) {
+    printf("***ERROR***: walked %zu frames rather than 3\n", frames.size());
+    return false;
+  }
+  if (WalkFramePointers(stack.GetReader(), base + 0x100, base + 0x200, 100, {}).size() != 1 ||
+      WalkFramePointers(stack.GetReader(), base + 0x100, 0, 2, {}).size() != 2) {
+    printf("***ERROR***: walk didn't stop at the stack end or frame limit\n");
+    return false;
+  }
+
+  // A saved fp that points back down the stack ends the walk.
+  stack.SetFrame(base + 0x200, base + 0x100, 0xa3);
+  if (WalkFramePointers(stack.GetReader(), base + 0x100, 0, 100, {}).size() != 2) {
+    printf("***ERROR***: walk followed a frame pointer down the stack\n");
+    return false;
+  }
+  return true;
+}
+
+bool CheckWalkPastEntryFrame() {
+  FakeStack stack;
+  const uint64_t base = FakeStack::kBase;
+  const uint64_t entry_marker = GetFrameTypeMarker(1);
+  // JavaScript called into C++ at the exit frame at 0x400, which called back
+  // into JavaScript through the entry frame at 0x300. The C++ frames between
+  // them don't keep frame pointers.
+  stack.SetFrame(base + 0x100, base + 0x180, 0xa1);
+  stack.SetFrame(base + 0x180, base + 0x300, 0xa2);
+  stack.SetFrame(base + 0x300, 0x7, 0xa3);
+  stack.SetWord(base + 0x300 - 8, entry_marker);
+  stack.SetWord(base + 0x300 - 240, base + 0x400);  // The saved c_entry_fp.
+  stack.SetFrame(base + 0x400, base + 0x480, 0xa4);
+  stack.SetFrame(base + 0x480, base + 0x500, 0xa5);
+
+  std::vector<StackFrame> frames =
+      WalkFramePointers(stack.GetReader(), base + 0x100, base + 0x500, 100,
+                        {GetFrameTypeMarker(2), entry_marker});
+  if (frames.size() != 3 || frames[1].fp != base + 0x300 ||
+      frames[2].fp != base + 0x480 || frames[2].pc != 0xa4) {
+    printf("***ERROR***: walked %zu frames, not continuing from the saved exit frame\n",
+           frames.size());
+    return false;
+  }
+  if (WalkFramePointers(stack.GetReader(), base + 0x100, base + 0x500, 100, {}).size() != 2) {
+    printf("***ERROR***: walk past an unrecognized entry frame didn't stop\n");
+    return false;
+  }
+
+  // The outermost entry frame saved no exit frame.
+  stack.SetWord(base + 0x300 - 240, 0);
+  if (WalkFramePointers(stack.GetReader(), base + 0x100, 0, 100, {entry_marker}).size() != 2) {
+    printf("***ERROR***: walk didn't stop at the outermost entry frame\n");
+    return false;
+  }
+  return true;
+}
+
+bool CheckReadFrameFunction() {
+  FakeStack stack;
+  const uint64_t fp = FakeStack::kBase + 0x100;
+  const uint64_t function = 0x7ff612345679;  // Tagged, above 4 GB.
+  stack.SetFrame(fp, fp + 0x80, 0xa1);
+  stack.SetWord(fp - 8, 0x7ff600001001);  // The frame's context.
+  stack.SetWord(fp - 16, function);
+  uint64_t found = 0;
+  if (!ReadFrameFunction(stack.GetReader(), fp, &found) || found != function) {
+    printf("***ERROR***: read function 0x%llx rather than 0x%llx\n",
+           static_cast<unsigned long long>(found),
+           static_cast<unsigned long long>(function));
+    return false;
+  }
+
+  // A typed frame holds a Smi frame type marker in place of the context.
+  stack.SetWord(fp - 8, uint64_t{4} << 32);
+  if (ReadFrameFunction(stack.GetReader(), fp, &found)) {
+    printf("***ERROR***: found a function in a typed frame\n");
+    return false;
+  }
+  stack.SetWord(fp - 8, 0x7ff600001001);
+  stack.SetWord(fp - 16, uint64_t{7} << 32);
+  if (ReadFrameFunction(stack.GetReader(), fp, &found) ||
+      ReadFrameFunction(stack.GetReader(), FakeStack::kBase + 8, &found)) {
+    printf("***ERROR***: found a function in a Smi or unreadable slot\n");
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  bool ok = true;
+  if (CheckCodeRangeIndex()) {
+    printf("SUCCESS: code range index finds the code holding a pc\n");
+  } else {
+    ok = false;
+  }
+  if (CheckWalkFramePointers()) {
+    printf("SUCCESS: walked the chain of frame pointers\n");
+  } else {
+    ok = false;
+  }
+  if (CheckWalkPastEntryFrame()) {
+    printf("SUCCESS: walked from entry frames to the exit frames they saved\n");
+  } else {
+    ok = false;
+  }
+  if (CheckReadFrameFunction()) {
+    printf("SUCCESS: read the function of a JavaScript frame\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
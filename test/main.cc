@@ -152,6 +152,180 @@ void RunTests() {
     printf("SUCCESS: Oddball support\n");
   }
 
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$findstring(\"wrapper.js\").First()",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find("wrapper.js") == std::string::npos ||
+      output.log.find("address") == std::string::npos) {
+    printf(
+        "***ERROR***: 'dx @$findstring()' did not find the script name\n%s\n",
+        output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$findstring\n");
+  }
+
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$feedbackcensus(5)",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find("vectors") == std::string::npos ||
+      output.log.find("megamorphic") == std::string::npos) {
+    printf(
+        "***ERROR***: 'dx @$feedbackcensus()' did not return IC counts\n%s\n",
+        output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$feedbackcensus\n");
+  }
+
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$codecensus(5)",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find("interpreted") == std::string::npos ||
+      output.log.find("code_bytes") == std::string::npos) {
+    printf(
+        "***ERROR***: 'dx @$codecensus()' did not return code counts\n%s\n",
+        output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$codecensus\n");
+  }
+
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$maptransitions(5)",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find("transitions") == std::string::npos ||
+      output.log.find("deepest_trees") == std::string::npos) {
+    printf(
+        "***ERROR***: 'dx @$maptransitions()' did not return a forest\n%s\n",
+        output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$maptransitions\n");
+  }
+
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$fragmentation().spaces",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find("OLD_SPACE") == std::string::npos) {
+    printf(
+        "***ERROR***: 'dx @$fragmentation()' did not report old space\n%s\n",
+        output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$fragmentation\n");
+  }
+
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$largest(3, \"FixedArray\")",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find("v8::internal::FixedArray") == std::string::npos ||
+      output.log.find("size") == std::string::npos) {
+    printf(
+        "***ERROR***: 'dx @$largest()' did not find large arrays\n%s\n",
+        output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$largest\n");
+  }
+
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$contextretention(5)",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find("contexts") == std::string::npos ||
+      output.log.find("top_closures") == std::string::npos) {
+    printf(
+        "***ERROR***: 'dx @$contextretention()' did not rank closures\n%s\n",
+        output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$contextretention\n");
+  }
+
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$globalhandles().census()",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find("handles") == std::string::npos ||
+      output.log.find("by_type") == std::string::npos) {
+    printf(
+        "***ERROR***: 'dx @$globalhandles().census()' did not count handles\n%s\n",
+        output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$globalhandles\n");
+  }
+
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$handlescopes()",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find("handles") == std::string::npos ||
+      output.log.find("block_list") == std::string::npos) {
+    printf(
+        "***ERROR***: 'dx @$handlescopes()' did not list handle blocks\n%s\n",
+        output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$handlescopes\n");
+  }
+
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$jsstack()",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find("javascript") == std::string::npos ||
+      output.log.find("script") == std::string::npos) {
+    printf(
+        "***ERROR***: 'dx @$jsstack()' did not find JavaScript frames\n%s\n",
+        output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$jsstack\n");
+  }
+
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$exportobjects(\"v8dbg-objects.bin\")",
+                              DEBUG_EXECUTE_ECHO);
+  FILE* p_table = fopen("v8dbg-objects.bin", "rb");
+  if (FAILED(hr) || p_table == nullptr ||
+      output.log.find("Error") != std::string::npos) {
+    printf("***ERROR***: '@$exportobjects' did not write a table\n%s\n",
+           output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$exportobjects\n");
+  }
+  if (p_table != nullptr) fclose(p_table);
+  remove("v8dbg-objects.bin");
+
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$heapstats(0.5)",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find("bytes_margin") == std::string::npos ||
+      output.log.find("by_type") == std::string::npos) {
+    printf(
+        "***ERROR***: 'dx @$heapstats(0.5)' did not estimate the heap\n%s\n",
+        output.log.c_str());
+  } else {
+    printf("SUCCESS: Function alias @$heapstats\n");
+  }
+
+  // Nothing has run since the last query, so every chunk should be reused.
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$heapstats(1).walked_chunks",
+                              DEBUG_EXECUTE_ECHO);
+  output.log.clear();
+  hr = p_debug_control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
+                              "dx @$heapstats(1).walked_chunks",
+                              DEBUG_EXECUTE_ECHO);
+  if (output.log.find(": 0x0") == std::string::npos &&
+      output.log.find(": 0\n") == std::string::npos) {
+    printf("***ERROR***: '@$heapstats' walked unchanged chunks again\n%s\n",
+           output.log.c_str());
+  } else {
+    printf("SUCCESS: @$heapstats reuses unchanged chunks\n");
+  }
+
   printf("=== Run completed! ===\n");
   // Detach before exiting
   hr = p_client->DetachProcesses();
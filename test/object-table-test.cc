@@ -0,0 +1,163 @@
+#include "../src/object-table.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+struct TestObject {
+  uint64_t address;
+  uint64_t map;
+  uint16_t instance_type;
+  uint64_t size;
+};
+
+// Objects spread over two chunks in different spaces, with enough rows to
+// fill more than one block.
+std::vector<TestObject> MakeObjects(size_t count) {
+  std::vector<TestObject> objects;
+  uint64_t address = 0x20000040000;
+  for (size_t i = 0; i < count; ++i) {
+    if (i == count / 2) address = 0x10000040000;  // Chunks aren't in order.
+    uint16_t instance_type = static_cast<uint16_t>(i % 7);
+    uint64_t size = 16 + (i % 5) * 8;
+    objects.push_back({address, 0x3000000 + uint64_t{instance_type} * 0x28, instance_type, size});
+    address += size;
+  }
+  return objects;
+}
+
+bool CheckRoundTrip() {
+  FILE* file = tmpfile();
+  if (file == nullptr) {
+    printf("***ERROR***: couldn't create a temporary file\n");
+    return false;
+  }
+  size_t count = kObjectTableBlockRows * 2 + 100;
+  std::vector<TestObject> objects = MakeObjects(count);
+  ObjectTableWriter writer(file);
+  writer.SetTypeName(3, "v8::internal::JSObject");
+  for (size_t i = 0; i < count; ++i) {
+    if (i == 0) writer.BeginChunk(0x20000000000, "OLD_SPACE");
+    if (i == count / 2) writer.BeginChunk(0x10000000000, "NEW_SPACE");
+    const TestObject& object = objects[i];
+    writer.Add(object.address, object.map, object.instance_type, object.size);
+  }
+  bool ok = writer.Finish() && writer.row_count() == count;
+
+  ObjectTableReader reader(file);
+  if (!ok || !reader.Open() || reader.row_count() != count ||
+      reader.block_count() != 3 || reader.chunks().size() != 2 ||
+      reader.spaces()[reader.chunks()[1].space] != "NEW_SPACE" ||
+      reader.GetTypeName(3) != "v8::internal::JSObject" ||
+      !reader.GetTypeName(4).empty()) {
+    printf("***ERROR***: object table dictionaries didn't round trip\n");
+    fclose(file);
+    return false;
+  }
+  size_t next = 0;
+  std::vector<ObjectRow> rows;
+  for (size_t block = 0; ok && block < reader.block_count(); ++block) {
+    ok = reader.ReadBlock(block, &rows);
+    for (const ObjectRow& row : rows) {
+      const TestObject& object = objects[next];
+      uint32_t chunk = next < count / 2 ? 0 : 1;
+      if (row.address != object.address || row.map != object.map ||
+          row.instance_type != object.instance_type || row.size != object.size ||
+          row.chunk != chunk) {
+        ok = false;
+        break;
+      }
+      ++next;
+    }
+  }
+  fclose(file);
+  if (!ok || next != count) {
+    printf("***ERROR***: object table rows didn't round trip\n");
+    return false;
+  }
+  return true;
+}
+
+bool CheckRejectsTruncatedFile() {
+  FILE* file = tmpfile();
+  if (file == nullptr) return false;
+  ObjectTableWriter writer(file);
+  writer.BeginChunk(0x1000, "OLD_SPACE");
+  writer.Add(0x1000, 0x2000, 1, 32);
+  bool ok = writer.Finish();
+  std::vector<char> bytes(4096);
+  rewind(file);
+  size_t size = fread(bytes.data(), 1, bytes.size(), file);
+  fclose(file);
+
+  // The same table without its last byte.
+  file = tmpfile();
+  if (file == nullptr) return false;
+  ok = ok && size > 0 && fwrite(bytes.data(), 1, size - 1, file) == size - 1;
+  ObjectTableReader reader(file);
+  if (!ok || reader.Open()) {
+    printf("***ERROR***: truncated object table was opened\n");
+    fclose(file);
+    return false;
+  }
+  fclose(file);
+  return true;
+}
+
+bool CheckRejectsBadRowCount() {
+  FILE* file = tmpfile();
+  if (file == nullptr) return false;
+  ObjectTableWriter writer(file);
+  writer.BeginChunk(0x1000, "OLD_SPACE");
+  writer.Add(0x1000, 0x2000, 1, 32);
+  bool ok = writer.Finish();
+  std::vector<char> bytes(4096);
+  rewind(file);
+  size_t size = fread(bytes.data(), 1, bytes.size(), file);
+  fclose(file);
+
+  // The last block's row count is the footer's last varint, before the 8 byte
+  // footer offset and the 8 byte magic. Make it far more than the block holds.
+  const size_t kTrailer = 16;
+  ok = ok && size > kTrailer + 1 && bytes[size - kTrailer - 1] == 1;
+  if (!ok) return false;
+  std::vector<char> corrupt(bytes.begin(), bytes.begin() + (size - kTrailer - 1));
+  for (int i = 0; i < 8; ++i) corrupt.push_back(static_cast<char>(0xff));
+  corrupt.push_back(0x0f);
+  corrupt.insert(corrupt.end(), bytes.begin() + (size - kTrailer), bytes.begin() + size);
+
+  file = tmpfile();
+  if (file == nullptr) return false;
+  ok = fwrite(corrupt.data(), 1, corrupt.size(), file) == corrupt.size();
+  ObjectTableReader reader(file);
+  if (!ok || reader.Open()) {
+    printf("***ERROR***: object table with a bad row count was opened\n");
+    fclose(file);
+    return false;
+  }
+  fclose(file);
+  return true;
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+  if (CheckRoundTrip()) {
+    printf("SUCCESS: object table round trips\n");
+  } else {
+    ok = false;
+  }
+  if (CheckRejectsTruncatedFile()) {
+    printf("SUCCESS: truncated object table is rejected\n");
+  } else {
+    ok = false;
+  }
+  if (CheckRejectsBadRowCount()) {
+    printf("SUCCESS: object table with a bad row count is rejected\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
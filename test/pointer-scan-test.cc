@@ -0,0 +1,138 @@
+#include "../src/pointer-scan.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// The obvious version: look at every aligned value.
+std::vector<PointerSlot> FindSlotsSlowly(const std::vector<uint8_t>& data,
+                                         uint64_t base,
+                                         const PointerTarget& target) {
+  std::vector<PointerSlot> slots;
+  for (uint64_t address = (base + 3) & ~uint64_t{3};
+       address + 4 <= base + data.size(); address += 4) {
+    size_t offset = static_cast<size_t>(address - base);
+    uint64_t full = 0;
+    if (address % 8 == 0 && offset + 8 <= data.size()) {
+      memcpy(&full, data.data() + offset, 8);
+      if (full == target.tagged_ptr) {
+        slots.push_back({address, false});
+        address += 4;
+        continue;
+      }
+    }
+    uint32_t value;
+    memcpy(&value, data.data() + offset, 4);
+    if (target.compressed && value == static_cast<uint32_t>(target.tagged_ptr)) {
+      slots.push_back({address, true});
+    }
+  }
+  return slots;
+}
+
+bool SameSlots(const std::vector<PointerSlot>& a, const std::vector<PointerSlot>& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].address != b[i].address || a[i].compressed != b[i].compressed) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Random bytes with the target planted in both forms at random places,
+// including straddling the 64 byte blocks and the end of the buffer.
+std::vector<uint8_t> MakeData(std::mt19937& rng, size_t size, uint64_t base,
+                              uint64_t tagged_ptr) {
+  std::vector<uint8_t> data(size);
+  for (uint8_t& byte : data) byte = static_cast<uint8_t>(rng() % 4);
+  for (int i = 0; i < 20 && size >= 8; ++i) {
+    size_t offset = 8 + rng() % (size - 7);
+    if (rng() % 2 == 0) {
+      offset -= (base + offset) % 8;
+      if (offset + 8 <= size) memcpy(data.data() + offset, &tagged_ptr, 8);
+    } else {
+      offset -= (base + offset) % 4;
+      if (offset + 4 <= size) memcpy(data.data() + offset, &tagged_ptr, 4);
+    }
+  }
+  return data;
+}
+
+bool CheckFindPointerSlots(std::mt19937& rng) {
+  const uint64_t tagged_ptr = 0x00001234'02030001;
+  for (size_t size = 0; size < 300; ++size) {
+    for (uint64_t base = 0x10000; base < 0x10008; ++base) {
+      for (bool compressed : {false, true}) {
+        std::vector<uint8_t> data = MakeData(rng, size, base, tagged_ptr);
+        PointerTarget target{tagged_ptr, compressed};
+        std::vector<PointerSlot> slots;
+        FindPointerSlots(data.data(), data.size(), base, target, &slots);
+        if (!SameSlots(slots, FindSlotsSlowly(data, base, target))) {
+          printf("***ERROR***: FindPointerSlots mismatch (size %zu, base %llx)\n",
+                 size, static_cast<unsigned long long>(base));
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool CheckScanForPointer(std::mt19937& rng) {
+  const uint64_t tagged_ptr = 0x00001234'02030001;
+  const uint64_t base = 0x200000;
+  std::vector<uint8_t> memory = MakeData(rng, 5 * 1024 * 1024 + 40, base, tagged_ptr);
+  const uint64_t unreadable = base + 3 * 1024 * 1024;
+  MemReader reader = [&](uint64_t address, size_t size, uint8_t* buffer) {
+    if (address < base || address + size > base + memory.size() ||
+        (address <= unreadable && unreadable < address + size)) {
+      return false;
+    }
+    memcpy(buffer, memory.data() + (address - base), size);
+    return true;
+  };
+
+  std::vector<MemoryRange> ranges{{base + 2 * 1024 * 1024, base + memory.size()},
+                                  {base, base + 1024 * 1024 + 8}};
+  // The block holding the unreadable address is read again a page at a time,
+  // so only that page is lost.
+  const uint64_t mb = 1024 * 1024;
+  std::vector<MemoryRange> readable{{base, base + mb + 8},
+                                    {base + 2 * mb, base + 3 * mb},
+                                    {base + 3 * mb + 4096, base + memory.size()}};
+  PointerTarget target{tagged_ptr, true};
+  std::vector<PointerSlot> expected;
+  for (const MemoryRange& range : readable) {
+    std::vector<uint8_t> part(memory.begin() + (range.start - base),
+                              memory.begin() + (range.end - base));
+    for (const PointerSlot& slot : FindSlotsSlowly(part, range.start, target)) {
+      expected.push_back(slot);
+    }
+  }
+
+  for (unsigned threads : {1u, 4u}) {
+    if (!SameSlots(ScanForPointer(ranges, reader, target, threads), expected)) {
+      printf("***ERROR***: ScanForPointer mismatch with %u threads\n", threads);
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  std::mt19937 rng(4321);
+  bool ok = true;
+  if (CheckFindPointerSlots(rng)) {
+    printf("SUCCESS: FindPointerSlots matches a slot by slot scan\n");
+  } else {
+    ok = false;
+  }
+  if (CheckScanForPointer(rng)) {
+    printf("SUCCESS: ScanForPointer skips only unreadable pages\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include "../src/stats.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+bool CheckThreadTotals() {
+  ResetStats();
+  // More threads than there are slots, so that some share one. Each thread
+  // exits before the totals are read, so its counts must survive that too.
+  const unsigned kThreads = 40;
+  const uint64_t kIncrements = 10000;
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < kThreads; ++i) {
+    threads.emplace_back([] {
+      for (uint64_t j = 0; j < kIncrements; ++j) {
+        IncrementCounter(Counter::kMemoryReads);
+        IncrementCounter(Counter::kBytesRead, 8);
+      }
+      RecordLatency(Timer::kMemoryRead, 100);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  // Slots released by exited threads are reused.
+  std::thread([] { IncrementCounter(Counter::kMemoryReads); }).join();
+
+  StatsSnapshot snapshot = GetStatsSnapshot();
+  uint64_t reads = snapshot.counters[static_cast<size_t>(Counter::kMemoryReads)];
+  uint64_t bytes = snapshot.counters[static_cast<size_t>(Counter::kBytesRead)];
+  const LatencyStats& latency = snapshot.timers[static_cast<size_t>(Timer::kMemoryRead)];
+  if (reads != kThreads * kIncrements + 1 || bytes != kThreads * kIncrements * 8 ||
+      latency.count != kThreads || latency.total_ns != kThreads * 100) {
+    printf("***ERROR***: wrong totals after %u threads (%llu reads)\n", kThreads,
+           static_cast<unsigned long long>(reads));
+    return false;
+  }
+  return true;
+}
+
+bool CheckLatencyBuckets() {
+  ResetStats();
+  RecordLatency(Timer::kTypeLookup, 0);
+  RecordLatency(Timer::kTypeLookup, 1);
+  RecordLatency(Timer::kTypeLookup, 1000);
+  RecordLatency(Timer::kTypeLookup, 1023);
+  RecordLatency(Timer::kTypeLookup, 1024);
+  RecordLatency(Timer::kTypeLookup, ~uint64_t{0});
+  {
+    ScopedLatency scoped(Timer::kChunkList);
+  }
+
+  StatsSnapshot snapshot = GetStatsSnapshot();
+  const LatencyStats& latency = snapshot.timers[static_cast<size_t>(Timer::kTypeLookup)];
+  // Bucket i holds values below 2^i, so 1023 goes in bucket 10 and 1024 in 11.
+  if (latency.count != 6 || latency.buckets[0] != 1 || latency.buckets[1] != 1 ||
+      latency.buckets[10] != 2 || latency.buckets[11] != 1 ||
+      latency.buckets[kLatencyBuckets - 1] != 1 ||
+      snapshot.timers[static_cast<size_t>(Timer::kChunkList)].count != 1) {
+    printf("***ERROR***: latencies in the wrong buckets\n");
+    return false;
+  }
+
+  ResetStats();
+  snapshot = GetStatsSnapshot();
+  if (snapshot.timers[static_cast<size_t>(Timer::kTypeLookup)].count != 0 ||
+      snapshot.counters[static_cast<size_t>(Counter::kMemoryReads)] != 0) {
+    printf("***ERROR***: ResetStats left counts behind\n");
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  bool ok = true;
+  if (CheckThreadTotals()) {
+    printf("SUCCESS: counters from all threads are summed\n");
+  } else {
+    ok = false;
+  }
+  if (CheckLatencyBuckets()) {
+    printf("SUCCESS: latencies are bucketed by power of two\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
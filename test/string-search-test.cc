@@ -0,0 +1,108 @@
+#include "../src/string-search.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <type_traits>
+
+size_t Find(const SubstringMatcher& matcher, const std::string& text) {
+  return matcher.Find(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+size_t Find(const SubstringMatcher& matcher, const std::u16string& text) {
+  return matcher.Find(text.data(), text.size());
+}
+
+// Compares SubstringMatcher against std::basic_string::find on random text
+// over small alphabets, so that partial matches are common, at every length
+// and alignment around the 16 byte blocks.
+template <typename Char>
+bool CheckRandomText(std::mt19937& rng, Char max_char) {
+  std::uniform_int_distribution<int> char_dist('a', 'a' + 3);
+  for (size_t text_length = 0; text_length < 80; ++text_length) {
+    for (int trial = 0; trial < 50; ++trial) {
+      std::basic_string<Char> text;
+      for (size_t i = 0; i < text_length; ++i) {
+        text.push_back(static_cast<Char>(char_dist(rng)));
+      }
+      if (text_length > 0 && trial % 5 == 0) text[text_length / 2] = max_char;
+      for (size_t needle_length = 1; needle_length < 20; ++needle_length) {
+        std::u16string needle;
+        for (size_t i = 0; i < needle_length; ++i) {
+          needle.push_back(static_cast<char16_t>(char_dist(rng)));
+        }
+        // Sometimes take the needle from the text, so there's a match.
+        if (trial % 2 == 0 && needle_length <= text_length) {
+          size_t start = rng() % (text_length - needle_length + 1);
+          needle.clear();
+          for (size_t i = start; i < start + needle_length; ++i) {
+            needle.push_back(static_cast<std::make_unsigned_t<Char>>(text[i]));
+          }
+        }
+        std::basic_string<Char> narrow_needle(needle.begin(), needle.end());
+        size_t expected = text.find(narrow_needle);
+        if (expected == std::basic_string<Char>::npos) {
+          expected = SubstringMatcher::npos;
+        }
+        size_t actual = Find(SubstringMatcher(needle), text);
+        if (actual != expected) {
+          printf("***ERROR***: found %zu instead of %zu (text length %zu, "
+                 "needle length %zu)\n", actual, expected, text_length,
+                 needle_length);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool CheckEncodings() {
+  std::u16string two_byte = u"prefix Āā https://example.com/leak";
+  std::string one_byte = "prefix \xE9 https://example.com/leak";
+
+  // Latin-1 needles are found in both encodings.
+  SubstringMatcher url(u"example.com");
+  if (Find(url, two_byte) != 18 || Find(url, one_byte) != 17) {
+    printf("***ERROR***: Latin-1 needle not found in both encodings\n");
+    return false;
+  }
+  SubstringMatcher latin1(u"é h");
+  if (Find(latin1, one_byte) != 7) {
+    printf("***ERROR***: non-ASCII Latin-1 needle not found\n");
+    return false;
+  }
+
+  // A needle that needs two bytes can't be in a one-byte string.
+  SubstringMatcher wide(u"Āā");
+  if (Find(wide, two_byte) != 7 ||
+      Find(wide, one_byte) != SubstringMatcher::npos) {
+    printf("***ERROR***: two-byte needle handled incorrectly\n");
+    return false;
+  }
+
+  // 0xC4 0x80 in one-byte text mustn't match U+0100 through a wrong cast.
+  std::string bytes("\xC4\x80\x00\x01", 4);
+  if (Find(wide, bytes) != SubstringMatcher::npos) {
+    printf("***ERROR***: two-byte needle matched one-byte text\n");
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  std::mt19937 rng(12345);
+  bool ok = true;
+  if (CheckRandomText<char>(rng, '\xFF') &&
+      CheckRandomText<char16_t>(rng, 0xFFFF)) {
+    printf("SUCCESS: SubstringMatcher agrees with std::string::find\n");
+  } else {
+    ok = false;
+  }
+  if (CheckEncodings()) {
+    printf("SUCCESS: SubstringMatcher encodings\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
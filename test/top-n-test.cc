@@ -0,0 +1,82 @@
+#include "../src/top-n.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+bool CheckKeepsGreatest() {
+  std::mt19937 random(42);
+  std::vector<int> values(10000);
+  for (int& value : values) value = static_cast<int>(random() % 100000);
+
+  BoundedTopN<int> top(25);
+  for (int value : values) top.Push(value);
+  std::vector<int> expected = values;
+  std::sort(expected.begin(), expected.end(), std::greater<int>());
+  expected.resize(25);
+  if (top.Take() != expected) {
+    printf("***ERROR***: selection doesn't hold the greatest values in order\n");
+    return false;
+  }
+  return true;
+}
+
+bool CheckFewerThanCount() {
+  BoundedTopN<int> top(5);
+  for (int value : {3, 9, 1}) top.Push(value);
+  if (top.full() || top.least() != 1 || top.Take() != std::vector<int>{9, 3, 1}) {
+    printf("***ERROR***: selection of fewer values than its count is wrong\n");
+    return false;
+  }
+  BoundedTopN<int> none(0);
+  if (!none.full() || !none.empty()) {
+    printf("***ERROR***: selection of count 0 isn't full and empty\n");
+    return false;
+  }
+  none.Push(1);
+  if (!none.empty() || !none.Take().empty()) {
+    printf("***ERROR***: empty selection kept a value\n");
+    return false;
+  }
+  return true;
+}
+
+bool CheckCustomOrder() {
+  struct Object {
+    unsigned size;
+    unsigned id;
+  };
+  auto smaller = [](const Object& a, const Object& b) { return a.size < b.size; };
+  BoundedTopN<Object, decltype(smaller)> top(2, smaller);
+  for (unsigned i = 0; i < 100; ++i) top.Push({(i * 37) % 100, i});
+  if (!top.full() || top.least().size != 98) {
+    printf("***ERROR***: least value is %u rather than 98\n", top.least().size);
+    return false;
+  }
+  std::vector<Object> largest = top.Take();
+  if (largest[0].size != 99 || largest[0].id != 27 || largest[1].size != 98) {
+    printf("***ERROR***: custom order selected the wrong objects\n");
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  bool ok = true;
+  if (CheckKeepsGreatest()) {
+    printf("SUCCESS: selection keeps the greatest values\n");
+  } else {
+    ok = false;
+  }
+  if (CheckFewerThanCount()) {
+    printf("SUCCESS: selection holds fewer values than its count\n");
+  } else {
+    ok = false;
+  }
+  if (CheckCustomOrder()) {
+    printf("SUCCESS: selection uses a custom order\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+#include "../src/trace.h"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+size_t CountOccurrences(const std::string& text, const std::string& pattern) {
+  size_t count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+bool CheckSpans() {
+  StopTracing();
+  { ScopedTrace ignored("Ignored"); }
+
+  StartTracing();
+  { ScopedTrace outer("Outer"); { ScopedTrace inner("Inner \"quoted\""); } }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([] {
+      for (int j = 0; j < 100; ++j) ScopedTrace span("Worker");
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  StopTracing();
+  { ScopedTrace ignored("Ignored"); }
+
+  std::string json = GetTraceJson();
+  if (GetTraceEventCount() != 402 || CountOccurrences(json, "\"ph\":\"X\"") != 402 ||
+      CountOccurrences(json, "\"name\":\"Worker\"") != 400 ||
+      json.find("\"name\":\"Inner \\\"quoted\\\"\"") == std::string::npos ||
+      json.find("Ignored") != std::string::npos ||
+      json.compare(0, 15, "{\"displayTimeUn") != 0 ||
+      json.compare(json.size() - 4, 4, "\n]}\n") != 0) {
+    printf("***ERROR***: unexpected trace:\n%s\n", json.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool CheckWraparound() {
+  StartTracing();
+  for (size_t i = 0; i < kTraceCapacity + 10; ++i) ScopedTrace span("Span");
+  StopTracing();
+  std::string json = GetTraceJson();
+  if (GetTraceEventCount() != kTraceCapacity ||
+      CountOccurrences(json, "\"ph\":\"X\"") != kTraceCapacity) {
+    printf("***ERROR***: ring buffer kept %zu events\n", GetTraceEventCount());
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  bool ok = true;
+  if (CheckSpans()) {
+    printf("SUCCESS: spans are recorded only while tracing\n");
+  } else {
+    ok = false;
+  }
+  if (CheckWraparound()) {
+    printf("SUCCESS: the ring buffer keeps the newest spans\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
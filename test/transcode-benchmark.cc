@@ -0,0 +1,63 @@
+// Throughput of the conversions in transcode.h, next to a loop that widens
+// one byte at a time.
+#include "../src/transcode.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kTotalBytes = 64 * 1024 * 1024;
+
+template <typename Convert>
+double MeasureMBPerSecond(const std::vector<std::string>& inputs, Convert convert) {
+  size_t bytes = 0;
+  size_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (bytes < kTotalBytes) {
+    for (const std::string& input : inputs) {
+      checksum += convert(input);
+      bytes += input.size();
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  if (checksum == 1) printf(" ");  // Keep the work from being optimized away.
+  return bytes / elapsed.count() / (1024 * 1024);
+}
+
+void Run(const char* label, const std::vector<std::string>& inputs) {
+  std::u16string out;
+  double byte_loop = MeasureMBPerSecond(inputs, [&](const std::string& input) {
+    out.clear();
+    for (char c : input) out.push_back(static_cast<uint8_t>(c));
+    return out.size();
+  });
+  double latin1 = MeasureMBPerSecond(inputs, [&](const std::string& input) {
+    out.resize(input.size());
+    WidenLatin1(input.data(), input.size(), out.data());
+    return out.size();
+  });
+  double utf8 = MeasureMBPerSecond(inputs, [&](const std::string& input) {
+    AssignUtf8(input, &out);
+    return out.size();
+  });
+  printf("%-28s byte loop %8.0f MB/s  WidenLatin1 %8.0f MB/s  AssignUtf8 %8.0f MB/s\n",
+         label, byte_loop, latin1, utf8);
+}
+
+}  // namespace
+
+int main() {
+  Run("field names (~16 bytes)",
+      {"properties_or_hash", "elements", "map", "length", "shared_function_info",
+       "v8::internal::JSObject", "v8::internal::FixedArrayBase"});
+  Run("ASCII briefs (~200 bytes)",
+      {std::string(200, 'x'), "<JSFunction doSomethingUseful (sfi = 0000012A34B5C678)> "
+                              "with a fairly long description following it"});
+  std::string mixed;
+  while (mixed.size() < 4096) mixed += "r\xC3\xA9sum\xC3\xA9 \xE2\x82\xAC ";
+  Run("4KB mixed UTF-8", {mixed});
+  return 0;
+}
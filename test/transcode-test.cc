@@ -0,0 +1,110 @@
+#include "../src/transcode.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+// One code point at a time, following the same rules as Utf8ToUtf16.
+std::u16string DecodeSlowly(const std::string& text) {
+  std::u16string result;
+  for (size_t i = 0; i < text.size();) {
+    uint8_t lead = static_cast<uint8_t>(text[i]);
+    size_t extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+    uint32_t code_point = extra == 3 ? lead & 0x07 : extra == 2 ? lead & 0x0F : lead & 0x1F;
+    bool valid = lead >= 0xC0 && i + extra < text.size();
+    for (size_t j = 1; valid && j <= extra; ++j) {
+      uint8_t byte = static_cast<uint8_t>(text[i + j]);
+      valid = (byte & 0xC0) == 0x80;
+      code_point = (code_point << 6) | (byte & 0x3F);
+    }
+    const uint32_t kMinimum[] = {0, 0x80, 0x800, 0x10000};
+    valid = valid && code_point >= kMinimum[extra] && code_point <= 0x10FFFF &&
+            !(code_point >= 0xD800 && code_point <= 0xDFFF);
+    if (!valid) {
+      result.push_back(lead);
+      ++i;
+    } else if (code_point >= 0x10000) {
+      result.push_back(static_cast<char16_t>(0xD800 + ((code_point - 0x10000) >> 10)));
+      result.push_back(static_cast<char16_t>(0xDC00 + ((code_point - 0x10000) & 0x3FF)));
+      i += extra + 1;
+    } else {
+      result.push_back(static_cast<char16_t>(code_point));
+      i += extra + 1;
+    }
+  }
+  return result;
+}
+
+bool CheckKnownStrings() {
+  struct {
+    const char* utf8;
+    std::u16string expected;
+  } cases[] = {
+      {"", u""},
+      {"v8::internal::JSObject", u"v8::internal::JSObject"},
+      {"caf\xC3\xA9", u"caf\u00E9"},
+      {"\xE2\x82\xAC 5", u"\u20AC 5"},
+      {"\xF0\x9F\x98\x80", u"\U0001F600"},
+      {"caf\xE9", u"caf\u00E9"},                  // Latin-1.
+      {"\xC0\x80", u"\u00C0\u0080"},               // Overlong.
+      {"\xED\xA0\x80", u"\u00ED\u00A0\u0080"},     // Surrogate.
+      {"\xF4\x90\x80\x80", u"\u00F4\u0090\u0080\u0080"},  // Above U+10FFFF.
+      {"abc\xE2\x82", u"abc\u00E2\u0082"},         // Truncated.
+  };
+  for (const auto& test_case : cases) {
+    if (Utf8ToU16String(test_case.utf8) != test_case.expected) {
+      printf("***ERROR***: wrong decoding of \"%s\"\n", test_case.utf8);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CheckRandomStrings(std::mt19937& rng) {
+  // Mostly ASCII with some multi-byte sequences and stray bytes, so that
+  // every length of ASCII run and every position relative to 16 byte blocks
+  // is covered.
+  const char* const kPieces[] = {"\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80",
+                                 "\xE9", "\x80", "\xED\xA0\x80", "\xF0\x9F"};
+  for (int iteration = 0; iteration < 20000; ++iteration) {
+    std::string text;
+    size_t length = rng() % 100;
+    while (text.size() < length) {
+      if (rng() % 8 == 0) {
+        text += kPieces[rng() % std::size(kPieces)];
+      } else {
+        text.push_back(static_cast<char>('a' + rng() % 26));
+      }
+    }
+    if (Utf8ToU16String(text) != DecodeSlowly(text)) {
+      printf("***ERROR***: Utf8ToUtf16 mismatch on a %zu byte string\n", text.size());
+      return false;
+    }
+
+    std::u16string widened(text.size(), u'\0');
+    WidenLatin1(text.data(), text.size(), widened.data());
+    for (size_t i = 0; i < text.size(); ++i) {
+      if (widened[i] != static_cast<uint8_t>(text[i])) {
+        printf("***ERROR***: WidenLatin1 mismatch at %zu\n", i);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main() {
+  std::mt19937 rng(1234);
+  bool ok = true;
+  if (CheckKnownStrings()) {
+    printf("SUCCESS: UTF-8 and stray Latin-1 bytes are decoded\n");
+  } else {
+    ok = false;
+  }
+  if (CheckRandomStrings(rng)) {
+    printf("SUCCESS: transcoding matches a byte at a time decoder\n");
+  } else {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// Compares two object tables written by @$exportobjects, without the debugger.
+//
+//   diff-object-tables <before> <after> [count]
+//
+// Prints the change in objects and bytes of each type that changed, the maps
+// only in <after>, and its count (default 20) largest new objects.
+#include "../src/heap-diff.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+void PrintDiff(const ObjectTableReader& after, const HeapDiff& diff) {
+  printf("%" PRIu64 " new objects, %" PRIu64 " bytes\n\n", diff.new_objects,
+         diff.new_bytes);
+  printf("%14s %10s %14s %10s  type\n", "bytes", "objects", "new bytes", "new");
+  for (const TypeDelta& delta : diff.types) {
+    if (delta.count_delta() == 0 && delta.bytes_delta() == 0 && delta.new_count == 0) {
+      continue;
+    }
+    printf("%+14" PRId64 " %+10" PRId64 " %14" PRIu64 " %10" PRIu64 "  %s\n",
+           delta.bytes_delta(), delta.count_delta(), delta.new_bytes,
+           delta.new_count, delta.type.c_str());
+  }
+  printf("\n%zu new maps\n", diff.new_maps.size());
+  for (const ObjectTableMap& map : diff.new_maps) {
+    printf("  0x%" PRIx64 "  %s\n", map.address,
+           after.GetTypeLabel(map.instance_type).c_str());
+  }
+  printf("\nlargest new objects\n");
+  for (const ObjectRow& row : diff.largest_new_objects) {
+    printf("  0x%" PRIx64 " %10" PRIu64 "  %s\n", row.address, row.size,
+           after.GetTypeLabel(row.instance_type).c_str());
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3 && argc != 4) {
+    fprintf(stderr, "usage: %s <before> <after> [count]\n", argv[0]);
+    return 2;
+  }
+  size_t count = argc == 4 ? strtoul(argv[3], nullptr, 10) : 20;
+  FILE* before_file = fopen(argv[1], "rb");
+  FILE* after_file = fopen(argv[2], "rb");
+  if (before_file == nullptr || after_file == nullptr) {
+    fprintf(stderr, "can't open %s\n", before_file == nullptr ? argv[1] : argv[2]);
+    if (before_file != nullptr) fclose(before_file);
+    if (after_file != nullptr) fclose(after_file);
+    return 1;
+  }
+  ObjectTableReader before(before_file), after(after_file);
+  HeapDiff diff;
+  bool ok = before.Open() && after.Open() &&
+            DiffObjectTables(before, after, count, &diff);
+  if (ok) PrintDiff(after, diff);
+  fclose(before_file);
+  fclose(after_file);
+  if (!ok) {
+    fprintf(stderr, "couldn't read both object tables\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,86 @@
+// Reads an object table written by @$exportobjects, without the debugger.
+//
+//   dump-object-table <file>        objects and bytes by type, largest first
+//   dump-object-table <file> --csv  every object as a row of CSV
+#include "../src/object-table.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TypeTotal {
+  std::string name;
+  uint64_t count = 0;
+  uint64_t bytes = 0;
+};
+
+bool PrintCsv(ObjectTableReader& reader) {
+  printf("address,type,size,map,space,chunk\n");
+  std::vector<ObjectRow> rows;
+  for (size_t block = 0; block < reader.block_count(); ++block) {
+    if (!reader.ReadBlock(block, &rows)) return false;
+    for (const ObjectRow& row : rows) {
+      const ObjectTableChunk& chunk = reader.chunks()[row.chunk];
+      printf("0x%" PRIx64 ",%s,%" PRIu64 ",0x%" PRIx64 ",%s,%" PRIu32 "\n",
+             row.address, reader.GetTypeLabel(row.instance_type).c_str(),
+             row.size, row.map, reader.spaces()[chunk.space].c_str(), row.chunk);
+    }
+  }
+  return true;
+}
+
+bool PrintSummary(ObjectTableReader& reader) {
+  std::map<uint16_t, TypeTotal> totals;
+  std::vector<ObjectRow> rows;
+  for (size_t block = 0; block < reader.block_count(); ++block) {
+    if (!reader.ReadBlock(block, &rows)) return false;
+    for (const ObjectRow& row : rows) {
+      TypeTotal& total = totals[row.instance_type];
+      ++total.count;
+      total.bytes += row.size;
+    }
+  }
+  std::vector<TypeTotal> sorted;
+  for (auto& [instance_type, total] : totals) {
+    total.name = reader.GetTypeLabel(instance_type);
+    sorted.push_back(std::move(total));
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const TypeTotal& a, const TypeTotal& b) { return a.bytes > b.bytes; });
+  printf("%" PRIu64 " objects in %zu chunks\n", reader.row_count(),
+         reader.chunks().size());
+  for (const TypeTotal& total : sorted) {
+    printf("%14" PRIu64 " %10" PRIu64 "  %s\n", total.bytes, total.count,
+           total.name.c_str());
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool csv = argc == 3 && strcmp(argv[2], "--csv") == 0;
+  if (argc != 2 && !csv) {
+    fprintf(stderr, "usage: %s <file> [--csv]\n", argv[0]);
+    return 2;
+  }
+  FILE* file = fopen(argv[1], "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "can't open %s\n", argv[1]);
+    return 1;
+  }
+  ObjectTableReader reader(file);
+  bool ok = reader.Open() && (csv ? PrintCsv(reader) : PrintSummary(reader));
+  fclose(file);
+  if (!ok) {
+    fprintf(stderr, "%s isn't a complete object table\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
@@ -1,4 +1,5 @@
 #include "utilities.h"
+#include <algorithm>
 
 HRESULT CreateProperty(IDataModelManager* p_manager,
                        IModelPropertyAccessor* p_property,
@@ -27,6 +28,35 @@ HRESULT CreateULong64(ULONG64 value, IModelObject** pp_int) {
   return hr;
 }
 
+HRESULT SetULong64Key(IModelObject* p_object, const wchar_t* key, ULONG64 value) {
+  winrt::com_ptr<IModelObject> sp_value;
+  HRESULT hr = CreateULong64(value, sp_value.put());
+  if (FAILED(hr)) return hr;
+  return p_object->SetKey(key, sp_value.get(), nullptr);
+}
+
+HRESULT SetStringKey(IModelObject* p_object, const wchar_t* key,
+                     const std::wstring& value) {
+  winrt::com_ptr<IModelObject> sp_value;
+  HRESULT hr = CreateString(
+      std::u16string(reinterpret_cast<const char16_t*>(value.c_str()), value.size()),
+      sp_value.put());
+  if (FAILED(hr)) return hr;
+  return p_object->SetKey(key, sp_value.get(), nullptr);
+}
+
+HRESULT SetMethodKey(IModelObject* p_object, const wchar_t* key,
+                     winrt::com_ptr<IModelMethod> sp_method) {
+  VARIANT vt_method;
+  vt_method.vt = VT_UNKNOWN;
+  vt_method.punkVal = sp_method.get();
+  winrt::com_ptr<IModelObject> sp_value;
+  HRESULT hr = sp_data_model_manager->CreateIntrinsicObject(ObjectMethod, &vt_method,
+                                                            sp_value.put());
+  if (FAILED(hr)) return hr;
+  return p_object->SetKey(key, sp_value.get(), nullptr);
+}
+
 HRESULT CreateInt32(int value, IModelObject** pp_int) {
   HRESULT hr = S_OK;
   *pp_int = nullptr;
@@ -108,20 +138,26 @@ bool GetModelAtIndex(winrt::com_ptr<IModelObject>& sp_parent,
   return SUCCEEDED(hr);
 }
 
-bool GetCurrentThread(winrt::com_ptr<IDebugHostContext>& sp_host_context,
-                      IModelObject** p_current_thread) {
-  HRESULT hr = S_OK;
-  winrt::com_ptr<IModelObject> sp_boxed_context, sp_root_namespace;
-  winrt::com_ptr<IModelObject> sp_debugger, sp_sessions, sp_processes, sp_threads;
-  winrt::com_ptr<IModelObject> sp_curr_session, sp_curr_process, sp_curr_thread;
-
-  // Get the current context boxed as an IModelObject
+// Boxes the context as an IModelObject, for indexing the Sessions, Processes
+// and Threads collections.
+static bool BoxContext(winrt::com_ptr<IDebugHostContext>& sp_host_context,
+                       IModelObject** p_boxed_context) {
   VARIANT vt_context;
   vt_context.vt = VT_UNKNOWN;
   vt_context.punkVal = sp_host_context.get();
-  hr = sp_data_model_manager->CreateIntrinsicObject(ObjectContext, &vt_context,
-                                                 sp_boxed_context.put());
-  if (FAILED(hr)) return false;
+  HRESULT hr = sp_data_model_manager->CreateIntrinsicObject(
+      ObjectContext, &vt_context, p_boxed_context);
+  return SUCCEEDED(hr);
+}
+
+bool GetCurrentProcess(winrt::com_ptr<IDebugHostContext>& sp_host_context,
+                       IModelObject** p_current_process) {
+  HRESULT hr = S_OK;
+  winrt::com_ptr<IModelObject> sp_boxed_context, sp_root_namespace;
+  winrt::com_ptr<IModelObject> sp_debugger, sp_sessions, sp_processes;
+  winrt::com_ptr<IModelObject> sp_curr_session, sp_curr_process;
+
+  if (!BoxContext(sp_host_context, sp_boxed_context.put())) return false;
 
   hr = sp_data_model_manager->GetRootNamespace(sp_root_namespace.put());
   if (FAILED(hr)) return false;
@@ -138,6 +174,19 @@ bool GetCurrentThread(winrt::com_ptr<IDebugHostContext>& sp_host_context,
   if (!GetModelAtIndex(sp_processes, sp_boxed_context, sp_curr_process.put())) {
     return false;
   }
+  *p_current_process = sp_curr_process.detach();
+  return true;
+}
+
+bool GetCurrentThread(winrt::com_ptr<IDebugHostContext>& sp_host_context,
+                      IModelObject** p_current_thread) {
+  HRESULT hr = S_OK;
+  winrt::com_ptr<IModelObject> sp_boxed_context, sp_curr_process;
+  winrt::com_ptr<IModelObject> sp_threads, sp_curr_thread;
+
+  if (!BoxContext(sp_host_context, sp_boxed_context.put())) return false;
+  if (!GetCurrentProcess(sp_host_context, sp_curr_process.put())) return false;
+
 
   hr = sp_curr_process->GetKeyValue(L"Threads", sp_threads.put(), nullptr);
   if (!GetModelAtIndex(sp_threads, sp_boxed_context, sp_curr_thread.put())) {
@@ -146,3 +195,155 @@ bool GetCurrentThread(winrt::com_ptr<IDebugHostContext>& sp_host_context,
   *p_current_thread = sp_curr_thread.detach();
   return true;
 }
+
+HRESULT GetFieldValue(winrt::com_ptr<IModelObject>& sp_object,
+                      const wchar_t* field_name, ULONG64* p_value) {
+  winrt::com_ptr<IModelObject> sp_field;
+  HRESULT hr = sp_object->GetRawValue(SymbolField, field_name, RawSearchNone,
+                                      sp_field.put());
+  if (FAILED(hr)) return hr;
+  VARIANT vt_value;
+  hr = sp_field->GetIntrinsicValueAs(VT_UI8, &vt_value);
+  if (FAILED(hr)) return hr;
+  *p_value = vt_value.ullVal;
+  return S_OK;
+}
+
+bool GetFieldOffset(winrt::com_ptr<IDebugHostType>& sp_type,
+                    const wchar_t* field_name, ULONG64* p_offset) {
+  winrt::com_ptr<IDebugHostSymbolEnumerator> sp_enum;
+  winrt::com_ptr<IDebugHostSymbol> sp_symbol;
+  if (SUCCEEDED(sp_type->EnumerateChildren(SymbolField, field_name, sp_enum.put())) &&
+      sp_enum->GetNext(sp_symbol.put()) == S_OK) {
+    winrt::com_ptr<IDebugHostField> sp_field;
+    LocationKind location_kind;
+    if (sp_symbol.try_as(sp_field) &&
+        SUCCEEDED(sp_field->GetLocationKind(&location_kind)) &&
+        location_kind == LocationMember) {
+      return SUCCEEDED(sp_field->GetOffset(p_offset));
+    }
+    return false;
+  }
+
+  // Not a direct member, so look through the base classes.
+  sp_enum = nullptr;
+  if (FAILED(sp_type->EnumerateChildren(SymbolBaseClass, nullptr, sp_enum.put()))) {
+    return false;
+  }
+  winrt::com_ptr<IDebugHostSymbol> sp_base;
+  while (sp_enum->GetNext(sp_base.put()) == S_OK) {
+    winrt::com_ptr<IDebugHostBaseClass> sp_base_class;
+    winrt::com_ptr<IDebugHostType> sp_base_type;
+    ULONG64 base_offset;
+    if (sp_base.try_as(sp_base_class) &&
+        SUCCEEDED(sp_base_class->GetOffset(&base_offset)) &&
+        SUCCEEDED(sp_base->GetType(sp_base_type.put())) &&
+        GetFieldOffset(sp_base_type, field_name, p_offset)) {
+      *p_offset += base_offset;
+      return true;
+    }
+    sp_base = nullptr;
+  }
+  return false;
+}
+
+bool GetEnumNames(winrt::com_ptr<IDebugHostType>& sp_enum_type,
+                  std::unordered_map<int64_t, std::wstring>* p_names) {
+  winrt::com_ptr<IDebugHostSymbolEnumerator> sp_enum;
+  if (FAILED(sp_enum_type->EnumerateChildren(SymbolField, nullptr, sp_enum.put()))) {
+    return false;
+  }
+  winrt::com_ptr<IDebugHostSymbol> sp_symbol;
+  while (sp_enum->GetNext(sp_symbol.put()) == S_OK) {
+    winrt::com_ptr<IDebugHostField> sp_field;
+    LocationKind location_kind;
+    VARIANT vt_value, vt_number;
+    BSTR name;
+    if (sp_symbol.try_as(sp_field) &&
+        SUCCEEDED(sp_field->GetLocationKind(&location_kind)) &&
+        location_kind == LocationConstant &&
+        SUCCEEDED(sp_field->GetValue(&vt_value))) {
+      ::VariantInit(&vt_number);
+      if (SUCCEEDED(::VariantChangeType(&vt_number, &vt_value, 0, VT_I8)) &&
+          SUCCEEDED(sp_symbol->GetName(&name))) {
+        (*p_names)[vt_number.llVal] = name;
+        ::SysFreeString(name);
+      }
+      ::VariantClear(&vt_value);
+    }
+    sp_symbol = nullptr;
+  }
+  return !p_names->empty();
+}
+
+HRESULT ModelObjectListIterator::GetNext(IModelObject** object,
+                                         ULONG64 dimensions,
+                                         IModelObject** indexers,
+                                         IKeyStore** metadata) noexcept {
+  if (position >= items->size()) return E_BOUNDS;
+  if (metadata != nullptr) *metadata = nullptr;
+  if (dimensions == 1) {
+    HRESULT hr = CreateULong64(position, indexers);
+    if (FAILED(hr)) return hr;
+  }
+  (*items)[position++].copy_to(object);
+  return S_OK;
+}
+
+HRESULT ModelObjectList::GetAt(IModelObject* context_object,
+                               ULONG64 indexer_count, IModelObject** indexers,
+                               IModelObject** object,
+                               IKeyStore** metadata) noexcept {
+  if (indexer_count != 1) return E_INVALIDARG;
+  if (metadata != nullptr) *metadata = nullptr;
+
+  VARIANT vt_index;
+  HRESULT hr = indexers[0]->GetIntrinsicValueAs(VT_UI8, &vt_index);
+  if (FAILED(hr)) return hr;
+  if (vt_index.ullVal >= items->size()) return E_BOUNDS;
+
+  (*items)[vt_index.ullVal].copy_to(object);
+  return S_OK;
+}
+
+HRESULT CreateModelObjectList(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                              ModelObjectVector items, IModelObject** pp_result) {
+  winrt::com_ptr<IModelObject> sp_result;
+  HRESULT hr = sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(),
+                                                            sp_result.put());
+  if (FAILED(hr)) return hr;
+
+  auto sp_list{winrt::make<ModelObjectList>(std::move(items))};
+  hr = sp_result->SetConcept(__uuidof(IIndexableConcept),
+                             sp_list.as<IIndexableConcept>().get(), nullptr);
+  if (FAILED(hr)) return hr;
+  hr = sp_result->SetConcept(__uuidof(IIterableConcept),
+                             sp_list.as<IIterableConcept>().get(), nullptr);
+  if (FAILED(hr)) return hr;
+
+  *pp_result = sp_result.detach();
+  return S_OK;
+}
+
+HRESULT CreateCountList(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                        const wchar_t* key,
+                        const std::map<std::wstring, uint64_t>& counts,
+                        IModelObject** pp_result) {
+  std::vector<std::pair<uint64_t, std::wstring>> sorted;
+  for (const auto& count : counts) sorted.emplace_back(count.second, count.first);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first; });
+  ModelObjectVector entries;
+  for (const auto& count : sorted) {
+    winrt::com_ptr<IModelObject> sp_entry;
+    HRESULT hr =
+        sp_data_model_manager->CreateSyntheticObject(sp_ctx.get(), sp_entry.put());
+    if (FAILED(hr)) return hr;
+    hr = SetStringKey(sp_entry.get(), key, count.second);
+    if (FAILED(hr)) return hr;
+    hr = SetULong64Key(sp_entry.get(), L"count", count.first);
+    if (FAILED(hr)) return hr;
+    entries.push_back(std::move(sp_entry));
+  }
+  return CreateModelObjectList(sp_ctx, std::move(entries), pp_result);
+}
@@ -1,6 +1,13 @@
 #pragma once
 
 #include "dbgext.h"
+#include "src/transcode.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 inline const wchar_t* U16ToWChar(const char16_t *p_u16) {
   return reinterpret_cast<const wchar_t*>(p_u16);
@@ -10,24 +17,9 @@ inline const wchar_t* U16ToWChar(std::u16string& str) {
   return U16ToWChar(str.data());
 }
 
-#if defined(WIN32)
-inline std::u16string ConvertToU16String(std::string utf8_string) {
-  int len_chars = ::MultiByteToWideChar(CP_UTF8, 0, utf8_string.c_str(), -1, nullptr, 0);
-
-  char16_t *p_buff = static_cast<char16_t*>(malloc(len_chars * sizeof(char16_t)));
-
-  // On Windows wchar_t is the same a 16char_t
-  static_assert(sizeof(wchar_t) == sizeof(char16_t));
-  len_chars = ::MultiByteToWideChar(CP_UTF8, 0, utf8_string.c_str(), -1,
-      reinterpret_cast<wchar_t*>(p_buff), len_chars);
-  std::u16string result{p_buff};
-  free(p_buff);
-
-  return result;
+inline std::u16string ConvertToU16String(std::string_view utf8_string) {
+  return Utf8ToU16String(utf8_string);
 }
-#else
-  #error String encoding conversion must be provided for the target platform.
-#endif
 
 HRESULT CreateProperty(
     IDataModelManager *p_manager,
@@ -46,9 +38,104 @@ HRESULT CreateNumber(double value, IModelObject **pp_val);
 
 HRESULT CreateString(std::u16string value, IModelObject **pp_val);
 
+// Sets key on p_object to an unsigned 64-bit value.
+HRESULT SetULong64Key(IModelObject* p_object, const wchar_t* key, ULONG64 value);
+
+// Sets key on p_object to a string.
+HRESULT SetStringKey(IModelObject* p_object, const wchar_t* key,
+                     const std::wstring& value);
+
+// Sets key on p_object to a method, which can then be called as key().
+HRESULT SetMethodKey(IModelObject* p_object, const wchar_t* key,
+                     winrt::com_ptr<IModelMethod> sp_method);
+
 bool GetModelAtIndex(winrt::com_ptr<IModelObject>& sp_parent,
                      winrt::com_ptr<IModelObject>& sp_index,
                      IModelObject **p_result);
 
 bool GetCurrentThread(winrt::com_ptr<IDebugHostContext>& sp_host_context,
                       IModelObject** p_current_thread);
+
+bool GetCurrentProcess(winrt::com_ptr<IDebugHostContext>& sp_host_context,
+                       IModelObject** p_current_process);
+
+// Reads a data member of sp_object that converts to an unsigned 64-bit
+// value, such as a pointer or size.
+HRESULT GetFieldValue(winrt::com_ptr<IModelObject>& sp_object,
+                      const wchar_t* field_name, ULONG64* p_value);
+
+// Finds the offset of a data member, searching base classes as well.
+bool GetFieldOffset(winrt::com_ptr<IDebugHostType>& sp_type,
+                    const wchar_t* field_name, ULONG64* p_offset);
+
+// Maps the values of an enum type to the names of its enumerators.
+bool GetEnumNames(winrt::com_ptr<IDebugHostType>& sp_enum_type,
+                  std::unordered_map<int64_t, std::wstring>* p_names);
+
+using ModelObjectVector = std::vector<winrt::com_ptr<IModelObject>>;
+
+struct ModelObjectListIterator
+    : winrt::implements<ModelObjectListIterator, IModelIterator> {
+  ModelObjectListIterator(std::shared_ptr<const ModelObjectVector> items)
+      : items(items) {}
+
+  HRESULT __stdcall Reset() noexcept override {
+    position = 0;
+    return S_OK;
+  }
+
+  HRESULT __stdcall GetNext(IModelObject** object, ULONG64 dimensions,
+                            IModelObject** indexers,
+                            IKeyStore** metadata) noexcept override;
+
+  std::shared_ptr<const ModelObjectVector> items;
+  size_t position = 0;
+};
+
+// A fixed list of already created model objects, exposed as a collection.
+struct ModelObjectList
+    : winrt::implements<ModelObjectList, IIndexableConcept, IIterableConcept> {
+  ModelObjectList(ModelObjectVector items)
+      : items(std::make_shared<const ModelObjectVector>(std::move(items))) {}
+
+  // IIndexableConcept members
+  HRESULT __stdcall GetDimensionality(
+      IModelObject* context_object, ULONG64* dimensionality) noexcept override {
+    *dimensionality = 1;
+    return S_OK;
+  }
+
+  HRESULT __stdcall GetAt(IModelObject* context_object, ULONG64 indexer_count,
+                          IModelObject** indexers, IModelObject** object,
+                          IKeyStore** metadata) noexcept override;
+
+  HRESULT __stdcall SetAt(IModelObject* context_object, ULONG64 indexer_count,
+                          IModelObject** indexers,
+                          IModelObject* value) noexcept override {
+    return E_NOTIMPL;
+  }
+
+  // IIterableConcept
+  HRESULT __stdcall GetDefaultIndexDimensionality(
+      IModelObject* context_object, ULONG64* dimensionality) noexcept override {
+    *dimensionality = 1;
+    return S_OK;
+  }
+
+  HRESULT __stdcall GetIterator(IModelObject* context_object,
+                                IModelIterator** iterator) noexcept override {
+    *iterator = winrt::make<ModelObjectListIterator>(items).as<IModelIterator>().detach();
+    return S_OK;
+  }
+
+  std::shared_ptr<const ModelObjectVector> items;
+};
+
+HRESULT CreateModelObjectList(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                              ModelObjectVector items, IModelObject** pp_result);
+
+// A list of {key: name, count} for each of counts, most first.
+HRESULT CreateCountList(winrt::com_ptr<IDebugHostContext>& sp_ctx,
+                        const wchar_t* key,
+                        const std::map<std::wstring, uint64_t>& counts,
+                        IModelObject** pp_result);